@@ -1,70 +1,243 @@
 #include "frt.h"
 
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include <elf.h>
+#include <sys/resource.h>
+
+#include <gflags/gflags.h>
 #include <glog/logging.h>
-#include <CL/cl2.hpp>
 
+#include "frt/bitstream.h"
+#include "frt/device_registry.h"
+#include "frt/devices/generic_opencl_device.h"
 #include "frt/devices/intel_opencl_device.h"
+#include "frt/devices/metadata_cache.h"
+#include "frt/devices/numa.h"
+#include "frt/devices/opencl_program_cache.h"
+#include "frt/devices/software_device.h"
+#include "frt/devices/startup_phase_recorder.h"
 #include "frt/devices/tapa_fast_cosim_device.h"
 #include "frt/devices/xilinx_opencl_device.h"
+#include "frt/host_buffer_pool.h"
+#include "frt/numa_placement.h"
+#include "frt/run.h"
+#include "frt/startup_phase.h"
+
+DEFINE_bool(numa_placement, true,
+            "allocate host buffers on the NUMA node of the loaded device");
 
 namespace fpga {
 
+namespace {
+
+// In-tree backends are registered here instead of with `FRT_REGISTER_DEVICE`
+// so that they are not dropped when linking against the static library.
+bool RegisterBuiltinDevices() {
+  auto& registry = internal::DeviceRegistry::Get();
+  registry.Register("xilinx_opencl", std::string_view("xclbin2\0", 8),
+                    &internal::XilinxOpenclDevice::New);
+  registry.Register("intel_opencl", std::string_view(ELFMAG, SELFMAG),
+                    &internal::IntelOpenclDevice::New);
+  registry.Register("tapa_fast_cosim", std::string_view("PK\3\4", 4),
+                    &internal::TapaFastCosimDevice::New);
+  registry.Register("generic_opencl_spir",
+                    internal::GenericOpenclDevice::kSpirMagic,
+                    &internal::GenericOpenclDevice::New);
+  registry.RegisterExtension("generic_opencl_source",
+                             internal::GenericOpenclDevice::kSourceExtension,
+                             &internal::GenericOpenclDevice::New);
+  registry.RegisterExtension("software",
+                             internal::SoftwareDevice::kManifestExtension,
+                             &internal::SoftwareDevice::New);
+  return true;
+}
+
+// Looks up the NUMA node of `device` and makes new pooled host buffers prefer
+// it.
+NumaPlacement PlaceOnNumaNode(const internal::Device& device) {
+  const std::string bdf = device.GetPcieBdf();
+  if (bdf.empty()) return {};
+  NumaPlacement placement = internal::GetNumaPlacement(bdf);
+  if (FLAGS_numa_placement && placement.node >= 0) {
+    internal::HostBufferPool::Get().SetNumaNode(placement.node);
+    placement.host_buffers_bound = true;
+  }
+  LOG(INFO) << placement;
+  return placement;
+}
+
+}  // namespace
+
 Instance::Instance(const std::string& bitstream) {
+  LoadedDevice loaded = Load(bitstream, /*prefetch=*/false);
+  device_ = std::move(loaded.device);
+  startup_phases_ = std::move(loaded.startup_phases);
+  numa_placement_ = std::move(loaded.numa_placement);
+}
+
+Instance Instance::LoadAsync(const std::string& bitstream) {
+  Instance instance;
+  instance.pending_device_ = std::async(std::launch::async, Load, bitstream,
+                                        /*prefetch=*/true);
+  return instance;
+}
+
+// Loads `bitstream` with the first registered backend that recognizes it.
+Instance::LoadedDevice Instance::Load(const std::string& bitstream,
+                                      bool prefetch) {
+  static const bool builtin_devices_registered [[maybe_unused]] =
+      RegisterBuiltinDevices();
+
   LOG(INFO) << "Loading " << bitstream;
-  cl::Program::Binaries binaries;
-  {
-    std::ifstream stream(bitstream, std::ios::binary);
-    binaries = {{std::istreambuf_iterator<char>(stream),
-                 std::istreambuf_iterator<char>()}};
+  const auto tic = std::chrono::steady_clock::now();
+  internal::StartupPhaseRecorder startup_phases;
+  internal::Bitstream file(bitstream);
+  if (prefetch) {
+    file.Prefetch();
   }
+  startup_phases.Record("open");
+
+  auto device = internal::DeviceRegistry::Get().New(file);
+  LOG_IF(FATAL, device == nullptr) << "Unexpected bitstream file";
+  NumaPlacement numa_placement = PlaceOnNumaNode(*device);
 
-  if ((device_ = internal::XilinxOpenclDevice::New(binaries))) {
-    return;
+  const std::chrono::nanoseconds elapsed =
+      std::chrono::steady_clock::now() - tic;
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  LOG(INFO) << "Loaded " << file.Content().size() << " bytes "
+            << (file.IsMapped() ? "(mmapped) " : "") << "in "
+            << elapsed.count() * 1e-9
+            << " s; peak RSS: " << usage.ru_maxrss / 1024 << " MiB";
+  return {std::move(device), startup_phases.Get(), elapsed,
+          std::move(numa_placement)};
+}
+
+internal::Device* Instance::device() const {
+  if (pending_device_.valid()) {
+    const auto tic = std::chrono::steady_clock::now();
+    LoadedDevice loaded = pending_device_.get();
+    const std::chrono::nanoseconds wait_time =
+        std::chrono::steady_clock::now() - tic;
+    device_ = std::move(loaded.device);
+    startup_phases_ = std::move(loaded.startup_phases);
+    numa_placement_ = std::move(loaded.numa_placement);
+    startup_overlap_ns_ =
+        std::max<int64_t>((loaded.load_time - wait_time).count(), 0);
+    LOG(INFO) << "Waited " << wait_time.count() * 1e-9
+              << " s for the device; " << startup_overlap_ns_ * 1e-9
+              << " s of " << loaded.load_time.count() * 1e-9
+              << " s of loading overlapped with the host";
   }
+  return device_.get();
+}
 
-  if ((device_ = internal::IntelOpenclDevice::New(binaries))) {
-    return;
+size_t Instance::SuspendBuf(int index) {
+  segmented_args_.erase(index);
+  return device()->SuspendBuffer(index);
+}
+
+void Instance::WriteToDevice() {
+  for (auto& [index, storage] : segmented_args_) {
+    if (storage->GetTag() == internal::Tag::kWriteOnly ||
+        storage->GetTag() == internal::Tag::kReadWrite) {
+      storage->Gather();
+    }
   }
+  device()->WriteToDevice();
+}
+
+void Instance::ReadFromDevice() {
+  device()->ReadFromDevice();
+  is_scatter_pending_ = true;
+}
 
-  if ((device_ = internal::TapaFastCosimDevice::New(
-           bitstream,
-           std::string_view(reinterpret_cast<char*>(binaries.begin()->data()),
-                            binaries.begin()->size())))) {
-    return;
+void Instance::Exec() { device()->Exec(); }
+
+void Instance::Finish() {
+  device()->Finish();
+  for (auto& storage : TakeScatters()) {
+    storage->Scatter();
   }
+}
 
-  LOG(FATAL) << "Unexpected bitstream file";
+Run Instance::TakeRun() {
+  auto scatters = TakeScatters();
+  return Run(device()->TakeRun(), std::move(scatters), runs_in_flight_);
 }
 
-size_t Instance::SuspendBuf(int index) { return device_->SuspendBuffer(index); }
+std::vector<std::shared_ptr<internal::SegmentedStorage>>
+Instance::TakeScatters() {
+  std::vector<std::shared_ptr<internal::SegmentedStorage>> scatters;
+  if (!is_scatter_pending_) return scatters;
+  is_scatter_pending_ = false;
+  for (auto& [index, storage] : segmented_args_) {
+    if (storage->GetTag() == internal::Tag::kReadOnly ||
+        storage->GetTag() == internal::Tag::kReadWrite) {
+      scatters.push_back(storage);
+    }
+  }
+  return scatters;
+}
 
-void Instance::WriteToDevice() { device_->WriteToDevice(); }
+std::vector<ArgInfo> Instance::GetArgsInfo() const {
+  return device()->GetArgsInfo();
+}
 
-void Instance::ReadFromDevice() { device_->ReadFromDevice(); }
+std::vector<BufferInfo> Instance::GetBuffersInfo() const {
+  return device()->GetBuffersInfo();
+}
 
-void Instance::Exec() { device_->Exec(); }
+std::vector<MemoryBank> Instance::GetMemoryTopology() const {
+  return device()->GetMemoryTopology();
+}
 
-void Instance::Finish() { device_->Finish(); }
+DeviceMemoryStats Instance::GetDeviceMemoryStats() const {
+  return device()->GetDeviceMemoryStats();
+}
 
-std::vector<ArgInfo> Instance::GetArgsInfo() const {
-  return device_->GetArgsInfo();
+NumaPlacement Instance::GetNumaPlacement() const {
+  device();
+  return numa_placement_;
+}
+
+bool Instance::PinThreadToDevice() const {
+  device();
+  return internal::PinCurrentThread(numa_placement_.cpus);
 }
 
 int64_t Instance::LoadTimeNanoSeconds() const {
-  return device_->LoadTimeNanoSeconds();
+  return device()->LoadTimeNanoSeconds();
+}
+
+std::vector<StartupPhase> Instance::GetStartupPhases() const {
+  std::vector<StartupPhase> phases = device()->GetStartupPhases();
+  phases.insert(phases.begin(), startup_phases_.begin(),
+                startup_phases_.end());
+  return phases;
+}
+
+int64_t Instance::StartupOverlapNanoSeconds() const {
+  device();
+  return startup_overlap_ns_;
 }
 
 int64_t Instance::ComputeTimeNanoSeconds() const {
-  return device_->ComputeTimeNanoSeconds();
+  return device()->ComputeTimeNanoSeconds();
 }
 
 int64_t Instance::StoreTimeNanoSeconds() const {
-  return device_->StoreTimeNanoSeconds();
+  return device()->StoreTimeNanoSeconds();
 }
 
 double Instance::LoadTimeSeconds() const {
@@ -80,12 +253,12 @@ double Instance::StoreTimeSeconds() const {
 }
 
 double Instance::LoadThroughputGbps() const {
-  return static_cast<double>(device_->LoadBytes()) /
+  return static_cast<double>(device()->LoadBytes()) /
          static_cast<double>(LoadTimeNanoSeconds());
 }
 
 double Instance::StoreThroughputGbps() const {
-  return static_cast<double>(device_->StoreBytes()) /
+  return static_cast<double>(device()->StoreBytes()) /
          static_cast<double>(StoreTimeNanoSeconds());
 }
 
@@ -96,4 +269,16 @@ void Instance::ConditionallyFinish(bool has_stream) {
   }
 }
 
+CacheStats GetProgramCacheStats() {
+  return internal::OpenclProgramCache::Get().GetStats();
+}
+
+CacheStats GetMetadataCacheStats() {
+  return internal::GetMetadataCacheStats();
+}
+
+CacheStats GetHostBufferPoolStats() {
+  return internal::HostBufferPool::Get().GetStats();
+}
+
 }  // namespace fpga
@@ -5,17 +5,35 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <memory>
 #include <ratio>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <glog/logging.h>
+
+#include "frt/aligned_allocator.h"
 #include "frt/arg_info.h"
 #include "frt/buffer.h"
+#include "frt/buffer_info.h"
+#include "frt/cache_stats.h"
 #include "frt/device.h"
+#include "frt/device_buffer.h"
+#include "frt/device_memory_stats.h"
+#include "frt/map_mode.h"
+#include "frt/mapped_file.h"
+#include "frt/memory_bank.h"
+#include "frt/numa_placement.h"
+#include "frt/run.h"
+#include "frt/segmented_buffer.h"
+#include "frt/span.h"
+#include "frt/startup_phase.h"
 #include "frt/stream.h"
 #include "frt/stream_wrapper.h"
 #include "frt/tag.h"
@@ -55,22 +73,58 @@ class Instance {
  public:
   Instance(const std::string& bitstream);
 
+  // Loads `bitstream` on a background thread and returns immediately. Member
+  // functions of the returned instance block until the device is ready, so
+  // that host inputs can be prepared while the device is being programmed.
+  static Instance LoadAsync(const std::string& bitstream);
+
   // Sets a scalar argument.
   template <typename T>
   void SetArg(int index, T arg) {
-    device_->SetScalarArg(index, &arg, sizeof(arg));
+    device()->SetScalarArg(index, &arg, sizeof(arg));
   }
 
   // Sets a buffer argument.
   template <typename T, internal::Tag tag>
   void SetArg(int index, internal::Buffer<T, tag> arg) {
-    device_->SetBufferArg(index, tag, arg);
+    segmented_args_.erase(index);
+    device()->SetBufferArg(index, tag, arg);
+  }
+
+  // Sets a device buffer argument, which is not transferred.
+  template <typename T>
+  void SetArg(int index, DeviceBuffer<T> arg) {
+    segmented_args_.erase(index);
+    device()->SetDeviceBufferArg(index, arg.id_);
+  }
+
+  // Sets a segmented buffer argument, which is packed by `WriteToDevice` and
+  // unpacked by `Finish`; see `fpga::Gather` and `fpga::Scatter`.
+  template <typename T, internal::Tag tag>
+  void SetArg(int index, SegmentedBuffer<T, tag> arg) {
+    device()->SetBufferArg(
+        index, tag,
+        internal::Buffer<T, tag>(reinterpret_cast<T*>(arg.storage_->Get()),
+                                 arg.Size()));
+    segmented_args_[index] = std::move(arg.storage_);
+  }
+
+  // Sets a memory-mapped file argument, which is written to the device if it
+  // was opened with `MappedFile<T>::Open`, or read back into the file if it
+  // was created with `MappedFile<T>::Create`.
+  template <typename T>
+  void SetArg(int index, MappedFile<T>& arg) {
+    if (arg.IsWritable()) {
+      SetArg(index, ReadOnly(arg.data(), arg.size()));
+    } else {
+      SetArg(index, WriteOnly(arg.data(), arg.size()));
+    }
   }
 
   // Sets a stream argument.
   template <internal::Tag tag>
   void SetArg(int index, internal::Stream<tag>& arg) {
-    device_->SetStreamArg(index, tag, arg);
+    device()->SetStreamArg(index, tag, arg);
   }
 
   // Sets all arguments.
@@ -84,8 +138,63 @@ class Instance {
   template <typename T>
   [[deprecated("'SetArg' is sufficient")]] void AllocBuf(int index, T arg) {}
 
+  // Allocates a buffer of `n` elements in device memory only.
+  template <typename T>
+  DeviceBuffer<T> CreateDeviceBuffer(size_t n) {
+    return DeviceBuffer<T>(device()->CreateDeviceBuffer(n * sizeof(T)), n);
+  }
+
+  // Reads `n` elements starting at element `offset` of `buffer` into
+  // `host_ptr` after previous commands finish, blocking until done.
+  template <typename T>
+  void ReadDeviceBuffer(const DeviceBuffer<T>& buffer, T* host_ptr,
+                        size_t offset, size_t n) {
+    CHECK_LE(offset + n, buffer.Size()) << "range is out of bounds";
+    device()->ReadDeviceBuffer(buffer.id_, offset * sizeof(T), n * sizeof(T),
+                               host_ptr);
+  }
+  template <typename T>
+  void ReadDeviceBuffer(const DeviceBuffer<T>& buffer, T* host_ptr) {
+    ReadDeviceBuffer(buffer, host_ptr, 0, buffer.Size());
+  }
+
+  // Writes `n` elements from `host_ptr` starting at element `offset` of
+  // `buffer` after previous commands finish, blocking until done.
+  template <typename T>
+  void WriteDeviceBuffer(const DeviceBuffer<T>& buffer, const T* host_ptr,
+                         size_t offset, size_t n) {
+    CHECK_LE(offset + n, buffer.Size()) << "range is out of bounds";
+    device()->WriteDeviceBuffer(buffer.id_, offset * sizeof(T), n * sizeof(T),
+                                host_ptr);
+  }
+  template <typename T>
+  void WriteDeviceBuffer(const DeviceBuffer<T>& buffer, const T* host_ptr) {
+    WriteDeviceBuffer(buffer, host_ptr, 0, buffer.Size());
+  }
+
+  // Maps `n` elements starting at element `offset` of buffer argument `index`
+  // into the host after previous commands finish, blocking until done, so
+  // that they can be accessed in place instead of transferring the whole
+  // buffer. Changes made through the span reach the device at `Unmap`. Use
+  // `SuspendBuf` so that `WriteToDevice` and `ReadFromDevice` do not transfer
+  // the buffer again.
+  template <typename T>
+  Span<T> Map(int index, size_t offset, size_t n, MapMode mode) {
+    return Span<T>(static_cast<T*>(device()->MapBuffer(
+                       index, offset * sizeof(T), n * sizeof(T), mode)),
+                   n);
+  }
+
+  // Unmaps `span` returned by `Map` for buffer argument `index`, blocking
+  // until the device sees changes made through it.
+  template <typename T>
+  void Unmap(int index, Span<T> span) {
+    device()->UnmapBuffer(index, span.data());
+  }
+
   // Suspends a buffer from being transferred between host and device and
-  // returns the number of transfer operations suspended.
+  // returns the number of transfer operations suspended. The device buffer
+  // then holds the only up-to-date copy, so it is never evicted.
   size_t SuspendBuf(int index);
 
   // Writes buffers to the device.
@@ -97,7 +206,8 @@ class Instance {
   // Executes the program on the device.
   void Exec();
 
-  // Waits for the program to finish.
+  // Waits for the program to finish. Results of launched runs reach host
+  // memory when each run is waited for.
   void Finish();
 
   // Invokes the program on the device. This is a shortcut for `SetArgs`,
@@ -118,9 +228,52 @@ class Instance {
     return *this;
   }
 
+  // Enqueues an invocation like `Invoke` without waiting for it, and returns
+  // a run to wait for it and read its times, so that further invocations can
+  // be enqueued while it is in flight; see `fpga::Run`. The times of the
+  // instance itself do not cover launched runs.
+  template <typename... Args>
+  Run Launch(Args&&... args) {
+    SetArgs(std::forward<Args>(args)...);
+    WriteToDevice();
+    Exec();
+    ReadFromDevice();
+    return TakeRun();
+  }
+
+  // Returns the number of runs launched and not yet waited for.
+  int RunsInFlight() const { return *runs_in_flight_; }
+
   // Returns information of all args as a vector, sorted by the index.
   std::vector<ArgInfo> GetArgsInfo() const;
 
+  // Returns how each buffer argument set so far is transferred, sorted by the
+  // index. Buffers that are not zero-copy should be allocated with
+  // `fpga::AlignedAllocator`; large ones are otherwise staged through pinned
+  // host memory, at the bandwidth reported in `staged_gbps`.
+  std::vector<BufferInfo> GetBuffersInfo() const;
+
+  // Returns the memory banks of the device that kernels connect to, sorted by
+  // the index. Empty if the backend does not know the memory topology.
+  std::vector<MemoryBank> GetMemoryTopology() const;
+
+  // Returns the device memory used by buffers of this instance and of all
+  // instances on the same device. Buffers of idle instances, i.e., those that
+  // called `Finish` or waited for all their runs, are evicted once the total
+  // would exceed `--device_memory_budget_mib`, and restored when next used.
+  DeviceMemoryStats GetDeviceMemoryStats() const;
+
+  // Returns the NUMA node of the device and its CPUs. Unless
+  // `--numa_placement=false`, host buffers allocated by
+  // `fpga::AlignedAllocator` after loading prefer that node. The pool of such
+  // buffers is process-wide, so the last loaded instance decides.
+  NumaPlacement GetNumaPlacement() const;
+
+  // Restricts the calling thread to the CPUs of the NUMA node of the device,
+  // e.g., in threads that prepare transfers or feed streams. Returns false if
+  // the node is unknown or the thread cannot be pinned.
+  bool PinThreadToDevice() const;
+
   // Returns the load time in nanoseconds.
   int64_t LoadTimeNanoSeconds() const;
 
@@ -130,6 +283,16 @@ class Instance {
   // Returns the store time in nanoseconds.
   int64_t StoreTimeNanoSeconds() const;
 
+  // Returns how long loading the bitstream overlapped with the host in
+  // nanoseconds, i.e., the time `LoadAsync` took minus the time spent waiting
+  // for it. Always zero for synchronously constructed instances.
+  int64_t StartupOverlapNanoSeconds() const;
+
+  // Returns the wall time of each phase of loading the bitstream in order, from
+  // opening the file to building the program. Kernels are created when their
+  // arguments are first set, so their phases are appended afterwards.
+  std::vector<StartupPhase> GetStartupPhases() const;
+
   // Returns the load time in seconds.
   double LoadTimeSeconds() const;
 
@@ -152,11 +315,58 @@ class Instance {
     SetArg(index + 1, std::forward<Args>(other_args)...);
   }
 
+  struct LoadedDevice {
+    std::unique_ptr<internal::Device> device;
+    // Phases before the device is constructed.
+    std::vector<StartupPhase> startup_phases;
+    std::chrono::nanoseconds load_time;
+    NumaPlacement numa_placement;
+  };
+
+  static LoadedDevice Load(const std::string& bitstream, bool prefetch);
+
+  Instance() = default;
+
   void ConditionallyFinish(bool has_stream);
 
-  std::unique_ptr<internal::Device> device_;
+  // Detaches the invocation enqueued since the last `Finish` or `TakeRun` as a
+  // run.
+  Run TakeRun();
+
+  // Returns the segmented buffers to unpack after `ReadFromDevice`, if any.
+  std::vector<std::shared_ptr<internal::SegmentedStorage>> TakeScatters();
+
+  // Returns the device, waiting for it if it is still being loaded.
+  internal::Device* device() const;
+
+  mutable std::unique_ptr<internal::Device> device_;
+  mutable std::vector<StartupPhase> startup_phases_;
+  mutable NumaPlacement numa_placement_;
+  mutable std::future<LoadedDevice> pending_device_;
+  mutable int64_t startup_overlap_ns_ = 0;
+  // Segmented buffer arguments, by index.
+  std::unordered_map<int, std::shared_ptr<internal::SegmentedStorage>>
+      segmented_args_;
+  // Set by `ReadFromDevice` until `Finish` or `TakeRun` takes the segmented
+  // buffers to unpack.
+  bool is_scatter_pending_ = false;
+  // Shared with runs, which count themselves until waited for.
+  std::shared_ptr<int> runs_in_flight_ = std::make_shared<int>(0);
 };
 
+// Returns statistics of the process-wide cache of OpenCL contexts and
+// programs, which lets instances of an already loaded bitstream skip
+// reprogramming the device.
+CacheStats GetProgramCacheStats();
+
+// Returns statistics of the on-disk cache of parsed kernel metadata, which
+// lets later processes loading the same bitstream skip parsing its XML.
+CacheStats GetMetadataCacheStats();
+
+// Returns statistics of the process-wide pool of page-aligned host memory used
+// by `fpga::AlignedAllocator`.
+CacheStats GetHostBufferPoolStats();
+
 template <typename Arg, typename... Args>
 Instance Invoke(const std::string& bitstream, Arg&& arg, Args&&... args) {
   return std::move(Instance(bitstream).Invoke(std::forward<Arg>(arg),
@@ -0,0 +1,51 @@
+#ifndef FPGA_RUNTIME_ALIGNED_ALLOCATOR_H_
+#define FPGA_RUNTIME_ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+
+#include "frt/host_buffer_pool.h"
+
+namespace fpga {
+
+// Allocates page-aligned memory from the process-wide host buffer pool, so
+// that buffers can be transferred without an extra copy, e.g.,
+//
+//   std::vector<float, fpga::AlignedAllocator<float>> a(n);
+//   instance.SetArg(0, fpga::WriteOnly(a.data(), a.size()));
+//
+// Memory freed by one vector is recycled by later ones of a similar size.
+// Large vectors are backed by huge pages with `--host_buffer_pool_huge_pages`.
+template <typename T>
+class AlignedAllocator {
+ public:
+  static_assert(alignof(T) <= internal::HostBufferPool::kAlignment);
+
+  using value_type = T;
+
+  AlignedAllocator() = default;
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        internal::HostBufferPool::Get().Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    internal::HostBufferPool::Get().Deallocate(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) {
+  return false;
+}
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_ALIGNED_ALLOCATOR_H_
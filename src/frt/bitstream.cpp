@@ -0,0 +1,70 @@
+#include "frt/bitstream.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace fpga {
+namespace internal {
+
+Bitstream::Bitstream(const std::string& path) : path_(path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  LOG_IF(FATAL, fd < 0) << "Cannot open bitstream '" << path
+                        << "': " << strerror(errno);
+
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) == 0 && S_ISREG(stat_buf.st_mode) &&
+      stat_buf.st_size > 0) {
+    void* addr =
+        mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      data_ = static_cast<const char*>(addr);
+      size_ = stat_buf.st_size;
+      mapped_ = true;
+    } else {
+      LOG(WARNING) << "Cannot mmap bitstream '" << path
+                   << "': " << strerror(errno) << "; reading it instead";
+    }
+  }
+
+  if (!mapped_) {
+    char buf[1 << 16];
+    for (ssize_t n; (n = read(fd, buf, sizeof(buf))) != 0;) {
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        LOG(FATAL) << "Cannot read bitstream '" << path
+                   << "': " << strerror(errno);
+      }
+      owned_.append(buf, n);
+    }
+    data_ = owned_.data();
+    size_ = owned_.size();
+  }
+
+  close(fd);
+}
+
+void Bitstream::Prefetch() const {
+  if (mapped_) {
+    LOG_IF(WARNING,
+           madvise(const_cast<char*>(data_), size_, MADV_WILLNEED) != 0)
+        << "Cannot prefetch bitstream '" << path_ << "': " << strerror(errno);
+  }
+}
+
+Bitstream::~Bitstream() {
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+}  // namespace internal
+}  // namespace fpga
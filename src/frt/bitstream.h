@@ -0,0 +1,54 @@
+#ifndef FPGA_RUNTIME_BITSTREAM_H_
+#define FPGA_RUNTIME_BITSTREAM_H_
+
+#include <cstddef>
+
+#include <string>
+#include <string_view>
+
+namespace fpga {
+namespace internal {
+
+// Read-only view of a bitstream file. Regular files are memory-mapped so that
+// backends can inspect them without copying; anything that cannot be mapped
+// (e.g., a pipe) is read into an owned buffer instead.
+class Bitstream {
+ public:
+  // Number of bytes returned by `Header()`, i.e., the first page.
+  static constexpr size_t kHeaderSize = 4096;
+
+  explicit Bitstream(const std::string& path);
+  Bitstream(const Bitstream&) = delete;
+  Bitstream& operator=(const Bitstream&) = delete;
+  Bitstream(Bitstream&&) = delete;
+  Bitstream& operator=(Bitstream&&) = delete;
+  ~Bitstream();
+
+  // Returns the path used to open the bitstream.
+  const std::string& Path() const { return path_; }
+
+  // Returns the whole content. Pages of a mapped file are faulted in lazily.
+  std::string_view Content() const { return {data_, size_}; }
+
+  // Returns at most the first `kHeaderSize` bytes, for magic sniffing.
+  std::string_view Header() const { return Content().substr(0, kHeaderSize); }
+
+  // Returns whether `Content()` is backed by a memory mapping.
+  bool IsMapped() const { return mapped_; }
+
+  // Asks the kernel to read a mapped file ahead in the background, so that
+  // backends do not fault its pages in one at a time. No-op if not mapped.
+  void Prefetch() const;
+
+ private:
+  const std::string path_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::string owned_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_BITSTREAM_H_
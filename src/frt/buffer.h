@@ -15,11 +15,25 @@ namespace internal {
 template <typename T, Tag tag>
 class Buffer {
  public:
-  Buffer(T* ptr, size_t n) : ptr_(ptr), n_(n) {}
+  Buffer(T* ptr, size_t n) : Buffer(ptr, n, 0, n) {}
   T* Get() const { return ptr_; }
   size_t Size() const { return n_; }
   size_t SizeInBytes() const { return n_ * sizeof(T); }
 
+  // Returns the same buffer, except that transfers between host and device
+  // only cover the `n` elements starting at element `offset` of the whole
+  // buffer. The device allocation and the kernel still see all `Size()`
+  // elements, e.g., a preallocated buffer of which only a prefix is in use.
+  Buffer Slice(size_t offset, size_t n) const {
+    CHECK_LE(offset, Size()) << "slice offset is out of bounds";
+    CHECK_LE(n, Size() - offset) << "slice size is out of bounds";
+    return Buffer(ptr_, n_, offset, n);
+  }
+
+  // Returns the first element and the number of elements to transfer.
+  size_t ActiveOffset() const { return active_offset_; }
+  size_t ActiveSize() const { return active_n_; }
+
   template <typename U>
   Buffer<U, tag> Reinterpret() const {
     static_assert(std::is_standard_layout<T>::value,
@@ -52,13 +66,24 @@ class Buffer {
         << "-byte aligned when reinterpreted as Buffer<U> (i.e., "
            "`Reinterpret<U>()`) because alignof(U) = "
         << alignof(U);
+    // The active range covers at least the same bytes.
+    const size_t active_begin = ActiveOffset() * sizeof(T) / sizeof(U);
+    const size_t active_end =
+        ((ActiveOffset() + ActiveSize()) * sizeof(T) + sizeof(U) - 1) /
+        sizeof(U);
     return Buffer<U, tag>(reinterpret_cast<U*>(Get()),
-                          Size() * sizeof(T) / sizeof(U));
+                          Size() * sizeof(T) / sizeof(U))
+        .Slice(active_begin, active_end - active_begin);
   }
 
  private:
+  Buffer(T* ptr, size_t n, size_t active_offset, size_t active_n)
+      : ptr_(ptr), n_(n), active_offset_(active_offset), active_n_(active_n) {}
+
   T* const ptr_;
   const size_t n_;
+  const size_t active_offset_;
+  const size_t active_n_;
 };
 
 }  // namespace internal
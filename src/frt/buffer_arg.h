@@ -15,7 +15,9 @@ class BufferArg {
   BufferArg(Buffer<T, tag> buffer)
       : ptr_(const_cast<char*>(reinterpret_cast<const char*>(buffer.Get()))),
         size_(sizeof(T)),
-        n_(buffer.SizeInBytes() / sizeof(T)) {}
+        n_(buffer.SizeInBytes() / sizeof(T)),
+        active_offset_(buffer.ActiveOffset()),
+        active_n_(buffer.ActiveSize()) {}
 
   BufferArg() = default;
   BufferArg(const BufferArg&) = default;
@@ -27,10 +29,17 @@ class BufferArg {
   size_t SizeInCount() const { return n_; }
   size_t SizeInBytes() const { return size_ * n_; }
 
+  // Returns the range of bytes to transfer, see `Buffer::Slice`.
+  size_t ActiveOffsetInBytes() const { return size_ * active_offset_; }
+  size_t ActiveSizeInBytes() const { return size_ * active_n_; }
+  bool IsWhollyActive() const { return active_n_ == n_; }
+
  private:
   char* ptr_;
   size_t size_;
   size_t n_;
+  size_t active_offset_;
+  size_t active_n_;
 };
 
 }  // namespace internal
@@ -0,0 +1,31 @@
+#include "frt/buffer_info.h"
+
+#include <ostream>
+#include <vector>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const BufferInfo& info) {
+  return os << "BufferInfo: {index: " << info.index << ", size: " << info.size
+            << ", zero_copy: " << (info.zero_copy ? "true" : "false")
+            << ", reuse_count: " << info.reuse_count
+            << ", cold: " << info.cold_nanoseconds * 1e-9 << " s"
+            << ", warm: " << info.warm_nanoseconds * 1e-9 << " s"
+            << ", load_bytes: " << info.load_bytes
+            << ", skipped_load_bytes: " << info.skipped_load_bytes
+            << ", memory_bank: " << info.memory_bank
+            << ", in_arena: " << (info.in_arena ? "true" : "false")
+            << ", staged: " << (info.staged ? "true" : "false")
+            << ", staged_bandwidth: " << info.staged_gbps << " GB/s}";
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<BufferInfo>& infos) {
+  os << "BuffersInfo: {";
+  for (size_t i = 0; i < infos.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << infos[i];
+  }
+  return os << "}";
+}
+
+}  // namespace fpga
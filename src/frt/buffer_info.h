@@ -0,0 +1,49 @@
+#ifndef FPGA_RUNTIME_BUFFER_INFO_H_
+#define FPGA_RUNTIME_BUFFER_INFO_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+#include <vector>
+
+namespace fpga {
+
+// How a buffer argument is transferred between host and device.
+struct BufferInfo {
+  int index = 0;
+  size_t size = 0;
+  // Whether the device accesses host memory directly, or the runtime does
+  // transfers without an extra copy through a staging buffer.
+  bool zero_copy = false;
+  // Number of times `SetArg` reused the device buffer instead of creating it.
+  int64_t reuse_count = 0;
+  // Time `SetArg` took when it last created the device buffer.
+  int64_t cold_nanoseconds = 0;
+  // Time `SetArg` took when it last reused the device buffer.
+  int64_t warm_nanoseconds = 0;
+  // Bytes of the active range sent and not sent by the last `WriteToDevice`,
+  // e.g., because they are on pages that were not written.
+  int64_t load_bytes = 0;
+  int64_t skipped_load_bytes = 0;
+  // Index of the memory bank the buffer is allocated in, or -1 if it is left
+  // to the vendor runtime. See `Instance::GetMemoryTopology`.
+  int memory_bank = -1;
+  // Whether the buffer is a slot of the arena of small buffers, which are
+  // staged through one allocation and transferred together.
+  bool in_arena = false;
+  // Whether the buffer is transferred through the pinned staging ring because
+  // its host memory is not aligned for zero-copy.
+  bool staged = false;
+  // Effective bandwidth in GB/s of the last transfer through the staging ring,
+  // including the copies into or out of it.
+  double staged_gbps = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const BufferInfo& info);
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<BufferInfo>& infos);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_BUFFER_INFO_H_
@@ -11,6 +11,7 @@
 #include <gtest/gtest.h>
 
 #include "frt.h"
+#include "frt/buffer_arg.h"
 #include "frt/tag.h"
 
 namespace fpga::internal {
@@ -35,6 +36,46 @@ TEST_F(BufferTest, SizeInBytesReturnsByteCount) {
   EXPECT_EQ(buf.SizeInBytes(), elements_.size() * sizeof(elements_[0]));
 }
 
+TEST_F(BufferTest, WholeBufferIsActive) {
+  auto buf = fpga::ReadOnly(elements_.data(), elements_.size());
+
+  EXPECT_EQ(buf.ActiveOffset(), 0);
+  EXPECT_EQ(buf.ActiveSize(), elements_.size());
+}
+
+TEST_F(BufferTest, SliceKeepsSizeAndSetsActiveRange) {
+  auto buf = fpga::WriteOnly(elements_.data(), elements_.size()).Slice(2, 3);
+  BufferArg arg = buf;
+
+  EXPECT_EQ(buf.Get(), elements_.data());
+  EXPECT_EQ(buf.Size(), elements_.size());
+  EXPECT_EQ(buf.ActiveOffset(), 2);
+  EXPECT_EQ(buf.ActiveSize(), 3);
+  EXPECT_EQ(arg.SizeInBytes(), elements_.size() * sizeof(float));
+  EXPECT_EQ(arg.ActiveOffsetInBytes(), 2 * sizeof(float));
+  EXPECT_EQ(arg.ActiveSizeInBytes(), 3 * sizeof(float));
+  EXPECT_FALSE(arg.IsWhollyActive());
+}
+
+TEST_F(BufferTest, SliceOutOfBoundsFails) {
+  auto buf = fpga::ReadOnly(elements_.data(), elements_.size());
+
+  EXPECT_DEATH(buf.Slice(elements_.size() + 1, 0), "slice offset");
+  EXPECT_DEATH(buf.Slice(5, elements_.size()), "slice size");
+}
+
+TEST_F(BufferTest, ReinterpretCoversActiveRange) {
+  auto buf = fpga::ReadWrite(elements_.data(), elements_.size()).Slice(3, 3);
+
+  auto narrower = buf.Reinterpret<uint16_t>();
+  auto wider = buf.Reinterpret<std::array<float, 2>>();
+
+  EXPECT_EQ(narrower.ActiveOffset(), 6);
+  EXPECT_EQ(narrower.ActiveSize(), 6);
+  EXPECT_EQ(wider.ActiveOffset(), 1);
+  EXPECT_EQ(wider.ActiveSize(), 2);
+}
+
 TEST_F(BufferTest, ReinterpretAsWiderTypeSucceeds) {
   float* ptr = elements_.data();
   int64_t size = elements_.size();
@@ -0,0 +1,13 @@
+#include "frt/cache_stats.h"
+
+#include <ostream>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const CacheStats& stats) {
+  return os << "CacheStats: {hits: " << stats.hits
+            << ", misses: " << stats.misses
+            << ", saved: " << stats.saved_nanoseconds * 1e-9 << " s}";
+}
+
+}  // namespace fpga
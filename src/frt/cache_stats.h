@@ -0,0 +1,21 @@
+#ifndef FPGA_RUNTIME_CACHE_STATS_H_
+#define FPGA_RUNTIME_CACHE_STATS_H_
+
+#include <cstdint>
+
+#include <ostream>
+
+namespace fpga {
+
+struct CacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  // Time that would have been spent on the hits without the cache.
+  int64_t saved_nanoseconds = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const CacheStats& stats);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_CACHE_STATS_H_
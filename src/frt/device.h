@@ -4,10 +4,18 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "frt/arg_info.h"
 #include "frt/buffer_arg.h"
+#include "frt/buffer_info.h"
+#include "frt/device_memory_stats.h"
+#include "frt/device_run.h"
+#include "frt/map_mode.h"
+#include "frt/memory_bank.h"
+#include "frt/startup_phase.h"
 #include "frt/stream_wrapper.h"
 #include "frt/tag.h"
 
@@ -23,10 +31,33 @@ class Device {
   virtual void SetStreamArg(int index, Tag tag, StreamWrapper& arg) = 0;
   virtual size_t SuspendBuffer(int index) = 0;
 
+  // Allocates `size` bytes of device memory without a host mirror and returns
+  // its id.
+  virtual int CreateDeviceBuffer(size_t size) = 0;
+  virtual void SetDeviceBufferArg(int index, int id) = 0;
+  // Copy between device buffer `id` and the host after previous commands
+  // finish, blocking until the copy is done.
+  virtual void ReadDeviceBuffer(int id, size_t offset, size_t size,
+                                void* host_ptr) = 0;
+  virtual void WriteDeviceBuffer(int id, size_t offset, size_t size,
+                                 const void* host_ptr) = 0;
+  // Maps `size` bytes at `offset` of the device memory of buffer argument
+  // `index` into the host after previous commands finish, blocking until
+  // done, and returns their address. `UnmapBuffer` blocks until the device
+  // sees changes made through `ptr`.
+  virtual void* MapBuffer(int index, size_t offset, size_t size,
+                          MapMode mode) = 0;
+  virtual void UnmapBuffer(int index, void* ptr) = 0;
+
   virtual void WriteToDevice() = 0;
   virtual void ReadFromDevice() = 0;
   virtual void Exec() = 0;
   virtual void Finish() = 0;
+  // Detaches the commands enqueued by `WriteToDevice`, `Exec`, and
+  // `ReadFromDevice` since the last `TakeRun` or `Finish` as a run, so that
+  // they are waited for and timed separately from later invocations enqueued
+  // before they finish. The run must not outlive the device.
+  virtual std::unique_ptr<DeviceRun> TakeRun() = 0;
 
   virtual std::vector<ArgInfo> GetArgsInfo() const = 0;
   virtual int64_t LoadTimeNanoSeconds() const = 0;
@@ -34,6 +65,15 @@ class Device {
   virtual int64_t StoreTimeNanoSeconds() const = 0;
   virtual size_t LoadBytes() const = 0;
   virtual size_t StoreBytes() const = 0;
+  virtual std::vector<StartupPhase> GetStartupPhases() const = 0;
+  virtual std::vector<BufferInfo> GetBuffersInfo() const = 0;
+  virtual std::vector<MemoryBank> GetMemoryTopology() const = 0;
+  // Returns the normalized PCIe Bus:Device:Function, or an empty string if
+  // the device is not a known PCIe device.
+  virtual std::string GetPcieBdf() const = 0;
+  // Returns the device memory used by buffers, or zeros if the backend does
+  // not allocate any.
+  virtual DeviceMemoryStats GetDeviceMemoryStats() const = 0;
 };
 
 }  // namespace internal
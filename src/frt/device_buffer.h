@@ -0,0 +1,32 @@
+#ifndef FPGA_RUNTIME_DEVICE_BUFFER_H_
+#define FPGA_RUNTIME_DEVICE_BUFFER_H_
+
+#include <cstddef>
+
+namespace fpga {
+
+class Instance;
+
+// Handle of a buffer allocated in device memory only, e.g., for intermediate
+// results passed between kernels or successive invocations without crossing
+// PCIe. It is never transferred implicitly; use `Instance::ReadDeviceBuffer`
+// and `Instance::WriteDeviceBuffer` instead. Valid only with the instance
+// that created it, and freed with that instance.
+template <typename T>
+class DeviceBuffer {
+ public:
+  size_t Size() const { return n_; }
+  size_t SizeInBytes() const { return n_ * sizeof(T); }
+
+ private:
+  friend class Instance;
+
+  DeviceBuffer(int id, size_t n) : id_(id), n_(n) {}
+
+  int id_;
+  size_t n_;
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_DEVICE_BUFFER_H_
@@ -0,0 +1,22 @@
+#include "frt/device_memory_stats.h"
+
+#include <ostream>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const DeviceMemoryStats& stats) {
+  os << "DeviceMemoryStats: {current_bytes: " << stats.current_bytes
+     << ", peak_bytes: " << stats.peak_bytes << ", bank_bytes: {";
+  bool is_first = true;
+  for (const auto& [bank, bytes] : stats.bank_bytes) {
+    os << (is_first ? "" : ", ") << bank << ": " << bytes;
+    is_first = false;
+  }
+  return os << "}, evictions: " << stats.evictions
+            << ", evicted_bytes: " << stats.evicted_bytes
+            << ", device_current_bytes: " << stats.device_current_bytes
+            << ", device_peak_bytes: " << stats.device_peak_bytes
+            << ", device_budget_bytes: " << stats.device_budget_bytes << "}";
+}
+
+}  // namespace fpga
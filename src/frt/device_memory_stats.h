@@ -0,0 +1,35 @@
+#ifndef FPGA_RUNTIME_DEVICE_MEMORY_STATS_H_
+#define FPGA_RUNTIME_DEVICE_MEMORY_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <map>
+#include <ostream>
+
+namespace fpga {
+
+// Device memory used by the buffers of an instance, and by all instances
+// sharing its device.
+struct DeviceMemoryStats {
+  size_t current_bytes = 0;
+  size_t peak_bytes = 0;
+  // Current bytes by the index of the memory bank, or -1 for buffers left to
+  // the vendor runtime. See `Instance::GetMemoryTopology`.
+  std::map<int, size_t> bank_bytes;
+  // Buffers freed while the instance was idle to stay within the budget. They
+  // are allocated and loaded again when the instance next uses them.
+  int64_t evictions = 0;
+  size_t evicted_bytes = 0;
+
+  size_t device_current_bytes = 0;
+  size_t device_peak_bytes = 0;
+  // Set by `--device_memory_budget_mib`; 0 if unlimited.
+  size_t device_budget_bytes = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const DeviceMemoryStats& stats);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_DEVICE_MEMORY_STATS_H_
@@ -0,0 +1,109 @@
+#include "frt/device_registry.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <glog/logging.h>
+
+namespace fpga {
+namespace internal {
+
+DeviceRegistry& DeviceRegistry::Get() {
+  static DeviceRegistry* registry = new DeviceRegistry;
+  return *registry;
+}
+
+bool DeviceRegistry::Register(std::string_view name, std::string_view magic,
+                              DeviceFactory factory) {
+  LOG_IF(FATAL, magic.size() < kKeySize)
+      << "Magic signature of device '" << name << "' must have at least "
+      << kKeySize << " bytes";
+  std::lock_guard<std::mutex> lock(mtx_);
+  entries_[GetKey(magic)].push_back(
+      {std::string(name), std::string(magic), std::move(factory)});
+  ++size_;
+  VLOG(1) << "Registered device '" << name << "'";
+  return true;
+}
+
+bool DeviceRegistry::RegisterExtension(std::string_view name,
+                                       std::string_view extension,
+                                       DeviceFactory factory) {
+  LOG_IF(FATAL, GetExtension(extension) != extension)
+      << "Extension of device '" << name << "' must look like '.ext'";
+  std::lock_guard<std::mutex> lock(mtx_);
+  extension_entries_[std::string(extension)].push_back(
+      {std::string(name), std::string(extension), std::move(factory)});
+  ++size_;
+  VLOG(1) << "Registered device '" << name << "' for '" << extension << "'";
+  return true;
+}
+
+std::unique_ptr<Device> DeviceRegistry::New(const Bitstream& bitstream) const {
+  const std::string_view header = bitstream.Header();
+
+  std::vector<Entry> candidates;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (header.size() >= kKeySize) {
+      if (auto it = entries_.find(GetKey(header)); it != entries_.end()) {
+        for (const auto& entry : it->second) {
+          if (header.substr(0, entry.magic.size()) == entry.magic) {
+            candidates.push_back(entry);
+          }
+        }
+      }
+    }
+    // The most specific signature wins, e.g., a versioned one over a prefix.
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Entry& lhs, const Entry& rhs) {
+                       return lhs.magic.size() > rhs.magic.size();
+                     });
+    if (auto it = extension_entries_.find(
+            std::string(GetExtension(bitstream.Path())));
+        it != extension_entries_.end()) {
+      candidates.insert(candidates.end(), it->second.begin(),
+                        it->second.end());
+    }
+  }
+
+  // Factories may take long (e.g., programming the device), so they are
+  // invoked without holding the lock.
+  for (const auto& entry : candidates) {
+    VLOG(1) << "Trying device '" << entry.name << "'";
+    if (auto device = entry.factory(bitstream)) {
+      return device;
+    }
+  }
+  return nullptr;
+}
+
+size_t DeviceRegistry::Size() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return size_;
+}
+
+std::string_view DeviceRegistry::GetExtension(std::string_view path) {
+  const size_t pos = path.find_last_of("./");
+  if (pos == std::string_view::npos || path[pos] != '.' ||
+      pos + 1 == path.size()) {
+    return {};
+  }
+  return path.substr(pos);
+}
+
+uint32_t DeviceRegistry::GetKey(std::string_view header) {
+  static_assert(sizeof(uint32_t) == kKeySize);
+  uint32_t key;
+  memcpy(&key, header.data(), sizeof(key));
+  return key;
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,89 @@
+#ifndef FPGA_RUNTIME_DEVICE_REGISTRY_H_
+#define FPGA_RUNTIME_DEVICE_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "frt/bitstream.h"
+#include "frt/device.h"
+
+namespace fpga {
+namespace internal {
+
+// Creates a device from a bitstream, or returns nullptr if the bitstream is
+// not supported after all.
+using DeviceFactory =
+    std::function<std::unique_ptr<Device>(const Bitstream& bitstream)>;
+
+// Maps magic signatures at the beginning of bitstreams to device factories.
+// Signatures are bucketed by their first `kKeySize` bytes, so dispatching a
+// bitstream costs one hash lookup no matter how many backends are registered.
+class DeviceRegistry {
+ public:
+  static constexpr size_t kKeySize = 4;
+
+  // Returns the process-wide registry used by `fpga::Instance`.
+  static DeviceRegistry& Get();
+
+  // Registers `factory` for bitstreams beginning with `magic`, which must be at
+  // least `kKeySize` bytes long. Backends whose signatures match are tried
+  // longest signature first, and in the order of registration if equally
+  // long. Returns true so that it can initialize a static.
+  bool Register(std::string_view name, std::string_view magic,
+                DeviceFactory factory);
+
+  // Registers `factory` for bitstreams whose path ends with `extension`, e.g.,
+  // ".cl", for formats without a magic signature such as source code. These
+  // backends are tried after all backends whose signatures match, i.e., if
+  // none matches or all of them decline the bitstream. Returns true so that it
+  // can initialize a static.
+  bool RegisterExtension(std::string_view name, std::string_view extension,
+                         DeviceFactory factory);
+
+  // Creates a device using the backend whose signature or extension matches
+  // `bitstream`. Returns nullptr if there is no such backend.
+  std::unique_ptr<Device> New(const Bitstream& bitstream) const;
+
+  // Returns the number of registered backends.
+  size_t Size() const;
+
+ private:
+  struct Entry {
+    std::string name;
+    std::string magic;
+    DeviceFactory factory;
+  };
+
+  static uint32_t GetKey(std::string_view header);
+  static std::string_view GetExtension(std::string_view path);
+
+  mutable std::mutex mtx_;
+  std::unordered_map<uint32_t, std::vector<Entry>> entries_;
+  // Entries registered by extension; `Entry::magic` holds the extension.
+  std::unordered_map<std::string, std::vector<Entry>> extension_entries_;
+  size_t size_ = 0;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+// Registers a device backend from its own translation unit, e.g.,
+//
+//   FRT_REGISTER_DEVICE(mock, std::string_view("MOCK"), &MockDevice::New);
+//
+// Translation units in static libraries are only linked if referenced, so
+// backends living in one should be registered explicitly instead.
+#define FRT_REGISTER_DEVICE(name, magic, factory)                         \
+  static const bool frt_device_registered_##name [[maybe_unused]] =       \
+      ::fpga::internal::DeviceRegistry::Get().Register(#name, (magic),    \
+                                                       (factory))
+
+#endif  // FPGA_RUNTIME_DEVICE_REGISTRY_H_
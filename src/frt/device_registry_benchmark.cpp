@@ -0,0 +1,48 @@
+#include "frt/device_registry.h"
+
+#include <cstdlib>
+
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "frt/bitstream.h"
+
+namespace fpga::internal {
+namespace {
+
+std::string GetMagic(int index) {
+  std::string magic = "FRT";
+  magic += static_cast<char>(index);
+  magic += std::to_string(index);
+  return magic;
+}
+
+// Measures dispatching a bitstream that matches the last of `range(0)`
+// registered backends. The cost should not grow with the number of backends.
+void BM_DeviceRegistryNew(benchmark::State& state) {
+  const int backend_count = state.range(0);
+  DeviceRegistry registry;
+  for (int i = 0; i < backend_count; ++i) {
+    registry.Register("backend" + std::to_string(i), GetMagic(i),
+                      [](const Bitstream&) { return nullptr; });
+  }
+
+  std::string path = "/tmp/device_registry_benchmark.XXXXXX";
+  close(mkstemp(&path[0]));
+  std::ofstream(path) << GetMagic(backend_count - 1) << std::string(1 << 20, 0);
+  Bitstream bitstream(path);
+  unlink(path.c_str());
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(registry.New(bitstream));
+  }
+}
+BENCHMARK(BM_DeviceRegistryNew)->RangeMultiplier(4)->Range(1, 256);
+
+}  // namespace
+}  // namespace fpga::internal
@@ -0,0 +1,181 @@
+#include "frt/device_registry.h"
+
+#include <cstdlib>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "frt/bitstream.h"
+#include "frt/device.h"
+#include "frt/devices/finished_run.h"
+
+namespace fpga::internal {
+namespace {
+
+class MockDevice : public Device {
+ public:
+  explicit MockDevice(std::string name) : name(std::move(name)) {}
+
+  static std::unique_ptr<Device> New(const Bitstream& bitstream) {
+    return std::make_unique<MockDevice>("mock");
+  }
+
+  void SetScalarArg(int index, const void* arg, int size) override {}
+  void SetBufferArg(int index, Tag tag, const BufferArg& arg) override {}
+  void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override {}
+  size_t SuspendBuffer(int index) override { return 0; }
+  int CreateDeviceBuffer(size_t size) override { return 0; }
+  void SetDeviceBufferArg(int index, int id) override {}
+  void ReadDeviceBuffer(int id, size_t offset, size_t size,
+                        void* host_ptr) override {}
+  void WriteDeviceBuffer(int id, size_t offset, size_t size,
+                         const void* host_ptr) override {}
+  void* MapBuffer(int index, size_t offset, size_t size,
+                  MapMode mode) override {
+    return nullptr;
+  }
+  void UnmapBuffer(int index, void* ptr) override {}
+  void WriteToDevice() override {}
+  void ReadFromDevice() override {}
+  void Exec() override {}
+  void Finish() override {}
+  std::unique_ptr<DeviceRun> TakeRun() override {
+    return std::make_unique<FinishedRun>(*this);
+  }
+  std::vector<ArgInfo> GetArgsInfo() const override { return {}; }
+  int64_t LoadTimeNanoSeconds() const override { return 0; }
+  int64_t ComputeTimeNanoSeconds() const override { return 0; }
+  int64_t StoreTimeNanoSeconds() const override { return 0; }
+  size_t LoadBytes() const override { return 0; }
+  size_t StoreBytes() const override { return 0; }
+  std::vector<StartupPhase> GetStartupPhases() const override { return {}; }
+  std::vector<BufferInfo> GetBuffersInfo() const override { return {}; }
+  std::vector<MemoryBank> GetMemoryTopology() const override { return {}; }
+  std::string GetPcieBdf() const override { return ""; }
+  DeviceMemoryStats GetDeviceMemoryStats() const override { return {}; }
+
+  const std::string name;
+};
+
+// Registered the same way an out-of-tree backend would be.
+FRT_REGISTER_DEVICE(mock, std::string_view("MOCK"), &MockDevice::New);
+
+class DeviceRegistryTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    for (const auto& path : paths_) {
+      unlink(path.c_str());
+    }
+  }
+
+  std::string WriteFile(std::string_view content,
+                        const std::string& extension = "") {
+    std::string path =
+        testing::TempDir() + "/device_registry_test.XXXXXX" + extension;
+    close(mkstemps(&path[0], extension.size()));
+    std::ofstream(path, std::ios::binary)
+        .write(content.data(), content.size());
+    paths_.push_back(path);
+    return path;
+  }
+
+  static std::string GetName(const std::unique_ptr<Device>& device) {
+    return static_cast<const MockDevice&>(*device).name;
+  }
+
+ private:
+  std::vector<std::string> paths_;
+};
+
+TEST_F(DeviceRegistryTest, RegisterMacroUsesGlobalRegistry) {
+  Bitstream bitstream(WriteFile("MOCK bitstream"));
+
+  auto device = DeviceRegistry::Get().New(bitstream);
+
+  ASSERT_NE(device, nullptr);
+  EXPECT_EQ(GetName(device), "mock");
+}
+
+TEST_F(DeviceRegistryTest, NewDispatchesOnFullMagic) {
+  DeviceRegistry registry;
+  registry.Register("short", "ABCD", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("short");
+  });
+  registry.Register("long", "ABCDEFGH", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("long");
+  });
+  registry.Register("other", "ABCDXYZ", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("other");
+  });
+
+  auto other = registry.New(Bitstream(WriteFile("ABCDXYZ...")));
+  auto longest = registry.New(Bitstream(WriteFile("ABCDEFGH...")));
+  auto prefix = registry.New(Bitstream(WriteFile("ABCDEFG")));
+
+  ASSERT_NE(other, nullptr);
+  EXPECT_EQ(GetName(other), "other");
+  ASSERT_NE(longest, nullptr);
+  EXPECT_EQ(GetName(longest), "long");
+  ASSERT_NE(prefix, nullptr);
+  EXPECT_EQ(GetName(prefix), "short");
+}
+
+TEST_F(DeviceRegistryTest, NewFallsThroughWhenFactoryDeclines) {
+  DeviceRegistry registry;
+  registry.Register("declining", "ABCDE",
+                    [](const Bitstream&) { return nullptr; });
+  registry.Register("accepting", "ABCD", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("accepting");
+  });
+
+  auto device = registry.New(Bitstream(WriteFile("ABCDE")));
+
+  ASSERT_NE(device, nullptr);
+  EXPECT_EQ(GetName(device), "accepting");
+}
+
+TEST_F(DeviceRegistryTest, NewReturnsNullForUnknownMagic) {
+  DeviceRegistry registry;
+  registry.Register("mock", "MOCK", &MockDevice::New);
+
+  EXPECT_EQ(registry.New(Bitstream(WriteFile("UNKNOWN"))), nullptr);
+  EXPECT_EQ(registry.New(Bitstream(WriteFile("MO"))), nullptr);
+  EXPECT_EQ(registry.New(Bitstream(WriteFile("MOCX"))), nullptr);
+}
+
+TEST_F(DeviceRegistryTest, NewFallsBackToExtension) {
+  DeviceRegistry registry;
+  registry.Register("magic", "MOCK", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("magic");
+  });
+  registry.RegisterExtension("extension", ".mock", [](const Bitstream&) {
+    return std::make_unique<MockDevice>("extension");
+  });
+
+  auto by_magic = registry.New(Bitstream(WriteFile("MOCK", ".mock")));
+  auto by_extension = registry.New(Bitstream(WriteFile("src", ".mock")));
+
+  ASSERT_NE(by_magic, nullptr);
+  EXPECT_EQ(GetName(by_magic), "magic");
+  ASSERT_NE(by_extension, nullptr);
+  EXPECT_EQ(GetName(by_extension), "extension");
+  EXPECT_EQ(registry.New(Bitstream(WriteFile("src", ".mock2"))), nullptr);
+  EXPECT_EQ(registry.Size(), 2);
+}
+
+TEST_F(DeviceRegistryTest, RegisterWithShortMagicFails) {
+  DeviceRegistry registry;
+
+  EXPECT_DEATH(registry.Register("mock", "MO", &MockDevice::New),
+               "must have at least 4 bytes");
+}
+
+}  // namespace
+}  // namespace fpga::internal
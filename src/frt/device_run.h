@@ -0,0 +1,31 @@
+#ifndef FPGA_RUNTIME_DEVICE_RUN_H_
+#define FPGA_RUNTIME_DEVICE_RUN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fpga {
+namespace internal {
+
+// The commands of one invocation detached from their device by
+// `Device::TakeRun`, which are waited for and timed separately from the
+// commands of invocations enqueued after them.
+class DeviceRun {
+ public:
+  virtual ~DeviceRun() = default;
+
+  // Blocks until the commands finish and their results are in host memory.
+  virtual void Wait() = 0;
+
+  // Return the times of the commands; only valid after `Wait`.
+  virtual int64_t LoadTimeNanoSeconds() const = 0;
+  virtual int64_t ComputeTimeNanoSeconds() const = 0;
+  virtual int64_t StoreTimeNanoSeconds() const = 0;
+  virtual size_t LoadBytes() const = 0;
+  virtual size_t StoreBytes() const = 0;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_DEVICE_RUN_H_
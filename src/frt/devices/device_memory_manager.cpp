@@ -0,0 +1,162 @@
+#include "frt/devices/device_memory_manager.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+DEFINE_uint64(device_memory_budget_mib, 0,
+              "maximum device memory used by buffers of all instances on the "
+              "same device in MiB before buffers of idle instances are "
+              "evicted; 0 is unlimited");
+
+namespace fpga {
+namespace internal {
+
+DeviceMemoryManager& DeviceMemoryManager::Get(const void* device) {
+  static auto* mtx = new std::mutex;
+  static auto* managers =
+      new std::unordered_map<const void*,
+                             std::unique_ptr<DeviceMemoryManager>>;
+  std::lock_guard<std::mutex> lock(*mtx);
+  auto& manager = (*managers)[device];
+  if (manager == nullptr) {
+    manager = std::make_unique<DeviceMemoryManager>(
+        FLAGS_device_memory_budget_mib << 20);
+  }
+  return *manager;
+}
+
+DeviceMemoryManager::DeviceMemoryManager(size_t budget_bytes)
+    : budget_bytes_(budget_bytes) {}
+
+bool DeviceMemoryManager::MakeRoom(size_t size) {
+  if (budget_bytes_ == 0) return true;
+  std::lock_guard<std::mutex> lock(mtx_);
+  const auto fits = [&] { return current_bytes_ + size <= budget_bytes_; };
+  if (const size_t evicted_bytes = EvictLocked(fits); evicted_bytes != 0) {
+    VLOG(1) << "Evicted " << evicted_bytes << " bytes of idle device buffers";
+  }
+  if (fits()) return true;
+  LOG_FIRST_N(WARNING, 1) << "Allocating " << size << " bytes on top of "
+                          << current_bytes_
+                          << " bytes exceeds --device_memory_budget_mib, but "
+                             "no idle buffers are left to evict";
+  return false;
+}
+
+size_t DeviceMemoryManager::EvictIdle() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return EvictLocked([] { return false; });
+}
+
+int64_t DeviceMemoryManager::Add(const void* owner, int bank, size_t size,
+                                 Evictor evict) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  const int64_t id = next_id_++;
+  allocations_.emplace(
+      id, Allocation{owner, bank, size, std::move(evict),
+                     lru_.insert(lru_.end(), id)});
+  Usage& usage = owners_[owner];
+  usage.current_bytes += size;
+  usage.peak_bytes = std::max(usage.peak_bytes, usage.current_bytes);
+  usage.bank_bytes[bank] += size;
+  current_bytes_ += size;
+  peak_bytes_ = std::max(peak_bytes_, current_bytes_);
+  return id;
+}
+
+void DeviceMemoryManager::Remove(int64_t id) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (auto it = allocations_.find(id); it != allocations_.end()) {
+    RemoveLocked(it);
+  }
+}
+
+void DeviceMemoryManager::Touch(int64_t id) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (auto it = allocations_.find(id); it != allocations_.end()) {
+    lru_.splice(lru_.end(), lru_, it->second.lru_it);
+  }
+}
+
+void DeviceMemoryManager::Pin(int64_t id) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (auto it = allocations_.find(id); it != allocations_.end()) {
+    it->second.evict = nullptr;
+  }
+}
+
+void DeviceMemoryManager::SetIdle(const void* owner, bool is_idle) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  owners_[owner].is_idle = is_idle;
+}
+
+void DeviceMemoryManager::RemoveOwner(const void* owner) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (auto it = allocations_.begin(); it != allocations_.end();) {
+    if (it->second.owner == owner) {
+      RemoveLocked(it++);
+    } else {
+      ++it;
+    }
+  }
+  owners_.erase(owner);
+}
+
+DeviceMemoryStats DeviceMemoryManager::GetStats(const void* owner) const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  DeviceMemoryStats stats;
+  if (auto it = owners_.find(owner); it != owners_.end()) {
+    const Usage& usage = it->second;
+    stats.current_bytes = usage.current_bytes;
+    stats.peak_bytes = usage.peak_bytes;
+    stats.bank_bytes = usage.bank_bytes;
+    stats.evictions = usage.evictions;
+    stats.evicted_bytes = usage.evicted_bytes;
+  }
+  stats.device_current_bytes = current_bytes_;
+  stats.device_peak_bytes = peak_bytes_;
+  stats.device_budget_bytes = budget_bytes_;
+  return stats;
+}
+
+size_t DeviceMemoryManager::EvictLocked(
+    const std::function<bool()>& should_stop) {
+  size_t evicted_bytes = 0;
+  for (auto lru_it = lru_.begin(); lru_it != lru_.end() && !should_stop();) {
+    auto it = allocations_.find(*lru_it++);
+    if (it->second.evict == nullptr || !owners_[it->second.owner].is_idle) {
+      continue;
+    }
+    Allocation allocation = RemoveLocked(it);
+    Usage& usage = owners_[allocation.owner];
+    ++usage.evictions;
+    usage.evicted_bytes += allocation.size;
+    evicted_bytes += allocation.size;
+    allocation.evict();
+  }
+  return evicted_bytes;
+}
+
+DeviceMemoryManager::Allocation DeviceMemoryManager::RemoveLocked(
+    std::unordered_map<int64_t, Allocation>::iterator it) {
+  Allocation allocation = std::move(it->second);
+  allocations_.erase(it);
+  lru_.erase(allocation.lru_it);
+  Usage& usage = owners_[allocation.owner];
+  usage.current_bytes -= allocation.size;
+  if ((usage.bank_bytes[allocation.bank] -= allocation.size) == 0) {
+    usage.bank_bytes.erase(allocation.bank);
+  }
+  current_bytes_ -= allocation.size;
+  return allocation;
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,117 @@
+#ifndef FPGA_RUNTIME_DEVICE_MEMORY_MANAGER_H_
+#define FPGA_RUNTIME_DEVICE_MEMORY_MANAGER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "frt/device_memory_stats.h"
+
+namespace fpga {
+namespace internal {
+
+// Thread-safe accounting of the memory allocated on a device by its owners,
+// i.e., the devices of instances. Allocations are kept in least-recently-used
+// order, so that those of idle owners can be evicted to keep the total within
+// a budget instead of failing to allocate once the device is full.
+//
+// An owner is idle from `Finish`, or from waiting for its last run in flight,
+// until it next touches its buffers. Evicting an allocation calls back into
+// its owner, with the manager locked, from the thread allocating; owners must
+// therefore mark themselves busy with `SetIdle(owner, false)` before touching
+// their buffers, and their callbacks must not call the manager.
+class DeviceMemoryManager {
+ public:
+  // Frees an allocation and forgets it on the owner's side.
+  using Evictor = std::function<void()>;
+
+  // Returns the process-wide manager of `device`, e.g., a `cl_device_id`,
+  // configured by `--device_memory_budget_mib`.
+  static DeviceMemoryManager& Get(const void* device);
+
+  // Keeps allocations within `budget_bytes` where possible; 0 is unlimited.
+  explicit DeviceMemoryManager(size_t budget_bytes);
+  DeviceMemoryManager(const DeviceMemoryManager&) = delete;
+  DeviceMemoryManager& operator=(const DeviceMemoryManager&) = delete;
+  DeviceMemoryManager(DeviceMemoryManager&&) = delete;
+  DeviceMemoryManager& operator=(DeviceMemoryManager&&) = delete;
+
+  // Evicts allocations of idle owners, least recently used first, until
+  // `size` more bytes fit in the budget. Returns false if they do not fit
+  // after evicting all of them.
+  bool MakeRoom(size_t size);
+
+  // Evicts all allocations of idle owners regardless of the budget, e.g., after
+  // the vendor runtime failed to allocate. Returns the number of bytes freed.
+  size_t EvictIdle();
+
+  // Records `size` bytes allocated by `owner` in memory bank `bank` as the
+  // most recently used allocation and returns its id. Allocations without an
+  // `evict` callback are never evicted.
+  int64_t Add(const void* owner, int bank, size_t size, Evictor evict);
+
+  // Forgets allocation `id` freed by its owner.
+  void Remove(int64_t id);
+
+  // Marks allocation `id` the most recently used one.
+  void Touch(int64_t id);
+
+  // Makes allocation `id` never evicted, e.g., because the device has
+  // contents that the host does not.
+  void Pin(int64_t id);
+
+  // Sets whether allocations of `owner` may be evicted.
+  void SetIdle(const void* owner, bool is_idle);
+
+  // Forgets all allocations of `owner` without evicting them.
+  void RemoveOwner(const void* owner);
+
+  // Returns the usage of `owner` and of the whole device.
+  DeviceMemoryStats GetStats(const void* owner) const;
+
+ private:
+  struct Allocation {
+    const void* owner;
+    int bank;
+    size_t size;
+    Evictor evict;
+    // Position in `lru_`.
+    std::list<int64_t>::iterator lru_it;
+  };
+  struct Usage {
+    bool is_idle = false;
+    size_t current_bytes = 0;
+    size_t peak_bytes = 0;
+    std::map<int, size_t> bank_bytes;
+    int64_t evictions = 0;
+    size_t evicted_bytes = 0;
+  };
+
+  // Evicts the least recently used allocations of idle owners until
+  // `should_stop` returns true. Returns the number of bytes freed.
+  size_t EvictLocked(const std::function<bool()>& should_stop);
+  // Forgets allocation `it` and returns it.
+  Allocation RemoveLocked(
+      std::unordered_map<int64_t, Allocation>::iterator it);
+
+  const size_t budget_bytes_;
+
+  mutable std::mutex mtx_;
+  int64_t next_id_ = 0;
+  std::unordered_map<int64_t, Allocation> allocations_;
+  // Ids of allocations, least recently used first.
+  std::list<int64_t> lru_;
+  std::unordered_map<const void*, Usage> owners_;
+  size_t current_bytes_ = 0;
+  size_t peak_bytes_ = 0;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_DEVICE_MEMORY_MANAGER_H_
@@ -0,0 +1,77 @@
+#include "frt/devices/device_memory_manager.h"
+
+#include <cstdint>
+
+#include <map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace internal {
+namespace {
+
+TEST(DeviceMemoryManagerTest, TracksUsagePerOwnerAndBank) {
+  DeviceMemoryManager manager(/*budget_bytes=*/0);
+  const int owner1 = 0, owner2 = 0;
+
+  const int64_t id = manager.Add(&owner1, /*bank=*/0, 100, nullptr);
+  manager.Add(&owner1, /*bank=*/1, 200, nullptr);
+  manager.Add(&owner2, /*bank=*/-1, 400, nullptr);
+  manager.Remove(id);
+  const auto stats = manager.GetStats(&owner1);
+
+  EXPECT_EQ(stats.current_bytes, 200);
+  EXPECT_EQ(stats.peak_bytes, 300);
+  EXPECT_EQ(stats.bank_bytes, (std::map<int, size_t>{{1, 200}}));
+  EXPECT_EQ(stats.device_current_bytes, 600);
+  EXPECT_EQ(stats.device_peak_bytes, 700);
+  EXPECT_EQ(stats.device_budget_bytes, 0);
+}
+
+TEST(DeviceMemoryManagerTest, EvictsLeastRecentlyUsedIdleAllocations) {
+  DeviceMemoryManager manager(/*budget_bytes=*/1000);
+  const int idle_owner = 0, busy_owner = 0;
+  std::vector<int> evicted;
+  const auto evict = [&evicted](int i) {
+    return [&evicted, i] { evicted.push_back(i); };
+  };
+  const int64_t id0 = manager.Add(&idle_owner, /*bank=*/0, 300, evict(0));
+  manager.Add(&busy_owner, /*bank=*/0, 300, evict(1));
+  manager.Add(&idle_owner, /*bank=*/0, 300, evict(2));
+  manager.Touch(id0);
+  manager.SetIdle(&idle_owner, true);
+
+  EXPECT_TRUE(manager.MakeRoom(100));
+  EXPECT_TRUE(evicted.empty());
+  EXPECT_TRUE(manager.MakeRoom(300));
+  EXPECT_EQ(evicted, std::vector<int>({2}));
+  EXPECT_FALSE(manager.MakeRoom(800));
+  EXPECT_EQ(evicted, std::vector<int>({2, 0}));
+
+  const auto stats = manager.GetStats(&idle_owner);
+  EXPECT_EQ(stats.current_bytes, 0);
+  EXPECT_EQ(stats.evictions, 2);
+  EXPECT_EQ(stats.evicted_bytes, 600);
+  EXPECT_EQ(stats.device_current_bytes, 300);
+}
+
+TEST(DeviceMemoryManagerTest, EvictIdleIgnoresBudgetButNotPins) {
+  DeviceMemoryManager manager(/*budget_bytes=*/0);
+  const int owner = 0;
+  int evictions = 0;
+  manager.Add(&owner, /*bank=*/-1, 100, [&evictions] { ++evictions; });
+  manager.Add(&owner, /*bank=*/-1, 200, nullptr);
+  manager.Pin(manager.Add(&owner, /*bank=*/-1, 400, [] { FAIL(); }));
+
+  EXPECT_EQ(manager.EvictIdle(), 0);
+  manager.SetIdle(&owner, true);
+  EXPECT_EQ(manager.EvictIdle(), 100);
+  EXPECT_EQ(evictions, 1);
+  manager.RemoveOwner(&owner);
+  EXPECT_EQ(manager.GetStats(&owner).device_current_bytes, 0);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace fpga
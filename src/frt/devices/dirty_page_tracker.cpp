@@ -0,0 +1,219 @@
+#include "frt/devices/dirty_page_tracker.h"
+
+#include <csignal>
+#include <cstdint>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+// Returns whether all of [begin, end) is mapped writable, according to
+// /proc/self/maps, which lists mappings in ascending address order.
+bool IsWritable(const char* begin, const char* end) {
+  std::ifstream maps("/proc/self/maps");
+  uintptr_t covered = reinterpret_cast<uintptr_t>(begin);
+  for (std::string line; covered < reinterpret_cast<uintptr_t>(end) &&
+                         std::getline(maps, line);) {
+    std::istringstream fields(line);
+    uintptr_t map_begin, map_end;
+    char dash;
+    std::string perms;
+    if (!(fields >> std::hex >> map_begin >> dash >> map_end >> perms) ||
+        map_end <= covered) {
+      continue;
+    }
+    if (map_begin > covered || perms.size() < 2 || perms[1] != 'w') {
+      return false;
+    }
+    covered = map_end;
+  }
+  return covered >= reinterpret_cast<uintptr_t>(end);
+}
+
+// Returns the end of the page-aligned part of a buffer starting at `begin`, or
+// `begin` if that part is not writable, so that e.g. a read-only file mapping
+// is never protected and hence never made writable by the destructor.
+char* GetProtectedEnd(char* begin, const char* buffer_end, size_t page_size) {
+  char* const end = std::max(
+      begin, reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(buffer_end) /
+                                     page_size * page_size));
+  return begin != end && IsWritable(begin, end) ? end : begin;
+}
+
+}  // namespace
+
+// Owns the SIGSEGV handler and the trackers it dispatches to. The handler
+// cannot take locks, so trackers live in a fixed array of atomic slots.
+class DirtyPageHandler {
+ public:
+  static constexpr int kMaxTrackers = 1024;
+
+  static void Register(DirtyPageTracker* tracker) {
+    static std::once_flag once;
+    std::call_once(once, [] {
+      struct sigaction action = {};
+      action.sa_sigaction = &Handle;
+      action.sa_flags = SA_SIGINFO | SA_RESTART;
+      sigemptyset(&action.sa_mask);
+      PLOG_IF(FATAL, sigaction(SIGSEGV, &action, &previous_action_) != 0)
+          << "Cannot install the SIGSEGV handler for dirty page tracking";
+    });
+    for (auto& slot : trackers_) {
+      DirtyPageTracker* expected = nullptr;
+      if (slot.compare_exchange_strong(expected, tracker)) {
+        return;
+      }
+    }
+    LOG(FATAL) << "Cannot track more than " << kMaxTrackers << " buffers";
+  }
+
+  static void Unregister(DirtyPageTracker* tracker) {
+    for (auto& slot : trackers_) {
+      DirtyPageTracker* expected = tracker;
+      if (slot.compare_exchange_strong(expected, nullptr)) {
+        return;
+      }
+    }
+  }
+
+ private:
+  static void Handle(int sig, siginfo_t* info, void* context) {
+    for (auto& slot : trackers_) {
+      DirtyPageTracker* tracker = slot.load(std::memory_order_acquire);
+      if (tracker != nullptr && tracker->MarkDirty(info->si_addr)) {
+        return;
+      }
+    }
+
+    // Not a tracked page.
+    if (previous_action_.sa_flags & SA_SIGINFO) {
+      previous_action_.sa_sigaction(sig, info, context);
+    } else if (previous_action_.sa_handler != SIG_DFL &&
+               previous_action_.sa_handler != SIG_IGN) {
+      previous_action_.sa_handler(sig);
+    } else {
+      // Returning re-executes the faulting instruction, which now gets the
+      // default action.
+      signal(sig, SIG_DFL);
+    }
+  }
+
+  static inline std::atomic<DirtyPageTracker*> trackers_[kMaxTrackers] = {};
+  static inline struct sigaction previous_action_ = {};
+};
+
+DirtyPageTracker::DirtyPageTracker(void* ptr, size_t size)
+    : ptr_(static_cast<char*>(ptr)),
+      size_(size),
+      page_size_(sysconf(_SC_PAGESIZE)),
+      protected_begin_(reinterpret_cast<char*>(
+          (reinterpret_cast<uintptr_t>(ptr_) + page_size_ - 1) / page_size_ *
+          page_size_)),
+      protected_end_(GetProtectedEnd(protected_begin_, ptr_ + size_,
+                                     page_size_)) {
+  const size_t page_count = (protected_end_ - protected_begin_) / page_size_;
+  is_dirty_ = std::make_unique<std::atomic<bool>[]>(page_count);
+  for (size_t i = 0; i < page_count; ++i) {
+    is_dirty_[i] = true;
+  }
+  DirtyPageHandler::Register(this);
+}
+
+DirtyPageTracker::~DirtyPageTracker() {
+  // Unregisters first so that faults from now on no longer reach this tracker.
+  // A fault being handled on another thread may still have loaded the slot
+  // before the CAS in `Unregister` completed; the buffer must therefore not be
+  // written while its tracker is destroyed.
+  DirtyPageHandler::Unregister(this);
+  if (protected_begin_ != protected_end_) {
+    PLOG_IF(ERROR, mprotect(protected_begin_, protected_end_ - protected_begin_,
+                            PROT_READ | PROT_WRITE) != 0)
+        << "Cannot unprotect tracked buffer";
+  }
+}
+
+std::vector<ByteRange> DirtyPageTracker::TakeDirtyRanges(size_t offset,
+                                                         size_t size) {
+  CHECK_LE(offset, size_) << "range is out of bounds";
+  CHECK_LE(size, size_ - offset) << "range is out of bounds";
+  char* const begin = ptr_ + offset;
+  char* const end = begin + size;
+
+  std::vector<ByteRange> ranges;
+  const auto add_range = [&](char* range_begin, char* range_end) {
+    range_begin = std::max(range_begin, begin);
+    range_end = std::min(range_end, end);
+    if (range_begin >= range_end) return;
+    const size_t range_offset = range_begin - ptr_;
+    if (!ranges.empty() &&
+        ranges.back().offset + ranges.back().size == range_offset) {
+      ranges.back().size += range_end - range_begin;
+    } else {
+      ranges.push_back({range_offset, size_t(range_end - range_begin)});
+    }
+  };
+
+  add_range(ptr_, protected_begin_);
+  const size_t page_count = (protected_end_ - protected_begin_) / page_size_;
+  for (size_t i = 0; i < page_count;) {
+    char* const page = protected_begin_ + i * page_size_;
+    if (page + page_size_ <= begin || page >= end || !is_dirty_[i]) {
+      ++i;
+      continue;
+    }
+    // Finds the run of dirty pages, clearing flags before protecting pages
+    // so that a write in between is either uploaded now or faults later.
+    size_t run_end = i;
+    size_t clean_begin = page_count;
+    size_t clean_end = 0;
+    for (; run_end < page_count && is_dirty_[run_end]; ++run_end) {
+      char* const run_page = protected_begin_ + run_end * page_size_;
+      if (run_page >= end) break;
+      if (run_page >= begin && run_page + page_size_ <= end) {
+        is_dirty_[run_end] = false;
+        clean_begin = std::min(clean_begin, run_end);
+        clean_end = run_end + 1;
+      }
+    }
+    if (clean_begin < clean_end) {
+      PLOG_IF(FATAL, mprotect(protected_begin_ + clean_begin * page_size_,
+                              (clean_end - clean_begin) * page_size_,
+                              PROT_READ) != 0)
+          << "Cannot write-protect tracked buffer";
+    }
+    add_range(page, protected_begin_ + run_end * page_size_);
+    i = run_end;
+  }
+  add_range(protected_end_, ptr_ + size_);
+  return ranges;
+}
+
+bool DirtyPageTracker::MarkDirty(const void* addr) {
+  const char* const byte = static_cast<const char*>(addr);
+  if (byte < protected_begin_ || byte >= protected_end_) {
+    return false;
+  }
+  const size_t i = (byte - protected_begin_) / page_size_;
+  // Unprotects before marking; see `TakeDirtyRanges`.
+  mprotect(protected_begin_ + i * page_size_, page_size_,
+           PROT_READ | PROT_WRITE);
+  is_dirty_[i] = true;
+  return true;
+}
+
+}  // namespace internal
+}  // namespace fpga
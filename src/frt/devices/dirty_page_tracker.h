@@ -0,0 +1,73 @@
+#ifndef FPGA_RUNTIME_DIRTY_PAGE_TRACKER_H_
+#define FPGA_RUNTIME_DIRTY_PAGE_TRACKER_H_
+
+#include <cstddef>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace fpga {
+namespace internal {
+
+// A range of bytes relative to the beginning of a buffer.
+struct ByteRange {
+  size_t offset;
+  size_t size;
+};
+
+// Tracks which pages of a host buffer are written, so that unchanged pages
+// need not be transferred again. Pages are write-protected with `mprotect`;
+// the first write to a page after `TakeDirtyRanges` faults, and a process-wide
+// SIGSEGV handler marks the page dirty and makes it writable again. Faults
+// outside tracked buffers are passed on to the previous handler.
+//
+// Partial pages at either end of the buffer are never protected, so they are
+// always dirty, and neither is a buffer that is not entirely writable, e.g., a
+// read-only file mapping, which is always dirty as a whole.
+//
+// The buffer must not be freed while tracked. Nor may the kernel write to it,
+// e.g., by `read(2)`, `recv`, or `fread` into it: such system calls fail with
+// EFAULT on protected pages instead of faulting. Write to another buffer and
+// copy instead.
+class DirtyPageTracker {
+ public:
+  // Starts tracking `size` bytes at `ptr`, all of which are initially dirty.
+  DirtyPageTracker(void* ptr, size_t size);
+  DirtyPageTracker(const DirtyPageTracker&) = delete;
+  DirtyPageTracker& operator=(const DirtyPageTracker&) = delete;
+  DirtyPageTracker(DirtyPageTracker&&) = delete;
+  DirtyPageTracker& operator=(DirtyPageTracker&&) = delete;
+  // Stops tracking and makes protected pages writable again.
+  ~DirtyPageTracker();
+
+  void* Get() const { return ptr_; }
+  size_t Size() const { return size_; }
+
+  // Returns the dirty parts of `size` bytes at `offset`, merged and sorted,
+  // and marks pages entirely within them clean. Pages only partially within
+  // them stay dirty, so that their other parts are not missed.
+  std::vector<ByteRange> TakeDirtyRanges(size_t offset, size_t size);
+
+ private:
+  friend class DirtyPageHandler;
+
+  // Marks the page of `addr` dirty if it is protected by this tracker.
+  // Called from the signal handler.
+  bool MarkDirty(const void* addr);
+
+  char* const ptr_;
+  const size_t size_;
+  const size_t page_size_;
+  // Page-aligned part of the buffer that is write-protected; empty if the
+  // buffer is not writable.
+  char* const protected_begin_;
+  char* const protected_end_;
+  // One flag per protected page.
+  std::unique_ptr<std::atomic<bool>[]> is_dirty_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_DIRTY_PAGE_TRACKER_H_
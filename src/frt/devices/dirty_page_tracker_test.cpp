@@ -0,0 +1,121 @@
+#include "frt/devices/dirty_page_tracker.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <ostream>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace fpga::internal {
+
+// Found by argument-dependent lookup, so not in the anonymous namespace.
+bool operator==(const ByteRange& lhs, const ByteRange& rhs) {
+  return lhs.offset == rhs.offset && lhs.size == rhs.size;
+}
+
+std::ostream& operator<<(std::ostream& os, const ByteRange& range) {
+  return os << "[" << range.offset << ", +" << range.size << ")";
+}
+
+namespace {
+
+class DirtyPageTrackerTest : public testing::Test {
+ protected:
+  static constexpr size_t kPageCount = 16;
+
+  void SetUp() override {
+    page_size_ = sysconf(_SC_PAGESIZE);
+    buffer_ = static_cast<char*>(
+        aligned_alloc(page_size_, kPageCount * page_size_));
+    ASSERT_NE(buffer_, nullptr);
+  }
+
+  void TearDown() override { free(buffer_); }
+
+  size_t page_size_;
+  char* buffer_;
+};
+
+TEST_F(DirtyPageTrackerTest, TakeDirtyRangesReturnsWrittenPages) {
+  const size_t size = kPageCount * page_size_;
+  DirtyPageTracker tracker(buffer_, size);
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size),
+            std::vector<ByteRange>({{0, size}}));
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size), std::vector<ByteRange>());
+
+  buffer_[3 * page_size_] = 1;
+  buffer_[5 * page_size_ - 1] = 1;
+  buffer_[10 * page_size_ + 42] = 1;
+
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size),
+            std::vector<ByteRange>({{3 * page_size_, 2 * page_size_},
+                                    {10 * page_size_, page_size_}}));
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size), std::vector<ByteRange>());
+}
+
+TEST_F(DirtyPageTrackerTest, PartialPagesAreAlwaysDirty) {
+  const size_t offset = 100;
+  const size_t size = 4 * page_size_;
+  DirtyPageTracker tracker(buffer_ + offset, size);
+  tracker.TakeDirtyRanges(0, size);
+
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size),
+            std::vector<ByteRange>({{0, page_size_ - offset},
+                                    {4 * page_size_ - offset, offset}}));
+}
+
+TEST_F(DirtyPageTrackerTest, PagesPartiallyInRangeStayDirty) {
+  const size_t size = kPageCount * page_size_;
+  DirtyPageTracker tracker(buffer_, size);
+  tracker.TakeDirtyRanges(0, size);
+  buffer_[2 * page_size_] = 1;
+
+  EXPECT_EQ(tracker.TakeDirtyRanges(2 * page_size_ + 10, 100),
+            std::vector<ByteRange>({{2 * page_size_ + 10, 100}}));
+  EXPECT_EQ(tracker.TakeDirtyRanges(0, size),
+            std::vector<ByteRange>({{2 * page_size_, page_size_}}));
+}
+
+TEST_F(DirtyPageTrackerTest, DestructorRestoresWriteAccess) {
+  {
+    DirtyPageTracker tracker(buffer_, kPageCount * page_size_);
+    tracker.TakeDirtyRanges(0, kPageCount * page_size_);
+  }
+
+  memset(buffer_, 0, kPageCount * page_size_);
+}
+
+TEST_F(DirtyPageTrackerTest, ReadOnlyBuffersStayReadOnly) {
+  const size_t size = kPageCount * page_size_;
+  void* read_only = mmap(nullptr, size, PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(read_only, MAP_FAILED);
+  {
+    DirtyPageTracker tracker(read_only, size);
+    tracker.TakeDirtyRanges(0, size);
+    EXPECT_EQ(tracker.TakeDirtyRanges(0, size),
+              std::vector<ByteRange>({{0, size}}));
+  }
+
+  EXPECT_DEATH(*static_cast<volatile char*>(read_only) = 1, "");
+  munmap(read_only, size);
+}
+
+TEST_F(DirtyPageTrackerTest, UntrackedFaultsAreNotHandled) {
+  DirtyPageTracker tracker(buffer_, kPageCount * page_size_);
+  tracker.TakeDirtyRanges(0, kPageCount * page_size_);
+  void* other = mmap(nullptr, page_size_, PROT_READ,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(other, MAP_FAILED);
+
+  EXPECT_DEATH(*static_cast<volatile char*>(other) = 1, "");
+  munmap(other, page_size_);
+}
+
+}  // namespace
+}  // namespace fpga::internal
@@ -0,0 +1,158 @@
+#include "frt/devices/file_cache.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fpga::internal {
+
+namespace {
+
+constexpr uint64_t kMul = 0x9e3779b97f4a7c15ULL;
+
+bool MakeDirectories(const std::string& path) {
+  for (size_t pos = 1; pos != std::string::npos;) {
+    pos = path.find('/', pos + 1);
+    const std::string prefix = path.substr(0, pos);
+    if (mkdir(prefix.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t Load64(const char* ptr) {
+  uint64_t word;
+  memcpy(&word, ptr, sizeof(word));
+  return word;
+}
+
+uint64_t Mix(uint64_t hash, uint64_t word) {
+  word *= 0xff51afd7ed558ccdULL;
+  word ^= word >> 32;
+  hash = (hash ^ word) * kMul;
+  return (hash << 31) | (hash >> 33);
+}
+
+}  // namespace
+
+std::string GetCacheDirectory(std::string_view subdir) {
+  std::string dir;
+  if (const char* frt_cache_dir = getenv("FRT_CACHE_DIR")) {
+    dir = frt_cache_dir;
+    if (dir.empty()) return "";
+  } else if (const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+             xdg_cache_home != nullptr && *xdg_cache_home != '\0') {
+    dir = std::string(xdg_cache_home) + "/frt";
+  } else if (const char* home = getenv("HOME");
+             home != nullptr && *home != '\0') {
+    dir = std::string(home) + "/.cache/frt";
+  } else {
+    return "";
+  }
+  dir += '/';
+  dir += subdir;
+  return MakeDirectories(dir) ? dir : "";
+}
+
+bool ReadCacheFile(const std::string& path, std::string& content) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  content.clear();
+  char buf[1 << 16];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    content.append(buf, n);
+  }
+  close(fd);
+  return n == 0;
+}
+
+bool WriteCacheFile(const std::string& path, std::string_view content) {
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                S_IRUSR | S_IWUSR);
+  if (fd < 0) return false;
+  bool ok = true;
+  while (!content.empty()) {
+    ssize_t n = write(fd, content.data(), content.size());
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ok = false;
+      break;
+    }
+    content.remove_prefix(n);
+  }
+  ok = close(fd) == 0 && ok;
+  // `rename` replaces the destination atomically.
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string GetFileStamp(const std::string& path) {
+  struct stat stat_buf;
+  if (stat(path.c_str(), &stat_buf) != 0) return "";
+  return std::to_string(stat_buf.st_dev) + ":" +
+         std::to_string(stat_buf.st_ino) + ":" +
+         std::to_string(stat_buf.st_size) + ":" +
+         std::to_string(stat_buf.st_mtim.tv_sec) + "." +
+         std::to_string(stat_buf.st_mtim.tv_nsec);
+}
+
+uint64_t Fingerprint(std::string_view data) {
+  // Four independent lanes keep the multipliers busy on large inputs.
+  uint64_t lanes[4] = {data.size(), data.size() * kMul, ~data.size(),
+                       data.size() ^ kMul};
+  const char* ptr = data.data();
+  size_t size = data.size();
+  for (; size >= 32; ptr += 32, size -= 32) {
+    for (int i = 0; i < 4; ++i) {
+      lanes[i] = Mix(lanes[i], Load64(ptr + i * 8));
+    }
+  }
+  for (; size >= 8; ptr += 8, size -= 8) {
+    lanes[0] = Mix(lanes[0], Load64(ptr));
+  }
+  if (size > 0) {
+    uint64_t tail = 0;
+    memcpy(&tail, ptr, size);
+    lanes[1] = Mix(lanes[1], tail);
+  }
+  uint64_t hash = lanes[0];
+  for (int i = 1; i < 4; ++i) {
+    hash = Mix(hash, lanes[i]);
+  }
+  // MurmurHash3 finalizer.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+std::string FingerprintToString(uint64_t fingerprint) {
+  constexpr char kDigits[] = "0123456789abcdef";
+  std::string text(16, '0');
+  for (int i = 15; i >= 0; --i, fingerprint >>= 4) {
+    text[i] = kDigits[fingerprint & 0xf];
+  }
+  return text;
+}
+
+}  // namespace fpga::internal
@@ -0,0 +1,38 @@
+#ifndef FPGA_RUNTIME_FILE_CACHE_H_
+#define FPGA_RUNTIME_FILE_CACHE_H_
+
+#include <cstdint>
+
+#include <string>
+#include <string_view>
+
+namespace fpga::internal {
+
+// Returns `subdir` under the per-user FRT cache directory, creating it if
+// necessary. The cache directory is `$FRT_CACHE_DIR`, `$XDG_CACHE_HOME/frt`,
+// or `$HOME/.cache/frt`, in that order. Returns an empty string if caching is
+// disabled (i.e., `FRT_CACHE_DIR` is set but empty) or the directory cannot be
+// created.
+std::string GetCacheDirectory(std::string_view subdir);
+
+// Reads the whole file at `path` into `content`. Returns false if the file
+// cannot be read.
+bool ReadCacheFile(const std::string& path, std::string& content);
+
+// Replaces the file at `path` with `content` atomically, so concurrent readers
+// see either the old or the new content. Returns false on failure.
+bool WriteCacheFile(const std::string& path, std::string_view content);
+
+// Returns a string identifying the inode and modification time of `path`, or
+// an empty string if `path` does not exist.
+std::string GetFileStamp(const std::string& path);
+
+// Returns a 64-bit fingerprint of `data` that is stable across processes.
+uint64_t Fingerprint(std::string_view data);
+
+// Returns the fingerprint as 16 hexadecimal digits.
+std::string FingerprintToString(uint64_t fingerprint);
+
+}  // namespace fpga::internal
+
+#endif  // FPGA_RUNTIME_FILE_CACHE_H_
@@ -0,0 +1,45 @@
+#ifndef FPGA_RUNTIME_FINISHED_RUN_H_
+#define FPGA_RUNTIME_FINISHED_RUN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "frt/device.h"
+#include "frt/device_run.h"
+
+namespace fpga {
+namespace internal {
+
+// A run of a backend that cannot keep several invocations in flight, which
+// finishes the device when taken and keeps a copy of its times.
+class FinishedRun : public DeviceRun {
+ public:
+  explicit FinishedRun(Device& device) {
+    device.Finish();
+    load_time_ns_ = device.LoadTimeNanoSeconds();
+    compute_time_ns_ = device.ComputeTimeNanoSeconds();
+    store_time_ns_ = device.StoreTimeNanoSeconds();
+    load_bytes_ = device.LoadBytes();
+    store_bytes_ = device.StoreBytes();
+  }
+
+  void Wait() override {}
+
+  int64_t LoadTimeNanoSeconds() const override { return load_time_ns_; }
+  int64_t ComputeTimeNanoSeconds() const override { return compute_time_ns_; }
+  int64_t StoreTimeNanoSeconds() const override { return store_time_ns_; }
+  size_t LoadBytes() const override { return load_bytes_; }
+  size_t StoreBytes() const override { return store_bytes_; }
+
+ private:
+  int64_t load_time_ns_;
+  int64_t compute_time_ns_;
+  int64_t store_time_ns_;
+  size_t load_bytes_;
+  size_t store_bytes_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_FINISHED_RUN_H_
@@ -0,0 +1,186 @@
+#include "frt/devices/generic_opencl_device.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <CL/cl2.hpp>
+
+#include "frt/arg_info.h"
+#include "frt/devices/metadata_cache.h"
+#include "frt/devices/opencl_device_matcher.h"
+#include "frt/devices/opencl_inventory.h"
+#include "frt/devices/opencl_util.h"
+#include "frt/stream_wrapper.h"
+#include "frt/tag.h"
+
+DEFINE_string(generic_opencl_platform, "",
+              "if not empty, run OpenCL C source and SPIR binaries only on the "
+              "platform with this name");
+DEFINE_string(generic_opencl_device, "",
+              "if not empty, run OpenCL C source and SPIR binaries only on "
+              "devices whose name contains this string");
+DEFINE_string(generic_opencl_build_options, "",
+              "options for building OpenCL C source and SPIR binaries");
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+class DeviceMatcher : public OpenclDeviceMatcher {
+ public:
+  std::string GetTargetName() const override {
+    return FLAGS_generic_opencl_device.empty() ? "any"
+                                               : FLAGS_generic_opencl_device;
+  }
+
+  cl_device_type GetDeviceType() const override { return CL_DEVICE_TYPE_ALL; }
+
+  std::string Match(const OpenclDeviceEntry& device) const override {
+    if (device.name.find(FLAGS_generic_opencl_device) != std::string::npos) {
+      return device.name;
+    }
+    return "";
+  }
+};
+
+ArgInfo::Cat GetArgCat(cl_kernel_arg_address_qualifier qualifier) {
+  switch (qualifier) {
+    case CL_KERNEL_ARG_ADDRESS_GLOBAL:
+    case CL_KERNEL_ARG_ADDRESS_CONSTANT:
+      return ArgInfo::kMmap;
+    case CL_KERNEL_ARG_ADDRESS_PRIVATE:
+      return ArgInfo::kScalar;
+    default:
+      LOG(FATAL) << "Unsupported address qualifier: " << qualifier;
+  }
+  return ArgInfo::kScalar;
+}
+
+}  // namespace
+
+GenericOpenclDevice::GenericOpenclDevice(const Bitstream& bitstream)
+    : is_source_(bitstream.Header().substr(0, kSpirMagic.size()) !=
+                 kSpirMagic) {
+  LOG(INFO) << "Running " << (is_source_ ? "OpenCL C source" : "SPIR binary")
+            << " with generic OpenCL";
+  Initialize(bitstream, FLAGS_generic_opencl_platform,
+             DeviceMatcher(), /*kernel_names=*/{}, /*kernel_arg_counts=*/{});
+
+  // Kernels and their arguments are only known after the program is built.
+  const KernelMetadata metadata =
+      GetKernelMetadata("generic", GetCachedProgramId(bitstream),
+                        [this] { return ParseMetadata(); });
+  for (const auto& arg : metadata.args) {
+    arg_table_[arg.index] = arg;
+  }
+  SetKernelNames(metadata.kernel_names, metadata.kernel_arg_counts);
+  LOG_IF(FATAL, kernel_names_.empty()) << "No kernel found";
+  startup_phases_.Record("metadata");
+}
+
+std::unique_ptr<Device> GenericOpenclDevice::New(const Bitstream& bitstream) {
+  const std::string& path = bitstream.Path();
+  if (bitstream.Header().substr(0, kSpirMagic.size()) != kSpirMagic &&
+      (path.size() < kSourceExtension.size() ||
+       path.compare(path.size() - kSourceExtension.size(),
+                    kSourceExtension.size(), kSourceExtension) != 0)) {
+    return nullptr;
+  }
+  return std::make_unique<GenericOpenclDevice>(bitstream);
+}
+
+void GenericOpenclDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
+  LOG(FATAL) << "Generic OpenCL device does not support streaming";
+}
+
+KernelMetadata GenericOpenclDevice::ParseMetadata() {
+  KernelMetadata metadata;
+  cl_int err;
+  std::string kernel_names = program_.getInfo<CL_PROGRAM_KERNEL_NAMES>(&err);
+  CL_CHECK(err);
+  int arg_count = 0;
+  for (size_t begin = 0, end; begin < kernel_names.size(); begin = end + 1) {
+    end = kernel_names.find(';', begin);
+    if (end == std::string::npos) end = kernel_names.size();
+    const std::string name = kernel_names.substr(begin, end - begin);
+    if (name.empty()) continue;
+    // Querying the arguments requires a kernel object, which is returned to
+    // the program cache for `GetKernel`.
+    cl::Kernel kernel = cached_program_->AcquireKernel(name);
+    const cl_uint num_args = kernel.getInfo<CL_KERNEL_NUM_ARGS>(&err);
+    CL_CHECK(err);
+    if (num_args == 0) {
+      // Kernels are keyed by the index of their first argument.
+      LOG(WARNING) << "Skipping kernel '" << name << "' without arguments";
+    } else {
+      metadata.kernel_names.push_back(name);
+      metadata.kernel_arg_counts.push_back(arg_count);
+    }
+    for (cl_uint i = 0; i < num_args; ++i) {
+      auto& arg = metadata.args.emplace_back();
+      arg.index = arg_count;
+      ++arg_count;
+      arg.name = kernel.getArgInfo<CL_KERNEL_ARG_NAME>(i, &err);
+      CL_CHECK(err);
+      arg.type = kernel.getArgInfo<CL_KERNEL_ARG_TYPE_NAME>(i, &err);
+      CL_CHECK(err);
+      const cl_kernel_arg_address_qualifier qualifier =
+          kernel.getArgInfo<CL_KERNEL_ARG_ADDRESS_QUALIFIER>(i, &err);
+      CL_CHECK(err);
+      arg.cat = GetArgCat(qualifier);
+    }
+    cached_program_->ReleaseKernel(name, std::move(kernel));
+  }
+  return metadata;
+}
+
+std::string GenericOpenclDevice::GetProgramId(
+    const Bitstream& bitstream) const {
+  return GetBuildOptions() + '\0' + OpenclDevice::GetProgramId(bitstream);
+}
+
+cl::Program GenericOpenclDevice::CreateProgram(const cl::Context& context,
+                                               const cl::Device& device,
+                                               std::string_view binary) const {
+  if (!is_source_) {
+    return OpenclDevice::CreateProgram(context, device, binary);
+  }
+  cl_int err;
+  cl::Program program(context, std::string(binary), /*build=*/false, &err);
+  CL_CHECK(err);
+  if (program.build({device}, GetBuildOptions().c_str()) != CL_SUCCESS) {
+    LOG(FATAL) << "Cannot build OpenCL C source: "
+               << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
+  }
+  return program;
+}
+
+cl::Buffer GenericOpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
+                                             void* host_ptr, size_t size) {
+  // Staged buffers have no host pointer.
+  if (host_ptr != nullptr) {
+    flags |= CL_MEM_USE_HOST_PTR;
+  }
+  return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+}
+
+std::string GenericOpenclDevice::GetBuildOptions() const {
+  // Required by `clGetKernelArgInfo`.
+  std::string options = "-cl-kernel-arg-info";
+  if (!is_source_) {
+    options += " -x spir";
+  }
+  if (!FLAGS_generic_opencl_build_options.empty()) {
+    options += " " + FLAGS_generic_opencl_build_options;
+  }
+  return options;
+}
+
+}  // namespace internal
+}  // namespace fpga
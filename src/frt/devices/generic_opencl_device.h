@@ -0,0 +1,51 @@
+#ifndef FPGA_RUNTIME_GENERIC_OPENCL_DEVICE_H_
+#define FPGA_RUNTIME_GENERIC_OPENCL_DEVICE_H_
+
+#include <cstddef>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <CL/cl2.hpp>
+
+#include "frt/bitstream.h"
+#include "frt/devices/metadata_cache.h"
+#include "frt/devices/opencl_device.h"
+
+namespace fpga {
+namespace internal {
+
+// Runs OpenCL C source (`.cl`) or SPIR 1.2 binaries on any OpenCL platform,
+// e.g., PoCL on the CPU, so that the shared `OpenclDevice` code can be tested
+// and benchmarked without FPGAs.
+class GenericOpenclDevice : public OpenclDevice {
+ public:
+  // Magic signature of SPIR 1.2 binaries, i.e., LLVM bitcode.
+  static constexpr std::string_view kSpirMagic = "BC\xc0\xde";
+  static constexpr std::string_view kSourceExtension = ".cl";
+
+  GenericOpenclDevice(const Bitstream& bitstream);
+
+  static std::unique_ptr<Device> New(const Bitstream& bitstream);
+
+  void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override;
+
+ private:
+  // Queries the kernels and their arguments from the built program.
+  KernelMetadata ParseMetadata();
+  std::string GetProgramId(const Bitstream& bitstream) const override;
+  std::string GetBuildOptions() const override;
+  cl::Program CreateProgram(const cl::Context& context,
+                            const cl::Device& device,
+                            std::string_view binary) const override;
+  cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
+                          size_t size) override;
+
+  const bool is_source_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_GENERIC_OPENCL_DEVICE_H_
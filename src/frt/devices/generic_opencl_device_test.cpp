@@ -0,0 +1,93 @@
+#include "frt/devices/generic_opencl_device.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <CL/cl2.hpp>
+
+#include "frt.h"
+
+namespace fpga::internal {
+namespace {
+
+// Slow enough as a single work-item that reads racing with it would see stale
+// data.
+constexpr std::string_view kVecAddSource = R"(
+__kernel void VecAdd(__global const float* a, __global const float* b,
+                     __global float* c, ulong n) {
+  for (ulong i = 0; i < n; ++i) {
+    c[i] = a[i] + b[i];
+  }
+}
+)";
+
+class GenericOpenclDeviceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    std::vector<cl::Platform> platforms;
+    if (cl::Platform::get(&platforms) != CL_SUCCESS || platforms.empty()) {
+      GTEST_SKIP() << "No OpenCL platform is available";
+    }
+  }
+
+  void TearDown() override {
+    for (const auto& path : paths_) {
+      unlink(path.c_str());
+    }
+  }
+
+  std::string WriteSource(std::string_view content) {
+    std::string path = testing::TempDir() +
+                       "/generic_opencl_device_test.XXXXXX" +
+                       std::string(GenericOpenclDevice::kSourceExtension);
+    close(mkstemps(&path[0], GenericOpenclDevice::kSourceExtension.size()));
+    std::ofstream(path).write(content.data(), content.size());
+    paths_.push_back(path);
+    return path;
+  }
+
+ private:
+  std::vector<std::string> paths_;
+};
+
+TEST_F(GenericOpenclDeviceTest, ReadDeviceBufferWaitsForLaunchedRun) {
+  constexpr uint64_t kN = 1 << 20;
+  std::vector<float, fpga::AlignedAllocator<float>> a(kN, 1);
+  std::vector<float> b(kN, -1);
+  fpga::Instance instance(WriteSource(kVecAddSource));
+  auto sum = instance.CreateDeviceBuffer<float>(kN);
+
+  fpga::Run run = instance.Launch(fpga::WriteOnly(a.data(), kN),
+                                  fpga::WriteOnly(a.data(), kN), sum, kN);
+  instance.ReadDeviceBuffer(sum, b.data());
+
+  EXPECT_EQ(b, std::vector<float>(kN, 2));
+}
+
+TEST_F(GenericOpenclDeviceTest, RunsMayOutliveInstance) {
+  constexpr uint64_t kN = 1 << 20;
+  std::vector<float, fpga::AlignedAllocator<float>> a(kN, 1), c(kN, -1);
+  // Declared before the instance, so destroyed after it.
+  std::vector<fpga::Run> runs;
+  {
+    fpga::Instance instance(WriteSource(kVecAddSource));
+    runs.push_back(instance.Launch(fpga::WriteOnly(a.data(), kN),
+                                   fpga::WriteOnly(a.data(), kN),
+                                   fpga::ReadOnly(c.data(), kN), kN));
+  }
+
+  EXPECT_EQ(c, (std::vector<float, fpga::AlignedAllocator<float>>(kN, 2)));
+  runs.back().Wait();
+  EXPECT_GE(runs.back().ComputeTimeNanoSeconds(), 0);
+}
+
+}  // namespace
+}  // namespace fpga::internal
@@ -1,8 +1,11 @@
 #include "frt/devices/intel_opencl_device.h"
 
+#include <cstdint>
+
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include <elf.h>
 
@@ -10,6 +13,8 @@
 #include <tinyxml.h>
 #include <CL/cl2.hpp>
 
+#include "frt/devices/file_cache.h"
+#include "frt/devices/metadata_cache.h"
 #include "frt/devices/opencl_device_matcher.h"
 #include "frt/devices/opencl_util.h"
 #include "frt/stream_wrapper.h"
@@ -27,9 +32,8 @@ class DeviceMatcher : public OpenclDeviceMatcher {
 
   std::string GetTargetName() const override { return target_device_name_; }
 
-  std::string Match(cl::Device device) const override {
-    const std::string device_name = device.getInfo<CL_DEVICE_NAME>();
-    LOG(INFO) << "Found device: " << device_name;
+  std::string Match(const OpenclDeviceEntry& device) const override {
+    const std::string& device_name = device.name;
 
     // Intel devices contain a std::string that is unavailable from the binary.
     const std::string prefix = target_device_name_ + " : ";
@@ -44,15 +48,54 @@ class DeviceMatcher : public OpenclDeviceMatcher {
   const std::string target_device_name_;
 };
 
+KernelMetadata ParseMetadata(std::string_view kernel_arg_info_xml) {
+  KernelMetadata metadata;
+  int arg_count = 0;
+  TiXmlDocument doc;
+  doc.Parse(std::string(kernel_arg_info_xml).c_str(), 0, TIXML_ENCODING_UTF8);
+  for (auto xml_kernel =
+           doc.FirstChildElement("board")->FirstChildElement("kernel");
+       xml_kernel != nullptr;
+       xml_kernel = xml_kernel->NextSiblingElement("kernel")) {
+    metadata.kernel_names.push_back(xml_kernel->Attribute("name"));
+    metadata.kernel_arg_counts.push_back(arg_count);
+    for (auto xml_arg = xml_kernel->FirstChildElement("argument");
+         xml_arg != nullptr;
+         xml_arg = xml_arg->NextSiblingElement("argument")) {
+      auto& arg = metadata.args.emplace_back();
+      arg.index = arg_count;
+      ++arg_count;
+      arg.name = xml_arg->Attribute("name");
+      arg.type = xml_arg->Attribute("type_name");
+      auto cat = atoi(xml_arg->Attribute("opencl_access_type"));
+      switch (cat) {
+        case 0:
+          arg.cat = ArgInfo::kScalar;
+          break;
+        case 2:
+          arg.cat = ArgInfo::kMmap;
+          break;
+        default:
+          LOG(WARNING) << "Unknown argument category: " << cat;
+      }
+    }
+  }
+  return metadata;
+}
+
+// Transfers use DMA directly on 64-byte aligned host memory and a staging
+// copy otherwise.
+bool IsDmaAligned(const void* host_ptr) {
+  return reinterpret_cast<uintptr_t>(host_ptr) % 64 == 0;
+}
+
 }  // namespace
 
-IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
+IntelOpenclDevice::IntelOpenclDevice(const Bitstream& bitstream) {
   std::string target_device_name;
   std::string vendor_name;
-  std::vector<std::string> kernel_names;
-  std::vector<int> kernel_arg_counts;
-  int arg_count = 0;
-  auto data = binaries.begin()->data();
+  KernelMetadata metadata;
+  auto data = bitstream.Content().data();
   if (data[EI_CLASS] == ELFCLASS32) {
     vendor_name = "Intel(R) FPGA SDK for OpenCL(TM)";
     auto elf_header = reinterpret_cast<const Elf32_Ehdr*>(data);
@@ -66,42 +109,16 @@ IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
             ? nullptr
             : reinterpret_cast<const char*>(elf_header) +
                   elf_section(elf_header->e_shstrndx)->sh_offset;
+    std::string_view kernel_arg_info_xml;
     for (int i = 0; i < elf_header->e_shnum; ++i) {
       auto section_header = elf_section(i);
       auto section_name =
           elf_str_table ? elf_str_table + section_header->sh_name : nullptr;
       if (strcmp(section_name, ".acl.kernel_arg_info.xml") == 0) {
-        TiXmlDocument doc;
-        doc.Parse(reinterpret_cast<const char*>(elf_header) +
-                      section_header->sh_offset,
-                  0, TIXML_ENCODING_UTF8);
-        for (auto xml_kernel =
-                 doc.FirstChildElement("board")->FirstChildElement("kernel");
-             xml_kernel != nullptr;
-             xml_kernel = xml_kernel->NextSiblingElement("kernel")) {
-          kernel_names.push_back(xml_kernel->Attribute("name"));
-          kernel_arg_counts.push_back(arg_count);
-          for (auto xml_arg = xml_kernel->FirstChildElement("argument");
-               xml_arg != nullptr;
-               xml_arg = xml_arg->NextSiblingElement("argument")) {
-            auto& arg = arg_table_[arg_count];
-            arg.index = arg_count;
-            ++arg_count;
-            arg.name = xml_arg->Attribute("name");
-            arg.type = xml_arg->Attribute("type_name");
-            auto cat = atoi(xml_arg->Attribute("opencl_access_type"));
-            switch (cat) {
-              case 0:
-                arg.cat = ArgInfo::kScalar;
-                break;
-              case 2:
-                arg.cat = ArgInfo::kMmap;
-                break;
-              default:
-                LOG(WARNING) << "Unknown argument category: " << cat;
-            }
-          }
-        }
+        kernel_arg_info_xml = std::string_view(
+            reinterpret_cast<const char*>(elf_header) +
+                section_header->sh_offset,
+            section_header->sh_size);
       } else if (strcmp(section_name, ".acl.board") == 0) {
         const std::string board_name(reinterpret_cast<const char*>(elf_header) +
                                          section_header->sh_offset,
@@ -118,9 +135,19 @@ IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
         target_device_name = board_name;
       }
     }
-    if (kernel_names.empty() || target_device_name.empty()) {
+    if (!kernel_arg_info_xml.empty()) {
+      // Only the XML section is parsed, so it alone identifies the metadata.
+      metadata = GetKernelMetadata(
+          "intel", FingerprintToString(Fingerprint(kernel_arg_info_xml)),
+          [kernel_arg_info_xml] { return ParseMetadata(kernel_arg_info_xml); });
+    }
+    if (metadata.kernel_names.empty() || target_device_name.empty()) {
       LOG(FATAL) << "Unexpected ELF file";
     }
+    for (const auto& arg : metadata.args) {
+      arg_table_[arg.index] = arg;
+    }
+    startup_phases_.Record("metadata");
   } else if (data[EI_CLASS] == ELFCLASS64) {
     vendor_name = "Intel(R) FPGA Emulation Platform for OpenCL(TM)";
     target_device_name = "Intel(R) FPGA Emulation Device";
@@ -129,17 +156,16 @@ IntelOpenclDevice::IntelOpenclDevice(const cl::Program::Binaries& binaries) {
     LOG(FATAL) << "Unexpected ELF file";
   }
 
-  Initialize(binaries, vendor_name, DeviceMatcher(target_device_name),
-             kernel_names, kernel_arg_counts);
+  Initialize(bitstream, vendor_name, DeviceMatcher(target_device_name),
+             metadata.kernel_names, metadata.kernel_arg_counts);
 }
 
-std::unique_ptr<Device> IntelOpenclDevice::New(
-    const cl::Program::Binaries& binaries) {
-  if (binaries.size() != 1 || binaries.begin()->size() < SELFMAG ||
-      memcmp(binaries.begin()->data(), ELFMAG, SELFMAG) != 0) {
+std::unique_ptr<Device> IntelOpenclDevice::New(const Bitstream& bitstream) {
+  if (std::string_view header = bitstream.Header();
+      header.size() < SELFMAG || memcmp(header.data(), ELFMAG, SELFMAG) != 0) {
     return nullptr;
   }
-  return std::make_unique<IntelOpenclDevice>(binaries);
+  return std::make_unique<IntelOpenclDevice>(bitstream);
 }
 
 void IntelOpenclDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
@@ -147,28 +173,37 @@ void IntelOpenclDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
 };
 
 void IntelOpenclDevice::WriteToDevice() {
-  load_event_.resize(load_indices_.size());
-  int i = 0;
+  RestoreEvictedBuffers();
+  load_event_.clear();
   for (auto index : load_indices_) {
-    auto buffer = buffer_table_[index];
-    CL_CHECK(cmd_.enqueueWriteBuffer(
-        buffer, /* blocking = */ CL_FALSE, /* offset = */ 0,
-        buffer.getInfo<CL_MEM_SIZE>(), host_ptr_table_[index],
-        /* events = */ nullptr, &load_event_[i]));
-    ++i;
+    if (IsStaged(index)) continue;
+    for (const auto& range : GetLoadRanges(index)) {
+      CL_CHECK(cmd_.enqueueWriteBuffer(
+          buffer_table_[index], /* blocking = */ CL_FALSE, range.offset,
+          range.size, static_cast<char*>(host_ptr_table_[index]) + range.offset,
+          /* events = */ nullptr, &load_event_.emplace_back()));
+    }
   }
+  LoadStagedBuffers();
 }
 
 void IntelOpenclDevice::ReadFromDevice() {
-  store_event_.resize(store_indices_.size());
-  int i = 0;
+  MarkInUse();
+  store_event_.clear();
+  pending_stores_.clear();
   for (auto index : store_indices_) {
-    auto buffer = buffer_table_[index];
-    cmd_.enqueueReadBuffer(buffer, /* blocking = */ CL_FALSE,
-                           /* offset = */ 0, buffer.getInfo<CL_MEM_SIZE>(),
-                           host_ptr_table_[index], &compute_event_,
-                           &store_event_[i]);
-    ++i;
+    const BufferArg& arg = buffer_arg_table_.at(index);
+    if (arg.ActiveSizeInBytes() == 0 || IsEvicted(index)) continue;
+    if (IsStaged(index)) {
+      // Read back through the staging ring once the commands finish.
+      pending_stores_.push_back({index, arg, buffer_table_.at(index)});
+      continue;
+    }
+    cmd_.enqueueReadBuffer(
+        buffer_table_[index], /* blocking = */ CL_FALSE,
+        arg.ActiveOffsetInBytes(), arg.ActiveSizeInBytes(),
+        static_cast<char*>(host_ptr_table_[index]) + arg.ActiveOffsetInBytes(),
+        &compute_event_, &store_event_.emplace_back());
   }
 }
 
@@ -176,8 +211,18 @@ cl::Buffer IntelOpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
                                            void* host_ptr, size_t size) {
   flags |= /* CL_MEM_HETEROGENEOUS_INTELFPGA = */ 1 << 19;
   host_ptr_table_[index] = host_ptr;
-  host_ptr = nullptr;
-  return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+  auto buffer = OpenclDevice::CreateBuffer(index, flags, nullptr, size);
+  // Staged buffers have no host pointer.
+  buffer_info_table_[index].zero_copy =
+      host_ptr != nullptr && IsDmaAligned(host_ptr);
+  return buffer;
+}
+
+bool IntelOpenclDevice::RebindHostPtr(int index, void* host_ptr) {
+  // Transfers take the host pointer explicitly, so the buffer is not bound.
+  host_ptr_table_[index] = host_ptr;
+  buffer_info_table_.at(index).zero_copy = IsDmaAligned(host_ptr);
+  return true;
 }
 
 }  // namespace internal
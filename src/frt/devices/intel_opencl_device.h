@@ -8,6 +8,7 @@
 
 #include <CL/cl2.hpp>
 
+#include "frt/bitstream.h"
 #include "frt/devices/opencl_device.h"
 
 namespace fpga {
@@ -15,9 +16,9 @@ namespace internal {
 
 class IntelOpenclDevice : public OpenclDevice {
  public:
-  IntelOpenclDevice(const cl::Program::Binaries& binaries);
+  IntelOpenclDevice(const Bitstream& bitstream);
 
-  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries);
+  static std::unique_ptr<Device> New(const Bitstream& bitstream);
 
   void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override;
   void WriteToDevice() override;
@@ -26,6 +27,8 @@ class IntelOpenclDevice : public OpenclDevice {
  private:
   cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
                           size_t size) override;
+  bool RebindHostPtr(int index, void* host_ptr) override;
+  bool SupportsBufferArena() const override { return false; }
 
   std::unordered_map<int, void*> host_ptr_table_;
 };
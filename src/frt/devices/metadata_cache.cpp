@@ -0,0 +1,173 @@
+#include "frt/devices/metadata_cache.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include <glog/logging.h>
+
+#include "frt/arg_info.h"
+#include "frt/devices/file_cache.h"
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+constexpr std::string_view kMagic("FRTMETA\1", 8);
+
+// Serialized sizes of a kernel and an argument with empty strings.
+constexpr size_t kMinKernelRecordSize = 2 * sizeof(int64_t);
+constexpr size_t kMinArgRecordSize = 4 * sizeof(int64_t);
+
+std::mutex mtx;
+CacheStats stats;
+
+class Writer {
+ public:
+  void Int(int64_t value) {
+    content_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void String(std::string_view value) {
+    Int(value.size());
+    content_ += value;
+  }
+  std::string& Content() { return content_; }
+
+ private:
+  std::string content_;
+};
+
+class Reader {
+ public:
+  explicit Reader(std::string_view content) : content_(content) {}
+  bool Int(int64_t& value) {
+    if (content_.size() < sizeof(value)) return false;
+    memcpy(&value, content_.data(), sizeof(value));
+    content_.remove_prefix(sizeof(value));
+    return true;
+  }
+  template <typename T>
+  bool Int(T& value) {
+    int64_t value64;
+    if (!Int(value64)) return false;
+    value = static_cast<T>(value64);
+    return true;
+  }
+  bool String(std::string& value) {
+    int64_t size;
+    if (!Int(size) || size < 0 || content_.size() < size) return false;
+    value = content_.substr(0, size);
+    content_.remove_prefix(size);
+    return true;
+  }
+  // Reads the number of records that follow, rejecting counts that the rest of
+  // the content cannot hold, so that corrupted files do not allocate.
+  bool Count(int64_t& count, size_t min_record_size) {
+    return Int(count) && count >= 0 &&
+           uint64_t(count) <= content_.size() / min_record_size;
+  }
+  bool Done() const { return content_.empty(); }
+
+ private:
+  std::string_view content_;
+};
+
+// Layout: magic, parse time, target, mode, then the kernels (name and first
+// argument) and the arguments (index, name, type, and category).
+std::string Serialize(const KernelMetadata& metadata, int64_t parse_time) {
+  Writer writer;
+  writer.Content() = kMagic;
+  writer.Int(parse_time);
+  writer.String(metadata.target);
+  writer.String(metadata.mode);
+  writer.Int(metadata.kernel_names.size());
+  for (size_t i = 0; i < metadata.kernel_names.size(); ++i) {
+    writer.String(metadata.kernel_names[i]);
+    writer.Int(metadata.kernel_arg_counts[i]);
+  }
+  writer.Int(metadata.args.size());
+  for (const auto& arg : metadata.args) {
+    writer.Int(arg.index);
+    writer.String(arg.name);
+    writer.String(arg.type);
+    writer.Int(arg.cat);
+  }
+  return std::move(writer.Content());
+}
+
+bool Deserialize(std::string_view content, KernelMetadata& metadata,
+                 int64_t& parse_time) {
+  if (content.substr(0, kMagic.size()) != kMagic) return false;
+  Reader reader(content.substr(kMagic.size()));
+  int64_t count;
+  if (!reader.Int(parse_time) || !reader.String(metadata.target) ||
+      !reader.String(metadata.mode) ||
+      !reader.Count(count, kMinKernelRecordSize)) {
+    return false;
+  }
+  metadata.kernel_names.resize(count);
+  metadata.kernel_arg_counts.resize(count);
+  for (int64_t i = 0; i < count; ++i) {
+    if (!reader.String(metadata.kernel_names[i]) ||
+        !reader.Int(metadata.kernel_arg_counts[i])) {
+      return false;
+    }
+  }
+  if (!reader.Count(count, kMinArgRecordSize)) return false;
+  metadata.args.resize(count);
+  for (auto& arg : metadata.args) {
+    if (!reader.Int(arg.index) || !reader.String(arg.name) ||
+        !reader.String(arg.type) || !reader.Int(arg.cat)) {
+      return false;
+    }
+  }
+  return reader.Done();
+}
+
+}  // namespace
+
+KernelMetadata GetKernelMetadata(std::string_view backend,
+                                 const std::string& id,
+                                 const std::function<KernelMetadata()>& parse) {
+  std::string path = GetCacheDirectory("metadata");
+  if (!path.empty()) {
+    path += "/" + std::string(backend) + "-" +
+            FingerprintToString(Fingerprint(id));
+    KernelMetadata metadata;
+    int64_t parse_time;
+    if (std::string content; ReadCacheFile(path, content) &&
+                             Deserialize(content, metadata, parse_time)) {
+      VLOG(1) << "Loaded kernel metadata from '" << path << "'";
+      std::lock_guard<std::mutex> lock(mtx);
+      ++stats.hits;
+      stats.saved_nanoseconds += parse_time;
+      return metadata;
+    }
+  }
+
+  const auto tic = std::chrono::steady_clock::now();
+  KernelMetadata metadata = parse();
+  const int64_t parse_time =
+      std::chrono::nanoseconds(std::chrono::steady_clock::now() - tic).count();
+  if (!path.empty()) {
+    LOG_IF(WARNING, !WriteCacheFile(path, Serialize(metadata, parse_time)))
+        << "Cannot write kernel metadata to '" << path << "'";
+  }
+  std::lock_guard<std::mutex> lock(mtx);
+  ++stats.misses;
+  return metadata;
+}
+
+CacheStats GetMetadataCacheStats() {
+  std::lock_guard<std::mutex> lock(mtx);
+  return stats;
+}
+
+}  // namespace internal
+}  // namespace fpga
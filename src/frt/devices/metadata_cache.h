@@ -0,0 +1,44 @@
+#ifndef FPGA_RUNTIME_METADATA_CACHE_H_
+#define FPGA_RUNTIME_METADATA_CACHE_H_
+
+#include <cstdint>
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frt/arg_info.h"
+#include "frt/cache_stats.h"
+
+namespace fpga {
+namespace internal {
+
+// Kernel metadata parsed from a bitstream.
+struct KernelMetadata {
+  // Name of the target device or board.
+  std::string target;
+  // Backend-specific execution mode, e.g., the emulation target.
+  std::string mode;
+  std::vector<std::string> kernel_names;
+  // Index of the first argument of each kernel.
+  std::vector<int> kernel_arg_counts;
+  std::vector<ArgInfo> args;
+};
+
+// Returns the metadata of the bitstream identified by `id` for `backend`.
+// On a miss, the metadata is obtained with `parse` and stored in a compact
+// binary file under the per-user cache directory (see `file_cache.h`), so
+// that later processes loading the same bitstream skip parsing entirely.
+// `id` must change whenever the parsed content may change, e.g., a hash of
+// the metadata section.
+KernelMetadata GetKernelMetadata(std::string_view backend,
+                                 const std::string& id,
+                                 const std::function<KernelMetadata()>& parse);
+
+CacheStats GetMetadataCacheStats();
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_METADATA_CACHE_H_
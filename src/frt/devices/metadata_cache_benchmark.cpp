@@ -0,0 +1,103 @@
+#include "frt/devices/metadata_cache.h"
+
+#include <cstdlib>
+
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <zip_file.hpp>
+
+#include "frt/bitstream.h"
+#include "frt/devices/tapa_fast_cosim_device.h"
+
+namespace fpga::internal {
+namespace {
+
+// Writes an XO file whose `kernel.xml` declares `arg_count` arguments, and
+// returns its path.
+std::string WriteXo(int arg_count) {
+  std::string xml = R"(<?xml version="1.0" encoding="UTF-8"?>
+<root versionMajor="1" versionMinor="6">
+  <kernel name="Kernel" language="c" vlnv="xilinx.com:hls:Kernel:1.0">
+    <args>
+)";
+  for (int i = 0; i < arg_count; ++i) {
+    xml += "      <arg id=\"" + std::to_string(i) + "\" name=\"arg_" +
+           std::to_string(i) +
+           "\" addressQualifier=\"1\" port=\"m_axi_arg\" size=\"0x8\" "
+           "offset=\"0x10\" hostOffset=\"0x0\" hostSize=\"0x8\" "
+           "type=\"float*\"/>\n";
+  }
+  xml += "    </args>\n  </kernel>\n</root>\n";
+
+  std::string path = "/tmp/frt-metadata-benchmark.XXXXXX.xo";
+  close(mkstemps(&path[0], /*suffixlen=*/3));
+  miniz_cpp::zip_file xo_file;
+  xo_file.writestr("Kernel/kernel.xml", xml);
+  xo_file.save(path);
+  return path;
+}
+
+// Removes `dir` and everything under it, which holds no symbolic links.
+void RemoveDirectory(const std::string& dir) {
+  if (DIR* entries = opendir(dir.c_str())) {
+    for (const dirent* entry; (entry = readdir(entries)) != nullptr;) {
+      const std::string name = entry->d_name;
+      if (name == "." || name == "..") continue;
+      const std::string path = dir + "/" + name;
+      if (unlink(path.c_str()) != 0) {
+        RemoveDirectory(path);
+      }
+    }
+    closedir(entries);
+  }
+  rmdir(dir.c_str());
+}
+
+// Measures loading the metadata of an XO file with `range(0)` arguments, as
+// the TAPA fast cosim backend does when constructed, with caching disabled.
+// This is what every instance did before metadata was cached.
+void BM_MetadataCold(benchmark::State& state) {
+  const std::string path = WriteXo(state.range(0));
+  setenv("FRT_CACHE_DIR", "", /*overwrite=*/1);
+  for (auto _ : state) {
+    Bitstream bitstream(path);
+    TapaFastCosimDevice device(bitstream);
+    benchmark::DoNotOptimize(device.GetArgsInfo());
+  }
+  unsetenv("FRT_CACHE_DIR");
+  unlink(path.c_str());
+}
+BENCHMARK(BM_MetadataCold)->Range(4, 256);
+
+// Measures the same with the metadata loaded from a warm cache.
+void BM_MetadataWarm(benchmark::State& state) {
+  char cache_dir[] = "/tmp/frt-metadata-benchmark.XXXXXX";
+  if (mkdtemp(cache_dir) == nullptr) {
+    state.SkipWithError("cannot create the cache directory");
+    return;
+  }
+  const std::string path = WriteXo(state.range(0));
+  setenv("FRT_CACHE_DIR", cache_dir, /*overwrite=*/1);
+  const int64_t hits = GetMetadataCacheStats().hits;
+  {
+    Bitstream bitstream(path);
+    TapaFastCosimDevice device(bitstream);
+  }
+  for (auto _ : state) {
+    Bitstream bitstream(path);
+    TapaFastCosimDevice device(bitstream);
+    benchmark::DoNotOptimize(device.GetArgsInfo());
+  }
+  state.counters["hits"] = GetMetadataCacheStats().hits - hits;
+  unsetenv("FRT_CACHE_DIR");
+  unlink(path.c_str());
+  RemoveDirectory(cache_dir);
+}
+BENCHMARK(BM_MetadataWarm)->Range(4, 256);
+
+}  // namespace
+}  // namespace fpga::internal
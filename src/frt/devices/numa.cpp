@@ -0,0 +1,56 @@
+#include "frt/devices/numa.h"
+
+#include <climits>
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "frt/devices/sysfs.h"
+#include "frt/numa_placement.h"
+
+namespace fpga {
+namespace internal {
+
+NumaPlacement GetNumaPlacement(const std::string& bdf,
+                               const std::string& sysfs_root) {
+  NumaPlacement placement;
+  placement.bdf = bdf;
+  if (auto device = FindPciDevice(bdf, sysfs_root); device.has_value()) {
+    placement.node = device->numa_node;
+    placement.cpus = GetNumaNodeCpus(placement.node, sysfs_root);
+  }
+  return placement;
+}
+
+bool BindToNumaNode(void* ptr, size_t size, int node) {
+  if (node < 0) return false;
+  constexpr int kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+  std::vector<unsigned long> node_mask(node / kBitsPerWord + 1);
+  node_mask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  // Called directly so that libnuma is not needed.
+  return syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, node_mask.data(),
+                 node_mask.size() * kBitsPerWord + 1, /*flags=*/0) == 0;
+}
+
+bool PinCurrentThread(const std::vector<int>& cpus) {
+  if (cpus.empty()) return false;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) ==
+         0;
+}
+
+}  // namespace internal
+}  // namespace fpga
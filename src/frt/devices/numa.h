@@ -0,0 +1,31 @@
+#ifndef FPGA_RUNTIME_NUMA_H_
+#define FPGA_RUNTIME_NUMA_H_
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+#include "frt/devices/sysfs.h"
+#include "frt/numa_placement.h"
+
+namespace fpga {
+namespace internal {
+
+// Returns the NUMA node and its CPUs of the PCIe device at `bdf`, as reported
+// by sysfs. Leaves `host_buffers_bound` unset.
+NumaPlacement GetNumaPlacement(const std::string& bdf,
+                               const std::string& sysfs_root = GetSysfsRoot());
+
+// Makes pages of `[ptr, ptr + size)` that are not faulted in yet prefer NUMA
+// node `node`. Returns false on failure, e.g., without NUMA support.
+bool BindToNumaNode(void* ptr, size_t size, int node);
+
+// Restricts the calling thread to `cpus`. Returns false if `cpus` is empty or
+// on failure.
+bool PinCurrentThread(const std::vector<int>& cpus);
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_NUMA_H_
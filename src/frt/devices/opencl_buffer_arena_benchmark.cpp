@@ -0,0 +1,69 @@
+#include <cstdlib>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+#include <gflags/gflags.h>
+
+#include "frt.h"
+
+DECLARE_uint64(opencl_buffer_arena_kib);
+
+namespace fpga {
+namespace {
+
+constexpr int kArgCount = 64;
+
+// Writes OpenCL C source of a kernel with `kArgCount` buffer arguments, which
+// increments the first element of each, and returns its path.
+std::string WriteKernel() {
+  std::string path = "/tmp/opencl_buffer_arena_benchmark.XXXXXX.cl";
+  close(mkstemps(&path[0], /*suffixlen=*/3));
+  std::ofstream file(path);
+  file << "__kernel void Increment(";
+  for (int i = 0; i < kArgCount; ++i) {
+    file << (i == 0 ? "" : ", ") << "__global int* arg" << i;
+  }
+  file << ") {\n";
+  for (int i = 0; i < kArgCount; ++i) {
+    file << "  ++arg" << i << "[0];\n";
+  }
+  file << "}\n";
+  return path;
+}
+
+// Measures one invocation of the kernel with arguments of `range(0)` bytes
+// each, packed into an arena if `range(1)` is set. Runs on the generic OpenCL
+// backend, so it needs an OpenCL platform, e.g., PoCL on the host; select one
+// with `--generic_opencl_platform`.
+void BM_SmallBufferArgs(benchmark::State& state) {
+  const size_t size = state.range(0);
+  FLAGS_opencl_buffer_arena_kib = state.range(1) != 0 ? 4 << 10 : 0;
+  const std::string path = WriteKernel();
+  Instance instance(path);
+  unlink(path.c_str());
+
+  std::vector<std::vector<int, AlignedAllocator<int>>> buffers(
+      kArgCount, std::vector<int, AlignedAllocator<int>>(size / sizeof(int)));
+  for (auto _ : state) {
+    for (int i = 0; i < kArgCount; ++i) {
+      instance.SetArg(i, ReadWrite(buffers[i].data(), buffers[i].size()));
+    }
+    instance.WriteToDevice();
+    instance.Exec();
+    instance.ReadFromDevice();
+    instance.Finish();
+  }
+  state.SetBytesProcessed(state.iterations() * kArgCount * size * 2);
+}
+BENCHMARK(BM_SmallBufferArgs)
+    ->ArgNames({"bytes", "arena"})
+    ->ArgsProduct({{256, 4 << 10, 64 << 10}, {0, 1}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace fpga
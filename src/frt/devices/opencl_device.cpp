@@ -1,16 +1,66 @@
 #include "frt/devices/opencl_device.h"
 
+#include <cstdint>
+#include <cstring>
+
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <CL/cl2.hpp>
 
+#include "frt/devices/device_memory_manager.h"
+#include "frt/devices/dirty_page_tracker.h"
+#include "frt/devices/file_cache.h"
 #include "frt/devices/opencl_device_matcher.h"
+#include "frt/devices/opencl_inventory.h"
+#include "frt/devices/opencl_program_cache.h"
+#include "frt/devices/numa.h"
 #include "frt/devices/opencl_util.h"
+#include "frt/devices/staging_ring.h"
+#include "frt/devices/startup_phase_recorder.h"
+
+DEFINE_bool(opencl_program_cache, true,
+            "reuse OpenCL contexts, programs, and kernels across instances "
+            "loading the same bitstream onto the same device");
+DEFINE_bool(opencl_buffer_cache, true,
+            "reuse OpenCL buffers across SetArg calls with the same argument "
+            "index, size, flags, and host pointer");
+DEFINE_bool(opencl_dirty_page_tracking, false,
+            "write-protect host buffers that are only loaded to the device, "
+            "so that WriteToDevice loads only pages written since the last "
+            "call; such buffers must not be freed while set as arguments, "
+            "and system calls writing to them (e.g., read or recv) fail with "
+            "EFAULT");
+DEFINE_uint64(opencl_buffer_arena_kib, 0,
+              "if not 0, pack small buffer arguments as sub-buffers of one "
+              "allocation of this size in KiB per memory bank, staged through "
+              "host memory and transferred together");
+DEFINE_uint64(opencl_buffer_arena_max_bytes, 64 << 10,
+              "size in bytes of the largest buffer argument packed with "
+              "--opencl_buffer_arena_kib");
+DEFINE_uint64(opencl_staging_min_kib, 1024,
+              "if not 0, transfer buffer arguments of at least this size in "
+              "KiB whose host memory is not aligned for zero-copy through a "
+              "ring of pinned staging buffers");
+DEFINE_uint64(opencl_staging_chunk_kib, 2048,
+              "size in KiB of each buffer of the staging ring");
+DEFINE_int32(opencl_staging_slots, 4, "number of buffers of the staging ring");
+DEFINE_int32(opencl_staging_threads, 4,
+             "number of threads copying into and out of the staging ring");
+
+DECLARE_bool(numa_placement);
 
 namespace fpga {
 namespace internal {
@@ -49,11 +99,101 @@ int64_t Latest(const std::vector<cl::Event>& events,
   return default_value;
 }
 
+// Returns the sub-buffer of `buffer` covering `[begin, end)`, or `buffer`
+// itself if that is all of it. `begin` must be aligned.
+cl::Buffer GetRegion(cl::Buffer buffer, size_t begin, size_t end) {
+  if (begin == 0 && end == buffer.getInfo<CL_MEM_SIZE>()) {
+    return buffer;
+  }
+  const cl_buffer_region region = {begin, end - begin};
+  cl_int err;
+  cl::Buffer sub_buffer = buffer.createSubBuffer(
+      /* flags = */ 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+  CL_CHECK(err);
+  return sub_buffer;
+}
+
+// Extends the range of `bank` in `ranges` to cover `[begin, end)`.
+void ExtendRange(std::map<int, std::pair<size_t, size_t>>& ranges, int bank,
+                 size_t begin, size_t end) {
+  auto [it, is_new] = ranges.try_emplace(bank, begin, end);
+  it->second.first = std::min(it->second.first, begin);
+  it->second.second = std::max(it->second.second, end);
+}
+
 }  // namespace
 
+// Events and pending stores of one invocation taken from the device.
+class OpenclRun : public DeviceRun {
+ public:
+  OpenclRun(OpenclDevice* device, std::vector<cl::Event> load_events,
+            std::vector<cl::Event> compute_events,
+            std::vector<cl::Event> store_events,
+            std::vector<OpenclDevice::PendingStore> stores, size_t load_bytes,
+            size_t store_bytes)
+      : device_(device),
+        load_events_(std::move(load_events)),
+        compute_events_(std::move(compute_events)),
+        store_events_(std::move(store_events)),
+        stores_(std::move(stores)),
+        load_bytes_(load_bytes),
+        store_bytes_(store_bytes) {}
+
+  // Waits so that results are not lost and the device may reuse buffers.
+  ~OpenclRun() override { Wait(); }
+
+  void Wait() override {
+    if (device_ == nullptr) return;
+    std::vector<cl::Event> events = load_events_;
+    events.insert(events.end(), compute_events_.begin(),
+                  compute_events_.end());
+    events.insert(events.end(), store_events_.begin(), store_events_.end());
+    if (!events.empty()) {
+      CL_CHECK(cl::WaitForEvents(events));
+    }
+    device_->CompleteStores(stores_, store_events_);
+    stores_.clear();
+    // Like `Finish`, the last run waited for leaves the device idle, unless
+    // commands have been enqueued since.
+    device_->runs_in_flight_.erase(this);
+    if (device_->runs_in_flight_.empty() && device_->load_event_.empty() &&
+        device_->compute_event_.empty() && device_->store_event_.empty() &&
+        device_->pending_stores_.empty()) {
+      device_->MarkIdle();
+    }
+    device_ = nullptr;
+  }
+
+  int64_t LoadTimeNanoSeconds() const override {
+    return Latest<CL_PROFILING_COMMAND_END>(load_events_) -
+           Earliest<CL_PROFILING_COMMAND_START>(load_events_);
+  }
+  int64_t ComputeTimeNanoSeconds() const override {
+    return Latest<CL_PROFILING_COMMAND_END>(compute_events_) -
+           Earliest<CL_PROFILING_COMMAND_START>(compute_events_);
+  }
+  int64_t StoreTimeNanoSeconds() const override {
+    return Latest<CL_PROFILING_COMMAND_END>(store_events_) -
+           Earliest<CL_PROFILING_COMMAND_START>(store_events_);
+  }
+  size_t LoadBytes() const override { return load_bytes_; }
+  size_t StoreBytes() const override { return store_bytes_; }
+
+ private:
+  // Null once waited for.
+  OpenclDevice* device_;
+  const std::vector<cl::Event> load_events_;
+  const std::vector<cl::Event> compute_events_;
+  std::vector<cl::Event> store_events_;
+  std::vector<OpenclDevice::PendingStore> stores_;
+  const size_t load_bytes_;
+  const size_t store_bytes_;
+};
+
 void OpenclDevice::SetScalarArg(int index, const void* arg, int size) {
   auto pair = GetKernel(index);
   pair.second.setArg(pair.first, size, arg);
+  scalar_arg_sizes_[index] = size;
 }
 
 void OpenclDevice::SetBufferArg(int index, Tag tag, const BufferArg& arg) {
@@ -71,7 +211,63 @@ void OpenclDevice::SetBufferArg(int index, Tag tag, const BufferArg& arg) {
       flags = CL_MEM_READ_WRITE;
       break;
   }
-  cl::Buffer buffer = CreateBuffer(index, flags, arg.Get(), arg.SizeInBytes());
+  MarkInUse();
+  device_buffer_args_.erase(index);
+  const auto tic = std::chrono::steady_clock::now();
+  const BufferKey key = {flags, arg.SizeInBytes(), arg.Get()};
+  cl::Buffer buffer;
+  bool is_reused = false;
+  bool is_new_host_ptr = true;
+  if (SetArenaSlot(index, tag, arg.SizeInBytes(), is_reused)) {
+    buffer = buffer_table_.at(index);
+    buffer_keys_.erase(index);
+    // Arguments in the arena are staged through it regardless of alignment.
+    is_new_host_ptr = false;
+  } else if (auto it = buffer_keys_.find(index);
+             FLAGS_opencl_buffer_cache && it != buffer_keys_.end() &&
+             it->second.flags == key.flags && it->second.size == key.size &&
+             !IsEvicted(index) &&
+             ShouldStage(key.host_ptr, key.size) == IsStaged(index) &&
+             // Staged buffers are not bound to host memory. Buffers of runs in
+             // flight may still be in use for other host buffers.
+             (it->second.host_ptr == key.host_ptr ||
+              (runs_in_flight_.empty() &&
+               (IsStaged(index) || RebindHostPtr(index, key.host_ptr))))) {
+    buffer = buffer_table_.at(index);
+    memory_manager_->Touch(buffer_memory_ids_.at(index));
+    is_new_host_ptr = it->second.host_ptr != key.host_ptr;
+    it->second.host_ptr = key.host_ptr;
+    is_reused = true;
+  } else {
+    buffer = AllocateBuffer(index, flags, arg.Get(), arg.SizeInBytes());
+    buffer_keys_[index] = key;
+  }
+  buffer_arg_table_.insert_or_assign(index, arg);
+  if (FLAGS_opencl_dirty_page_tracking && tag == Tag::kWriteOnly) {
+    // A new device buffer needs all pages loaded again.
+    auto& tracker = dirty_page_trackers_[index];
+    if (!is_reused || tracker == nullptr || tracker->Get() != arg.Get()) {
+      tracker.reset();
+      tracker = std::make_unique<DirtyPageTracker>(arg.Get(),
+                                                   arg.SizeInBytes());
+    }
+  } else {
+    dirty_page_trackers_.erase(index);
+  }
+  BufferInfo& info = buffer_info_table_.at(index);
+  const int64_t elapsed_ns = std::chrono::nanoseconds(
+                                 std::chrono::steady_clock::now() - tic)
+                                 .count();
+  if (is_reused) {
+    info.warm_nanoseconds = elapsed_ns;
+    ++info.reuse_count;
+  } else {
+    info.cold_nanoseconds = elapsed_ns;
+  }
+  LOG_IF(WARNING, is_new_host_ptr && !info.zero_copy && !info.staged)
+      << "Buffer argument #" << index << " (" << arg.SizeInBytes()
+      << " bytes at " << static_cast<const void*>(arg.Get())
+      << ") is not zero-copy; allocate it with fpga::AlignedAllocator";
   if (tag == Tag::kReadOnly || tag == Tag::kReadWrite) {
     store_indices_.insert(index);
   }
@@ -83,23 +279,199 @@ void OpenclDevice::SetBufferArg(int index, Tag tag, const BufferArg& arg) {
 }
 
 size_t OpenclDevice::SuspendBuffer(int index) {
+  MarkInUse();
+  if (buffer_keys_.count(index) != 0) {
+    LOG_IF(FATAL, IsEvicted(index))
+        << "Cannot suspend buffer argument #" << index
+        << ", which has been evicted; set it again first";
+    // Without transfers, the device buffer may hold the only copy of its
+    // contents, so it is never evicted from now on.
+    memory_manager_->Pin(buffer_memory_ids_.at(index));
+  }
   return load_indices_.erase(index) + store_indices_.erase(index);
 }
 
+int OpenclDevice::CreateDeviceBuffer(size_t size) {
+  memory_manager_->MakeRoom(size);
+  cl_int err;
+  device_buffers_.emplace_back(context_, CL_MEM_READ_WRITE, size,
+                               /* host_ptr = */ nullptr, &err);
+  CL_CHECK(err);
+  // The contents exist only on the device, so the buffer is never evicted.
+  memory_manager_->Add(this, /* bank = */ -1, size, /* evict = */ nullptr);
+  return device_buffers_.size() - 1;
+}
+
+void OpenclDevice::SetDeviceBufferArg(int index, int id) {
+  MarkInUse();
+  // Replaces any host buffer previously set for the argument.
+  load_indices_.erase(index);
+  store_indices_.erase(index);
+  ReleaseBuffer(index);
+  buffer_keys_.erase(index);
+  arena_slots_.erase(index);
+  device_buffer_args_[index] = id;
+  auto pair = GetKernel(index);
+  pair.second.setArg(pair.first, device_buffers_.at(id));
+}
+
+void OpenclDevice::ReadDeviceBuffer(int id, size_t offset, size_t size,
+                                    void* host_ptr) {
+  const std::vector<cl::Event> events = GetPreviousEvents();
+  CL_CHECK(cmd_.enqueueReadBuffer(device_buffers_.at(id),
+                                  /* blocking = */ CL_TRUE, offset, size,
+                                  host_ptr, &events));
+}
+
+void OpenclDevice::WriteDeviceBuffer(int id, size_t offset, size_t size,
+                                     const void* host_ptr) {
+  const std::vector<cl::Event> events = GetPreviousEvents();
+  CL_CHECK(cmd_.enqueueWriteBuffer(device_buffers_.at(id),
+                                   /* blocking = */ CL_TRUE, offset, size,
+                                   host_ptr, &events));
+}
+
+void* OpenclDevice::MapBuffer(int index, size_t offset, size_t size,
+                              MapMode mode) {
+  MarkInUse();
+  cl::Buffer buffer;
+  if (auto it = device_buffer_args_.find(index);
+      it != device_buffer_args_.end()) {
+    buffer = device_buffers_.at(it->second);
+  } else {
+    LOG_IF(FATAL, buffer_keys_.count(index) == 0 &&
+                      arena_slots_.count(index) == 0)
+        << "Buffer argument #" << index << " is not set";
+    // Writes to the staging area would be overwritten by `WriteToDevice`.
+    LOG_IF(FATAL, arena_slots_.count(index) != 0)
+        << "Cannot map buffer argument #" << index
+        << ", which is packed into an arena";
+    if (IsEvicted(index)) {
+      RestoreBuffer(index);
+    }
+    // Writes through the mapping may only reach the device.
+    memory_manager_->Pin(buffer_memory_ids_.at(index));
+    buffer = buffer_table_.at(index);
+  }
+  LOG_IF(FATAL, offset + size > buffer.getInfo<CL_MEM_SIZE>())
+      << "Cannot map bytes [" << offset << ", " << offset + size
+      << ") of buffer argument #" << index << "; the buffer has only "
+      << buffer.getInfo<CL_MEM_SIZE>() << " bytes";
+
+  cl_map_flags flags = CL_MAP_READ | CL_MAP_WRITE;
+  switch (mode) {
+    case MapMode::kRead:
+      flags = CL_MAP_READ;
+      break;
+    case MapMode::kWrite:
+      flags = CL_MAP_WRITE_INVALIDATE_REGION;
+      break;
+    case MapMode::kReadWrite:
+      break;
+  }
+  std::vector<cl::Event> events = GetPreviousEvents();
+  cl_int err;
+  void* ptr = cmd_.enqueueMapBuffer(buffer, /* blocking = */ CL_TRUE, flags,
+                                    offset, size, &events,
+                                    /* event = */ nullptr, &err);
+  CL_CHECK(err);
+  mapped_buffers_.emplace(ptr, buffer);
+  return ptr;
+}
+
+void OpenclDevice::UnmapBuffer(int index, void* ptr) {
+  auto it = mapped_buffers_.find(ptr);
+  LOG_IF(FATAL, it == mapped_buffers_.end())
+      << "Cannot unmap " << ptr
+      << ", which is not mapped from buffer argument #" << index;
+  cl::Event event;
+  CL_CHECK(cmd_.enqueueUnmapMemObject(it->second, ptr, /* events = */ nullptr,
+                                      &event));
+  CL_CHECK(event.wait());
+  mapped_buffers_.erase(it);
+}
+
+void OpenclDevice::WriteToDevice() {
+  load_event_.clear();
+  if (auto buffers = GetLoadBuffers(); !buffers.empty()) {
+    CL_CHECK(cmd_.enqueueMigrateMemObjects(buffers, /* flags = */ 0,
+                                           /* events = */ nullptr,
+                                           &load_event_.emplace_back()));
+  }
+  // Staged while the migration is in flight.
+  LoadStagedBuffers();
+}
+
+void OpenclDevice::ReadFromDevice() {
+  if (auto buffers = GetStoreBuffers(); !buffers.empty()) {
+    store_event_.resize(1);
+    CL_CHECK(cmd_.enqueueMigrateMemObjects(
+        buffers, CL_MIGRATE_MEM_OBJECT_HOST, &compute_event_,
+        store_event_.data()));
+  } else {
+    store_event_.clear();
+  }
+}
+
 void OpenclDevice::Exec() {
-  compute_event_.resize(kernels_.size());
-  int i = 0;
-  for (auto& pair : kernels_) {
-    CL_CHECK(cmd_.enqueueNDRangeKernel(pair.second, cl::NullRange,
-                                       cl::NDRange(1), cl::NDRange(1),
-                                       &load_event_, &compute_event_[i]));
-    ++i;
+  RestoreEvictedBuffers();
+  compute_event_.clear();
+  for (auto it = kernel_names_.begin(); it != kernel_names_.end(); ++it) {
+    const int offset = it->first;
+    const auto next = std::next(it);
+    const int end = next == kernel_names_.end()
+                        ? std::numeric_limits<int>::max()
+                        : next->first;
+    // Stream arguments may be connected to other kernels instead.
+    int host_arg_count = 0;
+    int set_arg_count = 0;
+    for (const auto& [index, arg] : arg_table_) {
+      if (index < offset || index >= end || arg.cat == ArgInfo::kStream) {
+        continue;
+      }
+      ++host_arg_count;
+      const bool is_set = scalar_arg_sizes_.count(index) != 0 ||
+                          buffer_arg_table_.count(index) != 0 ||
+                          device_buffer_args_.count(index) != 0;
+      set_arg_count += is_set;
+    }
+    if (kernels_.count(offset) == 0 && host_arg_count != 0) {
+      // The kernel has not been created, i.e., none of its arguments is set.
+      // Kernels with only stream arguments are launched anyway.
+      LOG(WARNING) << "Skipping kernel '" << it->second
+                   << "' whose arguments are not set";
+      continue;
+    }
+    LOG_IF(FATAL, set_arg_count != host_arg_count)
+        << "Only " << set_arg_count << " of the " << host_arg_count
+        << " host arguments of kernel '" << it->second << "' are set";
+    CL_CHECK(cmd_.enqueueNDRangeKernel(
+        GetKernel(offset).second, cl::NullRange, cl::NDRange(1),
+        cl::NDRange(1), &load_event_, &compute_event_.emplace_back()));
   }
 }
 
 void OpenclDevice::Finish() {
   CL_CHECK(cmd_.flush());
   CL_CHECK(cmd_.finish());
+  CompleteStores(pending_stores_, store_event_);
+  pending_stores_.clear();
+  MarkIdle();
+}
+
+std::unique_ptr<DeviceRun> OpenclDevice::TakeRun() {
+  // Submits the commands, which would otherwise wait for `Finish`.
+  CL_CHECK(cmd_.flush());
+  auto run = std::make_unique<OpenclRun>(
+      this, std::move(load_event_), std::move(compute_event_),
+      std::move(store_event_), std::move(pending_stores_), LoadBytes(),
+      StoreBytes());
+  load_event_.clear();
+  compute_event_.clear();
+  store_event_.clear();
+  pending_stores_.clear();
+  runs_in_flight_.insert(run.get());
+  return run;
 }
 
 std::vector<ArgInfo> OpenclDevice::GetArgsInfo() const {
@@ -129,107 +501,632 @@ int64_t OpenclDevice::StoreTimeNanoSeconds() const {
 }
 size_t OpenclDevice::LoadBytes() const {
   size_t total_size = 0;
-  cl_int err;
-  for (const auto& buffer : GetLoadBuffers()) {
-    total_size += buffer.getInfo<CL_MEM_SIZE>(&err);
-    CL_CHECK(err);
+  for (auto index : load_indices_) {
+    total_size += buffer_info_table_.at(index).load_bytes;
   }
   return total_size;
 }
 size_t OpenclDevice::StoreBytes() const {
   size_t total_size = 0;
-  cl_int err;
-  for (const auto& buffer : GetStoreBuffers()) {
-    total_size += buffer.getInfo<CL_MEM_SIZE>(&err);
-    CL_CHECK(err);
+  for (auto index : store_indices_) {
+    total_size += buffer_arg_table_.at(index).ActiveSizeInBytes();
   }
   return total_size;
 }
+std::vector<StartupPhase> OpenclDevice::GetStartupPhases() const {
+  return startup_phases_.Get();
+}
+
+std::vector<BufferInfo> OpenclDevice::GetBuffersInfo() const {
+  std::vector<BufferInfo> infos;
+  infos.reserve(buffer_info_table_.size());
+  for (const auto& [index, info] : buffer_info_table_) {
+    infos.push_back(info);
+  }
+  std::sort(infos.begin(), infos.end(),
+            [](const BufferInfo& lhs, const BufferInfo& rhs) {
+              return lhs.index < rhs.index;
+            });
+  return infos;
+}
+
+std::vector<MemoryBank> OpenclDevice::GetMemoryTopology() const {
+  // The memory topology is not available through OpenCL itself.
+  return {};
+}
+
+DeviceMemoryStats OpenclDevice::GetDeviceMemoryStats() const {
+  return memory_manager_->GetStats(this);
+}
+
+std::string OpenclDevice::GetPcieBdf() const {
+  for (const auto& platform : GetOpenclInventory()) {
+    for (const auto& entry : platform.devices) {
+      if (entry.device.get() == device_.get()) {
+        return entry.bdf;
+      }
+    }
+  }
+  return "";
+}
 
-void OpenclDevice::Initialize(const cl::Program::Binaries& binaries,
+OpenclDevice::~OpenclDevice() {
+  // Runs may be destroyed after the device, e.g., if declared before the
+  // instance, so their results are completed and the runs detached now.
+  while (!runs_in_flight_.empty()) {
+    (*runs_in_flight_.begin())->Wait();
+  }
+  // Stops other devices from evicting buffers of this one.
+  if (memory_manager_ != nullptr) {
+    memory_manager_->RemoveOwner(this);
+  }
+  if (cached_program_ != nullptr) {
+    // Kernels are handed to later devices, which must neither see the
+    // arguments of this one nor keep its buffers alive.
+    ResetKernelArgs();
+    for (auto& [offset, kernel] : kernels_) {
+      cached_program_->ReleaseKernel(kernel_names_.at(offset),
+                                     std::move(kernel));
+    }
+  }
+}
+
+void OpenclDevice::Initialize(const Bitstream& bitstream,
                               const std::string& vendor_name,
                               const OpenclDeviceMatcher& device_matcher,
                               const std::vector<std::string>& kernel_names,
                               const std::vector<int>& kernel_arg_counts) {
-  std::vector<cl::Platform> platforms;
-  CL_CHECK(cl::Platform::get(&platforms));
+  const std::string_view binary = bitstream.Content();
+  bool is_built = false;
+  auto build = [&] {
+    is_built = true;
+    return BuildProgram(binary, vendor_name, device_matcher, startup_phases_);
+  };
+  if (FLAGS_opencl_program_cache) {
+    const std::string key = vendor_name + '\0' +
+                            device_matcher.GetTargetName() + '\0' +
+                            GetCachedProgramId(bitstream);
+    cached_program_ = OpenclProgramCache::Get().GetOrBuild(key, build);
+    if (!is_built) {
+      startup_phases_.Record("program cache");
+    }
+  } else {
+    cached_program_ = build();
+  }
+  device_ = cached_program_->device;
+  context_ = cached_program_->context;
+  program_ = cached_program_->program;
+  memory_manager_ = &DeviceMemoryManager::Get(device_.get());
+
+  cl_int err;
+  cmd_ = cl::CommandQueue(
+      context_, device_,
+      CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
+      &err);
+  CL_CHECK(err);
+  startup_phases_.Record("command queue");
+  SetKernelNames(kernel_names, kernel_arg_counts);
+  LOG(INFO) << startup_phases_.Get();
+}
+
+void OpenclDevice::SetKernelNames(const std::vector<std::string>& kernel_names,
+                                  const std::vector<int>& kernel_arg_counts) {
+  for (int i = 0; i < kernel_names.size(); ++i) {
+    const auto [it, is_new] =
+        kernel_names_.emplace(kernel_arg_counts[i], kernel_names[i]);
+    LOG_IF(WARNING, !is_new)
+        << "Kernel '" << it->second << "' has no arguments, so it is replaced"
+        << " by kernel '" << kernel_names[i] << "'";
+    it->second = kernel_names[i];
+  }
+}
+
+const std::string& OpenclDevice::GetCachedProgramId(
+    const Bitstream& bitstream) {
+  if (program_id_.empty()) {
+    program_id_ = GetProgramId(bitstream);
+  }
+  return program_id_;
+}
+
+std::string OpenclDevice::GetProgramId(const Bitstream& bitstream) const {
+  // Hashing a whole mapped bitstream would fault in all of its pages.
+  if (bitstream.IsMapped()) {
+    if (std::string stamp = GetFileStamp(bitstream.Path()); !stamp.empty()) {
+      return "file:" + bitstream.Path() + '\0' + stamp;
+    }
+  }
+  return FingerprintToString(Fingerprint(bitstream.Content()));
+}
+
+std::shared_ptr<OpenclProgram> OpenclDevice::BuildProgram(
+    std::string_view binary, const std::string& vendor_name,
+    const OpenclDeviceMatcher& device_matcher,
+    StartupPhaseRecorder& startup_phases) const {
+  const auto tic = std::chrono::steady_clock::now();
+  bool is_platform_found = false;
   cl_int err;
-  for (const auto& platform : platforms) {
-    std::string platformName = platform.getInfo<CL_PLATFORM_NAME>(&err);
-    CL_CHECK(err);
-    LOG(INFO) << "Found platform: " << platformName.c_str();
-    if (platformName == vendor_name) {
-      std::vector<cl::Device> devices;
-      CL_CHECK(platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
-      for (const auto& device : devices) {
-        if (std::string device_name = device_matcher.Match(device);
-            !device_name.empty()) {
-          LOG(INFO) << "Using " << device_name;
-          device_ = device;
-          context_ = cl::Context(device, nullptr, nullptr, nullptr, &err);
-          if (err == CL_DEVICE_NOT_AVAILABLE) {
-            LOG(WARNING) << "Device '" << device_name << "' not available";
-            continue;
-          }
-          CL_CHECK(err);
-          cmd_ = cl::CommandQueue(context_, device,
-                                  CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE |
-                                      CL_QUEUE_PROFILING_ENABLE,
-                                  &err);
-          CL_CHECK(err);
-          std::vector<int> binary_status;
-          program_ =
-              cl::Program(context_, {device}, binaries, &binary_status, &err);
-          for (auto status : binary_status) {
-            CL_CHECK(status);
-          }
-          CL_CHECK(err);
-          CL_CHECK(program_.build());
-          for (int i = 0; i < kernel_names.size(); ++i) {
-            kernels_[kernel_arg_counts[i]] =
-                cl::Kernel(program_, kernel_names[i].c_str(), &err);
-            CL_CHECK(err);
-          }
-          return;
+  for (const auto& platform : GetOpenclInventory()) {
+    if (!vendor_name.empty() && platform.name != vendor_name) continue;
+    is_platform_found = true;
+    // Contexts are only created for matching devices.
+    for (const auto& entry : platform.devices) {
+      if ((entry.type & device_matcher.GetDeviceType()) == 0) continue;
+      if (std::string device_name = device_matcher.Match(entry);
+          !device_name.empty()) {
+        const cl::Device& device = entry.device;
+        LOG(INFO) << "Using " << device_name;
+        startup_phases.Record("discovery");
+        cl::Context context(device, nullptr, nullptr, nullptr, &err);
+        if (err == CL_DEVICE_NOT_AVAILABLE) {
+          LOG(WARNING) << "Device '" << device_name << "' not available";
+          continue;
         }
+        CL_CHECK(err);
+        startup_phases.Record("context");
+        cl::Program program = CreateProgram(context, device, binary);
+        startup_phases.Record("program");
+        return std::make_shared<OpenclProgram>(
+            device, context, program, std::chrono::steady_clock::now() - tic);
       }
-      LOG(FATAL) << "Target device '" << device_matcher.GetTargetName()
-                 << "' not found";
     }
   }
-  LOG(FATAL) << "Target platform '" + vendor_name + "' not found";
+  LOG_IF(FATAL, !is_platform_found)
+      << "Target platform '" + vendor_name + "' not found";
+  LOG(FATAL) << "Target device '" << device_matcher.GetTargetName()
+             << "' not found";
+  return nullptr;
+}
+
+cl::Program OpenclDevice::CreateProgram(const cl::Context& context,
+                                        const cl::Device& device,
+                                        std::string_view binary) const {
+  // Pass the (possibly memory-mapped) binary to OpenCL directly;
+  // `cl::Program::Binaries` would require an owned copy.
+  cl_device_id device_id = device.get();
+  const size_t binary_size = binary.size();
+  auto binary_data = reinterpret_cast<const unsigned char*>(binary.data());
+  cl_int binary_status;
+  cl_int err;
+  cl::Program program(clCreateProgramWithBinary(context.get(), 1, &device_id,
+                                                &binary_size, &binary_data,
+                                                &binary_status, &err));
+  CL_CHECK(binary_status);
+  CL_CHECK(err);
+  CL_CHECK(program.build(GetBuildOptions().c_str()));
+  return program;
 }
 
 cl::Buffer OpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
                                       void* host_ptr, size_t size) {
   cl_int err;
   auto buffer = cl::Buffer(context_, flags, size, host_ptr, &err);
+  if (err == CL_MEM_OBJECT_ALLOCATION_FAILURE) {
+    LOG(WARNING) << "Cannot allocate " << size << " bytes for buffer argument #"
+                 << index << "; retrying after evicting "
+                 << memory_manager_->EvictIdle()
+                 << " bytes of idle device buffers";
+    buffer = cl::Buffer(context_, flags, size, host_ptr, &err);
+  }
   CL_CHECK(err);
   buffer_table_[index] = buffer;
+  buffer_info_table_[index] = {
+      index, size,
+      (flags & CL_MEM_USE_HOST_PTR) != 0 &&
+          reinterpret_cast<uintptr_t>(host_ptr) % GetZeroCopyAlignment() == 0};
   return buffer;
 }
 
-std::vector<cl::Memory> OpenclDevice::GetLoadBuffers() const {
+cl::Buffer OpenclDevice::CreateArenaBuffer(int bank, void* host_ptr,
+                                           size_t size) {
+  cl_int err;
+  cl::Buffer buffer(context_, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, size,
+                    host_ptr, &err);
+  CL_CHECK(err);
+  return buffer;
+}
+
+bool OpenclDevice::SetArenaSlot(int index, Tag tag, size_t size,
+                                bool& is_reused) {
+  const size_t arena_size = FLAGS_opencl_buffer_arena_kib << 10;
+  if (arena_size == 0 || !SupportsBufferArena() || size == 0 ||
+      size > FLAGS_opencl_buffer_arena_max_bytes ||
+      // Tracking dirty pages needs a device buffer of its own.
+      (FLAGS_opencl_dirty_page_tracking && tag == Tag::kWriteOnly) ||
+      // Slots are shared by all runs, including those in flight.
+      !runs_in_flight_.empty()) {
+    return false;
+  }
+  const int bank = GetArgBank(index);
+  auto it = arena_slots_.find(index);
+  const bool fits_slot = it != arena_slots_.end() &&
+                         it->second.bank == bank && it->second.capacity >= size;
+  if (FLAGS_opencl_buffer_cache && fits_slot && it->second.size == size) {
+    is_reused = true;
+    return true;
+  }
+
+  BufferArena& arena = arenas_[bank];
+  if (arena.buffer() == nullptr) {
+    VLOG(1) << "Allocating a buffer arena of " << arena_size
+            << " bytes in memory bank " << bank;
+    arena.staging.resize(arena_size);
+    memory_manager_->MakeRoom(arena_size);
+    arena.buffer = CreateArenaBuffer(bank, arena.staging.data(), arena_size);
+    // Arenas are shared by many arguments, so they are never evicted.
+    memory_manager_->Add(this, bank, arena_size, /* evict = */ nullptr);
+  }
+  ArenaSlot slot = {bank, /* offset = */ 0, size, /* capacity = */ size};
+  if (fits_slot) {
+    slot.offset = it->second.offset;
+    slot.capacity = it->second.capacity;
+  } else {
+    // Space of slots that are outgrown is not reclaimed.
+    const size_t alignment = GetBaseAddrAlignment();
+    slot.offset = (arena.used_bytes + alignment - 1) / alignment * alignment;
+    if (slot.offset + size > arena_size) {
+      VLOG(1) << "Buffer arena of memory bank " << bank
+              << " is full; allocating buffer argument #" << index
+              << " separately";
+      return false;
+    }
+    arena.used_bytes = slot.offset + size;
+  }
+  ReleaseBuffer(index);
+  buffer_table_[index] =
+      GetRegion(arena.buffer, slot.offset, slot.offset + size);
+  arena_slots_[index] = slot;
+  BufferInfo& info = buffer_info_table_[index];
+  info = {index, size};
+  info.memory_bank = bank;
+  info.in_arena = true;
+  return true;
+}
+
+std::vector<cl::Memory> OpenclDevice::StageArenaLoads() {
+  std::map<int, std::pair<size_t, size_t>> ranges;
+  for (auto index : load_indices_) {
+    auto it = arena_slots_.find(index);
+    if (it == arena_slots_.end()) continue;
+    const ArenaSlot& slot = it->second;
+    const BufferArg& arg = buffer_arg_table_.at(index);
+    BufferInfo& info = buffer_info_table_.at(index);
+    info.load_bytes = arg.ActiveSizeInBytes();
+    info.skipped_load_bytes = 0;
+    if (arg.ActiveSizeInBytes() == 0) continue;
+    const size_t begin = slot.offset + arg.ActiveOffsetInBytes();
+    std::memcpy(arenas_.at(slot.bank).staging.data() + begin,
+                arg.Get() + arg.ActiveOffsetInBytes(), arg.ActiveSizeInBytes());
+    ExtendRange(ranges, slot.bank, begin, begin + arg.ActiveSizeInBytes());
+  }
+  return GetArenaRegions(ranges);
+}
+
+std::vector<cl::Memory> OpenclDevice::GetArenaStores() const {
+  std::map<int, std::pair<size_t, size_t>> ranges;
+  for (auto index : store_indices_) {
+    auto it = arena_slots_.find(index);
+    if (it == arena_slots_.end()) continue;
+    const BufferArg& arg = buffer_arg_table_.at(index);
+    if (arg.ActiveSizeInBytes() == 0) continue;
+    const size_t begin = it->second.offset + arg.ActiveOffsetInBytes();
+    ExtendRange(ranges, it->second.bank, begin,
+                begin + arg.ActiveSizeInBytes());
+    pending_stores_.push_back(
+        {index, arg, cl::Buffer(), it->second.bank, it->second.offset});
+  }
+  return GetArenaRegions(ranges);
+}
+
+std::vector<cl::Memory> OpenclDevice::GetArenaRegions(
+    const std::map<int, std::pair<size_t, size_t>>& ranges) const {
   std::vector<cl::Memory> buffers;
-  buffers.reserve(load_indices_.size());
+  const size_t alignment = GetBaseAddrAlignment();
+  for (const auto& [bank, range] : ranges) {
+    buffers.push_back(GetRegion(arenas_.at(bank).buffer,
+                                range.first / alignment * alignment,
+                                range.second));
+  }
+  return buffers;
+}
+
+void OpenclDevice::ReleaseBuffer(int index) {
+  int64_t id;
+  {
+    std::lock_guard<std::mutex> lock(eviction_mtx_);
+    auto it = buffer_memory_ids_.find(index);
+    if (it == buffer_memory_ids_.end()) return;
+    id = it->second;
+    buffer_memory_ids_.erase(it);
+    DropBuffer(index);
+  }
+  // Not locked, because evictions lock the memory manager first.
+  memory_manager_->Remove(id);
+}
+
+cl::Buffer OpenclDevice::AllocateBuffer(int index, cl_mem_flags flags,
+                                        void* host_ptr, size_t size) {
+  ReleaseBuffer(index);
+  arena_slots_.erase(index);
+  memory_manager_->MakeRoom(size);
+  const bool is_staged = ShouldStage(host_ptr, size);
+  cl::Buffer buffer =
+      CreateBuffer(index, flags, is_staged ? nullptr : host_ptr, size);
+  buffer_info_table_.at(index).staged = is_staged;
+  const int64_t id = memory_manager_->Add(
+      this, buffer_info_table_.at(index).memory_bank, size, [this, index] {
+        std::lock_guard<std::mutex> lock(eviction_mtx_);
+        VLOG(1) << "Evicting buffer argument #" << index;
+        buffer_memory_ids_.erase(index);
+        DropBuffer(index);
+      });
+  std::lock_guard<std::mutex> lock(eviction_mtx_);
+  buffer_memory_ids_[index] = id;
+  return buffer;
+}
+
+void OpenclDevice::DropBuffer(int index) {
+  buffer_table_.at(index) = cl::Buffer();
+  SetCreatedKernelArg(index, sizeof(cl_mem), nullptr);
+}
+
+void OpenclDevice::SetCreatedKernelArg(int index, size_t size,
+                                       const void* value) {
+  // Looked up without `GetKernel`, which would mark this device in use.
+  auto it = std::prev(kernel_names_.upper_bound(index));
+  if (auto kernel = kernels_.find(it->first); kernel != kernels_.end()) {
+    kernel->second.setArg(index - it->first, size, value);
+  }
+}
+
+void OpenclDevice::ResetKernelArgs() {
+  for (const auto& [index, buffer] : buffer_table_) {
+    SetCreatedKernelArg(index, sizeof(cl_mem), nullptr);
+  }
+  for (const auto& [index, id] : device_buffer_args_) {
+    SetCreatedKernelArg(index, sizeof(cl_mem), nullptr);
+  }
+  for (const auto& [index, size] : scalar_arg_sizes_) {
+    const std::vector<char> zeros(size);
+    SetCreatedKernelArg(index, size, zeros.data());
+  }
+}
+
+bool OpenclDevice::IsEvicted(int index) const {
+  std::lock_guard<std::mutex> lock(eviction_mtx_);
+  return buffer_memory_ids_.count(index) == 0 &&
+         arena_slots_.count(index) == 0;
+}
+
+void OpenclDevice::MarkIdle() {
+  // Results have been read back, so buffers may be evicted until next used.
+  memory_manager_->SetIdle(this, true);
+  is_idle_ = true;
+}
+
+void OpenclDevice::MarkInUse() const {
+  if (is_idle_) {
+    memory_manager_->SetIdle(this, false);
+    is_idle_ = false;
+  }
+}
+
+std::vector<cl::Event> OpenclDevice::GetPreviousEvents() {
+  // Runs in flight have taken their events, so the queue is drained instead.
+  if (!runs_in_flight_.empty()) {
+    CL_CHECK(cmd_.finish());
+  }
+  // The queue is out of order, so all previous commands are waited for.
+  std::vector<cl::Event> events = load_event_;
+  events.insert(events.end(), compute_event_.begin(), compute_event_.end());
+  events.insert(events.end(), store_event_.begin(), store_event_.end());
+  return events;
+}
+
+void OpenclDevice::RestoreEvictedBuffers() {
+  MarkInUse();
+  for (const auto* indices : {&load_indices_, &store_indices_}) {
+    for (int index : *indices) {
+      if (!IsEvicted(index)) {
+        memory_manager_->Touch(buffer_memory_ids_.at(index));
+        continue;
+      }
+      RestoreBuffer(index);
+    }
+  }
+}
+
+void OpenclDevice::RestoreBuffer(int index) {
+  VLOG(1) << "Restoring evicted buffer argument #" << index;
+  const BufferArg& arg = buffer_arg_table_.at(index);
+  const BufferInfo info = buffer_info_table_.at(index);
+  cl::Buffer buffer = AllocateBuffer(index, buffer_keys_.at(index).flags,
+                                     arg.Get(), arg.SizeInBytes());
+  buffer_info_table_.at(index) = info;
+  auto pair = GetKernel(index);
+  pair.second.setArg(pair.first, buffer);
+  // The new device buffer needs all pages loaded again.
+  if (auto it = dirty_page_trackers_.find(index);
+      it != dirty_page_trackers_.end()) {
+    it->second.reset();
+    it->second =
+        std::make_unique<DirtyPageTracker>(arg.Get(), arg.SizeInBytes());
+  }
+}
+
+bool OpenclDevice::RebindHostPtr(int index, void* host_ptr) { return false; }
+
+size_t OpenclDevice::GetZeroCopyAlignment() const {
+  return GetBaseAddrAlignment();
+}
+
+bool OpenclDevice::ShouldStage(const void* host_ptr, size_t size) const {
+  return FLAGS_opencl_staging_min_kib != 0 &&
+         size >= FLAGS_opencl_staging_min_kib << 10 &&
+         reinterpret_cast<uintptr_t>(host_ptr) % GetZeroCopyAlignment() != 0;
+}
+
+bool OpenclDevice::IsStaged(int index) const {
+  return buffer_info_table_.at(index).staged;
+}
+
+void OpenclDevice::LoadStagedBuffers() {
+  for (auto index : load_indices_) {
+    if (!IsStaged(index)) continue;
+    const auto tic = std::chrono::steady_clock::now();
+    const BufferArg& arg = buffer_arg_table_.at(index);
+    size_t size = 0;
+    for (const auto& range : GetLoadRanges(index)) {
+      for (auto& event :
+           GetStagingRing().Write(buffer_table_.at(index), range.offset,
+                                  arg.Get() + range.offset, range.size)) {
+        load_event_.push_back(std::move(event));
+      }
+      size += range.size;
+    }
+    RecordStagedBandwidth(index, size, tic);
+  }
+}
+
+void OpenclDevice::CompleteStores(const std::vector<PendingStore>& stores,
+                                  std::vector<cl::Event>& events) {
+  for (const PendingStore& store : stores) {
+    const BufferArg& arg = store.arg;
+    if (store.buffer() == nullptr) {
+      std::memcpy(arg.Get() + arg.ActiveOffsetInBytes(),
+                  arenas_.at(store.bank).staging.data() + store.offset +
+                      arg.ActiveOffsetInBytes(),
+                  arg.ActiveSizeInBytes());
+      continue;
+    }
+    const auto tic = std::chrono::steady_clock::now();
+    for (auto& event : GetStagingRing().Read(
+             store.buffer, arg.ActiveOffsetInBytes(),
+             arg.Get() + arg.ActiveOffsetInBytes(), arg.ActiveSizeInBytes())) {
+      events.push_back(std::move(event));
+    }
+    RecordStagedBandwidth(store.index, arg.ActiveSizeInBytes(), tic);
+  }
+}
+
+StagingRing& OpenclDevice::GetStagingRing() {
+  if (staging_ring_ == nullptr) {
+    // Copies run close to the device, like the threads of `Instance`.
+    std::vector<int> cpus;
+    if (const std::string bdf = GetPcieBdf();
+        FLAGS_numa_placement && !bdf.empty()) {
+      cpus = GetNumaPlacement(bdf).cpus;
+    }
+    staging_ring_ = std::make_unique<StagingRing>(
+        context_, cmd_, FLAGS_opencl_staging_chunk_kib << 10,
+        FLAGS_opencl_staging_slots, FLAGS_opencl_staging_threads, cpus);
+  }
+  return *staging_ring_;
+}
+
+void OpenclDevice::RecordStagedBandwidth(
+    int index, size_t size, std::chrono::steady_clock::time_point tic) {
+  const int64_t elapsed_ns = std::chrono::nanoseconds(
+                                 std::chrono::steady_clock::now() - tic)
+                                 .count();
+  BufferInfo& info = buffer_info_table_.at(index);
+  // Bytes per nanosecond are GB/s.
+  info.staged_gbps = elapsed_ns == 0 ? 0 : double(size) / elapsed_ns;
+  VLOG(1) << "Staged " << size << " bytes of buffer argument #" << index
+          << " at " << info.staged_gbps << " GB/s";
+}
+
+std::vector<cl::Memory> OpenclDevice::GetLoadBuffers() {
+  RestoreEvictedBuffers();
+  std::vector<cl::Memory> buffers = StageArenaLoads();
+  buffers.reserve(buffers.size() + load_indices_.size());
   for (auto index : load_indices_) {
-    buffers.push_back(buffer_table_.at(index));
+    if (arena_slots_.count(index) != 0 || IsStaged(index)) continue;
+    for (const auto& range : GetLoadRanges(index)) {
+      buffers.push_back(GetSubBuffer(index, range));
+    }
   }
   return buffers;
 }
 
 std::vector<cl::Memory> OpenclDevice::GetStoreBuffers() const {
-  std::vector<cl::Memory> buffers;
-  buffers.reserve(store_indices_.size());
+  MarkInUse();
+  pending_stores_.clear();
+  std::vector<cl::Memory> buffers = GetArenaStores();
+  buffers.reserve(buffers.size() + store_indices_.size());
   for (auto index : store_indices_) {
-    buffers.push_back(buffer_table_.at(index));
+    if (arena_slots_.count(index) != 0) continue;
+    const BufferArg& arg = buffer_arg_table_.at(index);
+    // Evicted buffers were read back before `Finish`.
+    if (arg.ActiveSizeInBytes() == 0 || IsEvicted(index)) continue;
+    if (IsStaged(index)) {
+      // Read back through the staging ring once the commands finish.
+      pending_stores_.push_back({index, arg, buffer_table_.at(index)});
+      continue;
+    }
+    buffers.push_back(GetSubBuffer(
+        index, {arg.ActiveOffsetInBytes(), arg.ActiveSizeInBytes()}));
   }
   return buffers;
 }
 
-std::pair<int, cl::Kernel> OpenclDevice::GetKernel(int index) const {
-  auto it = std::prev(kernels_.upper_bound(index));
-  return {index - it->first, it->second};
+std::vector<ByteRange> OpenclDevice::GetLoadRanges(int index) {
+  const BufferArg& arg = buffer_arg_table_.at(index);
+  std::vector<ByteRange> ranges;
+  if (auto it = dirty_page_trackers_.find(index);
+      it != dirty_page_trackers_.end()) {
+    ranges = it->second->TakeDirtyRanges(arg.ActiveOffsetInBytes(),
+                                         arg.ActiveSizeInBytes());
+  } else if (arg.ActiveSizeInBytes() != 0) {
+    ranges.push_back({arg.ActiveOffsetInBytes(), arg.ActiveSizeInBytes()});
+  }
+  size_t load_bytes = 0;
+  for (const auto& range : ranges) {
+    load_bytes += range.size;
+  }
+  BufferInfo& info = buffer_info_table_.at(index);
+  info.load_bytes = load_bytes;
+  info.skipped_load_bytes = arg.ActiveSizeInBytes() - load_bytes;
+  return ranges;
+}
+
+cl::Buffer OpenclDevice::GetSubBuffer(int index, ByteRange range) const {
+  cl::Buffer buffer = buffer_table_.at(index);
+  if (range.offset == 0 &&
+      range.size == buffer_arg_table_.at(index).SizeInBytes()) {
+    return buffer;
+  }
+  // Sub-buffers must begin at an aligned offset.
+  const size_t alignment = GetBaseAddrAlignment();
+  const size_t begin = range.offset / alignment * alignment;
+  const size_t end = range.offset + range.size;
+  const cl_buffer_region region = {begin, end - begin};
+  cl_int err;
+  cl::Buffer sub_buffer = buffer.createSubBuffer(
+      /* flags = */ 0, CL_BUFFER_CREATE_TYPE_REGION, &region, &err);
+  CL_CHECK(err);
+  return sub_buffer;
+}
+
+size_t OpenclDevice::GetBaseAddrAlignment() const {
+  // The device reports the alignment in bits.
+  const size_t align_bits = device_.getInfo<CL_DEVICE_MEM_BASE_ADDR_ALIGN>();
+  return std::max<size_t>(align_bits / 8, 1);
+}
+
+std::pair<int, cl::Kernel> OpenclDevice::GetKernel(int index) {
+  MarkInUse();
+  auto it = std::prev(kernel_names_.upper_bound(index));
+  auto kernel = kernels_.find(it->first);
+  if (kernel == kernels_.end()) {
+    const auto tic = std::chrono::steady_clock::now();
+    kernel = kernels_
+                 .emplace(it->first, cached_program_->AcquireKernel(it->second))
+                 .first;
+    startup_phases_.Add("kernel " + it->second,
+                        std::chrono::steady_clock::now() - tic);
+  }
+  return {index - it->first, kernel->second};
 }
 
 }  // namespace internal
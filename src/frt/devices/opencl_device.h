@@ -4,31 +4,68 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <CL/cl2.hpp>
 
+#include "frt/aligned_allocator.h"
 #include "frt/arg_info.h"
+#include "frt/bitstream.h"
+#include "frt/buffer_arg.h"
+#include "frt/buffer_info.h"
 #include "frt/device.h"
+#include "frt/device_memory_stats.h"
+#include "frt/device_run.h"
+#include "frt/devices/device_memory_manager.h"
+#include "frt/devices/dirty_page_tracker.h"
 #include "frt/devices/opencl_device_matcher.h"
+#include "frt/devices/opencl_program_cache.h"
+#include "frt/devices/staging_ring.h"
+#include "frt/devices/startup_phase_recorder.h"
+#include "frt/map_mode.h"
+#include "frt/memory_bank.h"
+#include "frt/startup_phase.h"
 #include "frt/stream_wrapper.h"
 #include "frt/tag.h"
 
 namespace fpga {
 namespace internal {
 
+class OpenclRun;
+
 class OpenclDevice : public Device {
  public:
+  ~OpenclDevice() override;
+
   void SetScalarArg(int index, const void* arg, int size) override;
   void SetBufferArg(int index, Tag tag, const BufferArg& arg) override;
   size_t SuspendBuffer(int index) override;
+  int CreateDeviceBuffer(size_t size) override;
+  void SetDeviceBufferArg(int index, int id) override;
+  void ReadDeviceBuffer(int id, size_t offset, size_t size,
+                        void* host_ptr) override;
+  void WriteDeviceBuffer(int id, size_t offset, size_t size,
+                         const void* host_ptr) override;
+  void* MapBuffer(int index, size_t offset, size_t size,
+                  MapMode mode) override;
+  void UnmapBuffer(int index, void* ptr) override;
 
+  // Migrates buffers with `clEnqueueMigrateMemObjects`; backends that need
+  // explicit reads and writes override these.
+  void WriteToDevice() override;
+  void ReadFromDevice() override;
   void Exec() override;
   void Finish() override;
+  std::unique_ptr<DeviceRun> TakeRun() override;
 
   std::vector<ArgInfo> GetArgsInfo() const override;
   int64_t LoadTimeNanoSeconds() const override;
@@ -36,33 +73,234 @@ class OpenclDevice : public Device {
   int64_t StoreTimeNanoSeconds() const override;
   size_t LoadBytes() const override;
   size_t StoreBytes() const override;
+  std::vector<StartupPhase> GetStartupPhases() const override;
+  std::vector<BufferInfo> GetBuffersInfo() const override;
+  std::vector<MemoryBank> GetMemoryTopology() const override;
+  std::string GetPcieBdf() const override;
+  DeviceMemoryStats GetDeviceMemoryStats() const override;
 
  protected:
-  void Initialize(const cl::Program::Binaries& binaries,
-                  const std::string& vendor_name,
+  void Initialize(const Bitstream& bitstream, const std::string& vendor_name,
                   const OpenclDeviceMatcher& device_matcher,
                   const std::vector<std::string>& kernel_names,
                   const std::vector<int>& kernel_arg_counts);
+  // Records `kernel_names`, whose arguments start at the corresponding
+  // `kernel_arg_counts`, so that `GetKernel` creates them on demand.
+  void SetKernelNames(const std::vector<std::string>& kernel_names,
+                      const std::vector<int>& kernel_arg_counts);
+  // Returns `GetProgramId(bitstream)`, computed on the first call only, so
+  // that the metadata and program caches share one identifier.
+  const std::string& GetCachedProgramId(const Bitstream& bitstream);
+  // Returns an identifier of `bitstream` used as part of the cache keys. By
+  // default, files are identified by their path, inode, size, and
+  // modification time, and only unmapped content is hashed.
+  virtual std::string GetProgramId(const Bitstream& bitstream) const;
+  // Returns options for building programs.
+  virtual std::string GetBuildOptions() const { return ""; }
+  // Creates and builds a program from `binary` for `device`.
+  virtual cl::Program CreateProgram(const cl::Context& context,
+                                    const cl::Device& device,
+                                    std::string_view binary) const;
+  // Creates the buffer of argument `index` and records whether it is
+  // zero-copy, i.e., whether `CL_MEM_USE_HOST_PTR` is set and `host_ptr` is
+  // aligned to `GetZeroCopyAlignment()`.
   virtual cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
                                   size_t size);
+  // Creates the buffer of argument `index` with `CreateBuffer` after freeing
+  // the previous one, evicting idle buffers if needed to stay within the
+  // device memory budget, and records it with the memory manager. Buffers to
+  // stage are created without `host_ptr`.
+  cl::Buffer AllocateBuffer(int index, cl_mem_flags flags, void* host_ptr,
+                            size_t size);
+  // Makes the buffer of argument `index` a sub-buffer of the arena of its
+  // memory bank if `--opencl_buffer_arena_kib` is set and the argument is
+  // small, reusing its previous slot if large enough. Sets `is_reused` if the
+  // sub-buffer is unchanged. Returns false if the argument is not packed.
+  bool SetArenaSlot(int index, Tag tag, size_t size, bool& is_reused);
+  // Copies the active ranges of arena slots to load into their arenas, and
+  // returns the ranges of arenas to load, one per memory bank.
+  std::vector<cl::Memory> StageArenaLoads();
+  // Returns the ranges of arenas to store, one per memory bank.
+  std::vector<cl::Memory> GetArenaStores() const;
+  // Returns sub-buffers of arenas covering `[begin, end)` ranges by bank.
+  std::vector<cl::Memory> GetArenaRegions(
+      const std::map<int, std::pair<size_t, size_t>>& ranges) const;
+  // Frees the device buffer of argument `index`, if any, and forgets it.
+  void ReleaseBuffer(int index);
+  // Frees the buffer of argument `index` and unsets it in its kernel, so that
+  // the kernel does not keep it alive. The argument stays set otherwise.
+  void DropBuffer(int index);
+  // Sets argument `index` of its kernel if the kernel has been created.
+  void SetCreatedKernelArg(int index, size_t size, const void* value);
+  // Unsets buffer arguments and zeroes scalar arguments of all kernels.
+  void ResetKernelArgs();
+  // Whether the buffer of argument `index` has been evicted and not restored.
+  bool IsEvicted(int index) const;
+  // Lets the memory manager evict buffers of this device until next used.
+  // Called by `Finish` and when the last run in flight is waited for.
+  void MarkIdle();
+  // Marks the buffers of this device in use until `MarkIdle`, so that they are
+  // not evicted. Must be called before touching buffers or kernels.
+  void MarkInUse() const;
+  // Returns the events that commands accessing buffers from the host must wait
+  // for, i.e., those of all previous commands, draining the queue instead if
+  // runs in flight have taken theirs.
+  std::vector<cl::Event> GetPreviousEvents();
+  // Marks buffers in use and creates evicted buffers to transfer again.
+  void RestoreEvictedBuffers();
+  // Creates the evicted buffer of argument `index` again.
+  void RestoreBuffer(int index);
+  // Makes the existing buffer of argument `index` transfer from and to
+  // `host_ptr` instead, if the backend supports it. Otherwise returns false,
+  // and a new buffer is created.
+  virtual bool RebindHostPtr(int index, void* host_ptr);
+  // Returns the alignment in bytes that host memory needs for the runtime to
+  // use it without a copy. Defaults to `CL_DEVICE_MEM_BASE_ADDR_ALIGN`.
+  virtual size_t GetZeroCopyAlignment() const;
+  // Returns the memory bank that argument `index` is allocated in, or -1 if
+  // it is left to the vendor runtime.
+  virtual int GetArgBank(int index) const { return -1; }
+  // Returns whether small buffers may be packed into arenas. Backends that
+  // transfer from host pointers directly instead of migrating buffers cannot
+  // stage arguments through an arena.
+  virtual bool SupportsBufferArena() const { return true; }
+  // Creates the parent buffer of an arena in memory bank `bank`, mirrored by
+  // `size` bytes of page-aligned host memory at `host_ptr`.
+  virtual cl::Buffer CreateArenaBuffer(int bank, void* host_ptr, size_t size);
+
+  // Returns whether a buffer argument of `size` bytes at `host_ptr` is
+  // transferred through the staging ring, i.e., whether it is at least
+  // `--opencl_staging_min_kib` and not aligned to `GetZeroCopyAlignment()`.
+  bool ShouldStage(const void* host_ptr, size_t size) const;
+  // Whether buffer argument `index` is transferred through the staging ring.
+  bool IsStaged(int index) const;
+  // Loads the staged buffers through the staging ring, blocking until done,
+  // and appends the transfers to `load_event_`.
+  void LoadStagedBuffers();
+  // A buffer argument copied to the host after its commands finish, from its
+  // arena slot or through the staging ring.
+  struct PendingStore {
+    int index;
+    BufferArg arg;
+    // The staged buffer to read, kept alive if the argument is set again.
+    cl::Buffer buffer;
+    // The arena slot to copy from if `buffer` is null.
+    int bank = -1;
+    size_t offset = 0;
+  };
+  // Copies `stores` to the host once their commands have finished, and
+  // appends the transfers through the staging ring to `events`.
+  void CompleteStores(const std::vector<PendingStore>& stores,
+                      std::vector<cl::Event>& events);
+  // Returns the staging ring, which is created on first use.
+  StagingRing& GetStagingRing();
+  // Records the bandwidth of staging `size` bytes of argument `index` since
+  // `tic`.
+  void RecordStagedBandwidth(int index, size_t size,
+                             std::chrono::steady_clock::time_point tic);
 
-  std::vector<cl::Memory> GetLoadBuffers() const;
+  // Return the ranges of buffers to load or store as (sub-)buffers.
+  std::vector<cl::Memory> GetLoadBuffers();
   std::vector<cl::Memory> GetStoreBuffers() const;
-  std::pair<int, cl::Kernel> GetKernel(int index) const;
+  // Returns the non-empty ranges of buffer argument `index` to load, i.e., its
+  // active range or, with dirty page tracking, the dirty parts of it, and
+  // records them in its `BufferInfo`.
+  std::vector<ByteRange> GetLoadRanges(int index);
+  // Returns the buffer of argument `index`, or a sub-buffer covering `range`
+  // if that is not the whole buffer.
+  cl::Buffer GetSubBuffer(int index, ByteRange range) const;
+  // Returns `CL_DEVICE_MEM_BASE_ADDR_ALIGN` in bytes.
+  size_t GetBaseAddrAlignment() const;
+  // Returns the kernel owning argument `index` and the index of the argument
+  // in that kernel. Kernels are created on first use.
+  std::pair<int, cl::Kernel> GetKernel(int index);
 
+  // Builds `binary` on the first device matching `device_matcher` of platform
+  // `vendor_name`, or of any platform if `vendor_name` is empty.
+  std::shared_ptr<OpenclProgram> BuildProgram(
+      std::string_view binary, const std::string& vendor_name,
+      const OpenclDeviceMatcher& device_matcher,
+      StartupPhaseRecorder& startup_phases) const;
+
+  // Starts when the device is constructed; backends record their own phases
+  // before calling `Initialize`.
+  StartupPhaseRecorder startup_phases_;
+
+  // Set by `GetCachedProgramId`.
+  std::string program_id_;
+  std::shared_ptr<OpenclProgram> cached_program_;
   cl::Device device_;
   cl::Context context_;
   cl::CommandQueue cmd_;
   cl::Program program_;
-  // Maps prefix sum of arg count to kernels.
+  // Maps prefix sum of arg count to kernels that have been created.
   std::map<int, cl::Kernel> kernels_;
+  // Maps prefix sum of arg count to names of all kernels.
+  std::map<int, std::string> kernel_names_;
   std::unordered_map<int, cl::Buffer> buffer_table_;
+  // Accounts buffers of all devices sharing `device_`. Buffers evicted while
+  // this device is idle are null in `buffer_table_` until restored.
+  DeviceMemoryManager* memory_manager_ = nullptr;
+  std::unordered_map<int, int64_t> buffer_memory_ids_;
+  mutable bool is_idle_ = false;
+  // Evictions run on the thread of the device making room, while this one is
+  // idle, and drop entries of `buffer_table_` and `buffer_memory_ids_` with
+  // this held. This device changes them only after `MarkInUse`, which waits
+  // for evictions in progress, and holds this when adding or removing entries
+  // or checking `IsEvicted`.
+  mutable std::mutex eviction_mtx_;
+  // Small buffer arguments packed into one allocation per memory bank.
+  struct BufferArena {
+    // Host mirror of `buffer` that arguments are staged through.
+    std::vector<char, AlignedAllocator<char>> staging;
+    cl::Buffer buffer;
+    size_t used_bytes = 0;
+  };
+  std::map<int, BufferArena> arenas_;
+  struct ArenaSlot {
+    int bank;
+    size_t offset;
+    size_t size;
+    // Bytes reserved, which may exceed `size` if the slot is reused.
+    size_t capacity;
+  };
+  std::unordered_map<int, ArenaSlot> arena_slots_;
+  // Bounce buffers for large arguments in unaligned host memory.
+  std::unique_ptr<StagingRing> staging_ring_;
+  // Set by `ReadFromDevice` until `Finish` or `TakeRun` takes them.
+  mutable std::vector<PendingStore> pending_stores_;
+  // Runs taken and not waited for. Their device buffers are not rebound to
+  // other host buffers and arena slots are not handed out meanwhile. Runs may
+  // outlive the device, which waits for and detaches them when destroyed.
+  std::unordered_set<OpenclRun*> runs_in_flight_;
+  // Buffers without a host mirror, indexed by id.
+  std::vector<cl::Buffer> device_buffers_;
+  // Ids of device buffers set as arguments, by argument index.
+  std::unordered_map<int, int> device_buffer_args_;
+  // Buffers mapped by `MapBuffer`, by mapped address.
+  std::unordered_multimap<void*, cl::Buffer> mapped_buffers_;
+  // The last argument set for each buffer, including its active range.
+  std::unordered_map<int, BufferArg> buffer_arg_table_;
+  std::unordered_map<int, BufferInfo> buffer_info_table_;
+  // Identifies the buffer of each argument for reuse by `SetBufferArg`.
+  struct BufferKey {
+    cl_mem_flags flags;
+    size_t size;
+    void* host_ptr;
+  };
+  std::unordered_map<int, BufferKey> buffer_keys_;
+  std::unordered_map<int, std::unique_ptr<DirtyPageTracker>>
+      dirty_page_trackers_;
   std::unordered_map<int, ArgInfo> arg_table_;
+  // Sizes of scalar arguments set so far, by index.
+  std::unordered_map<int, int> scalar_arg_sizes_;
   std::unordered_set<int> load_indices_;
   std::unordered_set<int> store_indices_;
   std::vector<cl::Event> load_event_;
   std::vector<cl::Event> compute_event_;
   std::vector<cl::Event> store_event_;
+
+  friend class OpenclRun;
 };
 
 }  // namespace internal
@@ -4,7 +4,7 @@
 
 #include <string>
 
-#include <CL/cl2.hpp>
+#include "frt/devices/opencl_inventory.h"
 
 namespace fpga {
 namespace internal {
@@ -14,8 +14,13 @@ class OpenclDeviceMatcher {
   // Returns the name of the target device.
   virtual std::string GetTargetName() const = 0;
 
+  // Returns the types of devices to match.
+  virtual cl_device_type GetDeviceType() const {
+    return CL_DEVICE_TYPE_ACCELERATOR;
+  }
+
   // Returns the name of matched device. Empty if not matched.
-  virtual std::string Match(cl::Device device) const = 0;
+  virtual std::string Match(const OpenclDeviceEntry& device) const = 0;
 };
 
 }  // namespace internal
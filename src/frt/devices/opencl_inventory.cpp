@@ -0,0 +1,93 @@
+#include "frt/devices/opencl_inventory.h"
+
+#include <cstring>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <CL/cl.h>
+#include <glog/logging.h>
+#include <CL/cl2.hpp>
+
+#include "frt/devices/opencl_util.h"
+#include "frt/devices/sysfs.h"
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+// Returns the PCIe BDF of a Xilinx device, normalized if well-formed, or an
+// empty string if unknown.
+std::string GetXilinxBdf(const cl::Device& device) {
+  char bdf[32];
+  size_t bdf_size = 0;
+  if (clGetDeviceInfo(device.get(), CL_DEVICE_PCIE_BDF, sizeof(bdf), bdf,
+                      &bdf_size) != CL_SUCCESS ||
+      bdf_size == 0) {
+    return "";
+  }
+  const std::string reported(bdf, strnlen(bdf, bdf_size));
+  if (std::string normalized = NormalizeBdf(reported); !normalized.empty()) {
+    return normalized;
+  }
+  LOG(WARNING) << "Malformed PCIe BDF '" << reported << "' of device '"
+               << device.getInfo<CL_DEVICE_NAME>() << "'";
+  return reported;
+}
+
+std::vector<OpenclPlatformEntry> Enumerate() {
+  const auto tic = std::chrono::steady_clock::now();
+  std::vector<cl::Platform> platforms;
+  CL_CHECK(cl::Platform::get(&platforms));
+  std::vector<OpenclPlatformEntry> inventory;
+  size_t device_count = 0;
+  cl_int err;
+  for (const auto& platform : platforms) {
+    auto& platform_entry = inventory.emplace_back();
+    platform_entry.platform = platform;
+    platform_entry.name = platform.getInfo<CL_PLATFORM_NAME>(&err);
+    CL_CHECK(err);
+    LOG(INFO) << "Found platform: " << platform_entry.name.c_str();
+
+    std::vector<cl::Device> devices;
+    // Platforms without devices report `CL_DEVICE_NOT_FOUND`.
+    if (platform.getDevices(CL_DEVICE_TYPE_ALL, &devices) != CL_SUCCESS) {
+      continue;
+    }
+    for (const auto& device : devices) {
+      auto& device_entry = platform_entry.devices.emplace_back();
+      device_entry.device = device;
+      device_entry.name = device.getInfo<CL_DEVICE_NAME>(&err);
+      CL_CHECK(err);
+      device_entry.type = device.getInfo<CL_DEVICE_TYPE>(&err);
+      CL_CHECK(err);
+      if (platform_entry.name == "Xilinx") {
+        device_entry.bdf = GetXilinxBdf(device);
+      }
+      LOG(INFO) << "Found device: " << device_entry.name
+                << (device_entry.bdf.empty()
+                        ? ""
+                        : " (bdf=" + device_entry.bdf + ")");
+      ++device_count;
+    }
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - tic;
+  LOG(INFO) << "Discovered " << device_count << " OpenCL device(s) on "
+            << inventory.size() << " platform(s) in " << elapsed.count()
+            << " s";
+  return inventory;
+}
+
+}  // namespace
+
+const std::vector<OpenclPlatformEntry>& GetOpenclInventory() {
+  static const auto* inventory =
+      new std::vector<OpenclPlatformEntry>(Enumerate());
+  return *inventory;
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,39 @@
+#ifndef FPGA_RUNTIME_OPENCL_INVENTORY_H_
+#define FPGA_RUNTIME_OPENCL_INVENTORY_H_
+
+#include <string>
+#include <vector>
+
+#include <CL/cl2.hpp>
+
+namespace fpga {
+namespace internal {
+
+struct OpenclDeviceEntry {
+  cl::Device device;
+  // Value of `CL_DEVICE_NAME`.
+  std::string name;
+  // Value of `CL_DEVICE_TYPE`.
+  cl_device_type type = 0;
+  // PCIe Bus:Device:Function, normalized (see `NormalizeBdf`) if well-formed
+  // and as reported otherwise. Empty if the platform does not report one.
+  std::string bdf;
+};
+
+struct OpenclPlatformEntry {
+  cl::Platform platform;
+  // Value of `CL_PLATFORM_NAME`.
+  std::string name;
+  // Devices of all types of the platform.
+  std::vector<OpenclDeviceEntry> devices;
+};
+
+// Returns all OpenCL platforms and their devices. Enumeration queries every
+// device of every installed ICD, which is slow on hosts with many cards, so it
+// runs once per process and the result is reused.
+const std::vector<OpenclPlatformEntry>& GetOpenclInventory();
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_OPENCL_INVENTORY_H_
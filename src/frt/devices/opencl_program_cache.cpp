@@ -0,0 +1,103 @@
+#include "frt/devices/opencl_program_cache.h"
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+#include <CL/cl2.hpp>
+
+#include "frt/devices/opencl_util.h"
+
+namespace fpga {
+namespace internal {
+
+cl::Kernel OpenclProgram::AcquireKernel(const std::string& name) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto& kernels = idle_kernels_[name]; !kernels.empty()) {
+      cl::Kernel kernel = std::move(kernels.back());
+      kernels.pop_back();
+      return kernel;
+    }
+  }
+  cl_int err;
+  cl::Kernel kernel(program, name.c_str(), &err);
+  CL_CHECK(err);
+  return kernel;
+}
+
+void OpenclProgram::ReleaseKernel(const std::string& name, cl::Kernel kernel) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  idle_kernels_[name].push_back(std::move(kernel));
+}
+
+OpenclProgramCache& OpenclProgramCache::Get() {
+  static OpenclProgramCache* cache = new OpenclProgramCache;
+  return *cache;
+}
+
+std::shared_ptr<OpenclProgram> OpenclProgramCache::GetOrBuild(
+    const std::string& key, const Builder& build) {
+  std::promise<std::shared_ptr<OpenclProgram>> promise;
+  std::shared_future<std::shared_ptr<OpenclProgram>> future;
+  std::shared_ptr<OpenclProgram> program;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (programs_.count(key) == 0) {
+      EraseExpired();
+    }
+    Entry& entry = programs_[key];
+    if (entry.pending.valid()) {
+      future = entry.pending;
+    } else {
+      program = entry.program.lock();
+      if (program == nullptr) {
+        entry.pending = promise.get_future().share();
+      }
+    }
+  }
+
+  if (future.valid()) {
+    program = future.get();
+  }
+  if (program != nullptr) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++stats_.hits;
+    stats_.saved_nanoseconds += program->build_time.count();
+    VLOG(1) << "Reusing cached OpenCL program; " << stats_;
+    return program;
+  }
+
+  // Builds without holding the lock so that different programs can be built
+  // concurrently. `build` aborts on failure, so the promise is always set.
+  program = build();
+  promise.set_value(program);
+  std::lock_guard<std::mutex> lock(mtx_);
+  // The future would keep the program alive, so only a weak reference stays.
+  Entry& entry = programs_.at(key);
+  entry.pending = {};
+  entry.program = program;
+  ++stats_.misses;
+  return program;
+}
+
+void OpenclProgramCache::EraseExpired() {
+  for (auto it = programs_.begin(); it != programs_.end();) {
+    if (!it->second.pending.valid() && it->second.program.expired()) {
+      it = programs_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+CacheStats OpenclProgramCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return stats_;
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,90 @@
+#ifndef FPGA_RUNTIME_OPENCL_PROGRAM_CACHE_H_
+#define FPGA_RUNTIME_OPENCL_PROGRAM_CACHE_H_
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <CL/cl2.hpp>
+
+#include "frt/cache_stats.h"
+
+namespace fpga {
+namespace internal {
+
+// A device with a built program, shared by all `OpenclDevice`s loading the
+// same binary onto the same target.
+class OpenclProgram {
+ public:
+  OpenclProgram(cl::Device device, cl::Context context, cl::Program program,
+                std::chrono::nanoseconds build_time)
+      : device(std::move(device)),
+        context(std::move(context)),
+        program(std::move(program)),
+        build_time(build_time) {}
+
+  // Returns an idle kernel named `name`, creating one if there is none.
+  cl::Kernel AcquireKernel(const std::string& name);
+
+  // Returns `kernel` acquired with `AcquireKernel` for reuse. Arguments
+  // should be reset first, so that they do not keep buffers alive or leak into
+  // the next user.
+  void ReleaseKernel(const std::string& name, cl::Kernel kernel);
+
+  const cl::Device device;
+  const cl::Context context;
+  const cl::Program program;
+  // Time it took to create the context and build the program.
+  const std::chrono::nanoseconds build_time;
+
+ private:
+  std::mutex mtx_;
+  std::unordered_map<std::string, std::vector<cl::Kernel>> idle_kernels_;
+};
+
+// Process-wide cache of `OpenclProgram`s, so that instances of a bitstream
+// created while another one is alive skip platform enumeration, context
+// creation and programming. Entries are refcounted by the `OpenclDevice`s
+// using them and released with the last one, so that the context is not kept
+// open and later instances look for an available device again.
+class OpenclProgramCache {
+ public:
+  using Builder = std::function<std::shared_ptr<OpenclProgram>()>;
+
+  static OpenclProgramCache& Get();
+
+  // Returns the program cached for `key`, building and caching it with
+  // `build` if there is none. Concurrent callers with the same `key` wait for
+  // a single build.
+  std::shared_ptr<OpenclProgram> GetOrBuild(const std::string& key,
+                                            const Builder& build);
+
+  CacheStats GetStats() const;
+
+ private:
+  struct Entry {
+    // Valid while the program is being built.
+    std::shared_future<std::shared_ptr<OpenclProgram>> pending;
+    // Set once built; expires with the last device using the program.
+    std::weak_ptr<OpenclProgram> program;
+  };
+
+  // Erases entries whose programs have expired, so that processes loading many
+  // bitstreams do not accumulate them. Called with `mtx_` held before adding
+  // an entry.
+  void EraseExpired();
+
+  mutable std::mutex mtx_;
+  std::unordered_map<std::string, Entry> programs_;
+  CacheStats stats_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_OPENCL_PROGRAM_CACHE_H_
@@ -0,0 +1,84 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+#include "frt.h"
+
+namespace fpga {
+namespace {
+
+constexpr int kElementCount = 1 << 16;
+
+// Writes OpenCL C source of a kernel that scales a vector with a few rounds
+// of arithmetic per element, and returns its path.
+std::string WriteKernel() {
+  std::string path = "/tmp/opencl_run_queue_benchmark.XXXXXX.cl";
+  close(mkstemps(&path[0], /*suffixlen=*/3));
+  std::ofstream(path) << R"(
+__kernel void Scale(__global const float* in, __global float* out, int n) {
+  for (int i = 0; i < n; ++i) {
+    float value = in[i];
+    for (int j = 0; j < 16; ++j) {
+      value = value * 0.5f + 1.0f;
+    }
+    out[i] = value;
+  }
+}
+)";
+  return path;
+}
+
+// Measures invocations launched with up to `range(0)` runs in flight, each
+// with buffers of its own. Depth 1 waits for every run before launching the
+// next, like `Invoke`. Runs on the generic OpenCL backend, so it needs an
+// OpenCL platform, e.g., PoCL on the host; select one with
+// `--generic_opencl_platform`.
+void BM_QueuedRuns(benchmark::State& state) {
+  const size_t depth = state.range(0);
+  const std::string path = WriteKernel();
+  Instance instance(path);
+  unlink(path.c_str());
+
+  std::vector<std::vector<float, AlignedAllocator<float>>> inputs(
+      depth, std::vector<float, AlignedAllocator<float>>(kElementCount, 1));
+  std::vector<std::vector<float, AlignedAllocator<float>>> outputs(
+      depth, std::vector<float, AlignedAllocator<float>>(kElementCount));
+  std::deque<Run> runs;
+  int64_t compute_time_ns = 0;
+  int64_t run_count = 0;
+  for (auto _ : state) {
+    if (runs.size() == depth) {
+      compute_time_ns += runs.front().ComputeTimeNanoSeconds();
+      runs.pop_front();
+    }
+    const int slot = run_count++ % depth;
+    runs.push_back(instance.Launch(
+        WriteOnly(inputs[slot].data(), kElementCount),
+        ReadOnly(outputs[slot].data(), kElementCount), kElementCount));
+  }
+  for (; !runs.empty(); runs.pop_front()) {
+    compute_time_ns += runs.front().ComputeTimeNanoSeconds();
+  }
+  state.counters["depth"] = depth;
+  state.counters["compute_ns"] =
+      benchmark::Counter(compute_time_ns, benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(run_count);
+  state.SetBytesProcessed(run_count * kElementCount * sizeof(float) * 2);
+}
+BENCHMARK(BM_QueuedRuns)
+    ->ArgName("depth")
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace fpga
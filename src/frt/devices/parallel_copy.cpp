@@ -0,0 +1,145 @@
+#include "frt/devices/parallel_copy.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif  // __SSE2__
+
+#include "frt/devices/numa.h"
+
+namespace fpga {
+namespace internal {
+
+void StreamingCopy(void* dst, const void* src, size_t size) {
+#ifdef __SSE2__
+  auto* dst_bytes = static_cast<char*>(dst);
+  auto* src_bytes = static_cast<const char*>(src);
+  // Non-temporal stores need a 16-byte aligned destination; the source may be
+  // unaligned.
+  const size_t head = std::min(
+      size, (16 - reinterpret_cast<uintptr_t>(dst_bytes) % 16) % 16);
+  std::memcpy(dst_bytes, src_bytes, head);
+  dst_bytes += head;
+  src_bytes += head;
+  size -= head;
+  for (; size >= 64; dst_bytes += 64, src_bytes += 64, size -= 64) {
+    const auto* s = reinterpret_cast<const __m128i*>(src_bytes);
+    auto* d = reinterpret_cast<__m128i*>(dst_bytes);
+    const __m128i v0 = _mm_loadu_si128(s);
+    const __m128i v1 = _mm_loadu_si128(s + 1);
+    const __m128i v2 = _mm_loadu_si128(s + 2);
+    const __m128i v3 = _mm_loadu_si128(s + 3);
+    _mm_stream_si128(d, v0);
+    _mm_stream_si128(d + 1, v1);
+    _mm_stream_si128(d + 2, v2);
+    _mm_stream_si128(d + 3, v3);
+  }
+  for (; size >= 16; dst_bytes += 16, src_bytes += 16, size -= 16) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst_bytes),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                         src_bytes)));
+  }
+  // Orders the non-temporal stores before whatever hands the data over.
+  _mm_sfence();
+  std::memcpy(dst_bytes, src_bytes, size);
+#else   // __SSE2__
+  std::memcpy(dst, src, size);
+#endif  // __SSE2__
+}
+
+ParallelCopier::ParallelCopier(int thread_count, const std::vector<int>& cpus) {
+  for (int i = 1; i < thread_count; ++i) {
+    threads_.emplace_back(&ParallelCopier::Work, this, cpus);
+  }
+}
+
+ParallelCopier::~ParallelCopier() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    is_stopping_ = true;
+  }
+  parts_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ParallelCopier::Copy(void* dst, const void* src, size_t size) {
+  Copy({{dst, src, size}});
+}
+
+void ParallelCopier::Copy(const std::vector<Range>& ranges) {
+  size_t total_size = 0;
+  for (const Range& range : ranges) {
+    total_size += range.size;
+  }
+  if (threads_.empty() || total_size < kMinParallelBytes) {
+    for (const Range& range : ranges) {
+      StreamingCopy(range.dst, range.src, range.size);
+    }
+    return;
+  }
+  // Shares are cache-line multiples, so that a single range is split on line
+  // boundaries of the destination if it is aligned.
+  const size_t part_count = threads_.size() + 1;
+  const size_t share = (total_size / part_count + 63) / 64 * 64;
+  std::vector<Part> parts(1);
+  size_t part_size = 0;
+  for (Range range : ranges) {
+    while (range.size != 0) {
+      if (part_size == share) {
+        parts.emplace_back();
+        part_size = 0;
+      }
+      const size_t size = std::min(range.size, share - part_size);
+      parts.back().push_back({range.dst, range.src, size});
+      range.dst = static_cast<char*>(range.dst) + size;
+      range.src = static_cast<const char*>(range.src) + size;
+      range.size -= size;
+      part_size += size;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t i = 1; i < parts.size(); ++i) {
+      parts_.push_back(std::move(parts[i]));
+      ++pending_count_;
+    }
+  }
+  parts_cv_.notify_all();
+  for (const Range& range : parts.front()) {
+    StreamingCopy(range.dst, range.src, range.size);
+  }
+  std::unique_lock<std::mutex> lock(mtx_);
+  done_cv_.wait(lock, [this] { return pending_count_ == 0; });
+}
+
+void ParallelCopier::Work(const std::vector<int>& cpus) {
+  PinCurrentThread(cpus);
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    parts_cv_.wait(lock, [this] { return is_stopping_ || !parts_.empty(); });
+    if (is_stopping_) return;
+    const Part part = std::move(parts_.back());
+    parts_.pop_back();
+    lock.unlock();
+    for (const Range& range : part) {
+      StreamingCopy(range.dst, range.src, range.size);
+    }
+    lock.lock();
+    if (--pending_count_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,68 @@
+#ifndef FPGA_RUNTIME_PARALLEL_COPY_H_
+#define FPGA_RUNTIME_PARALLEL_COPY_H_
+
+#include <cstddef>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fpga {
+namespace internal {
+
+// Copies `size` bytes from `src` to `dst` with non-temporal stores where the
+// CPU supports them, so that data handed to DMA does not evict the cache.
+void StreamingCopy(void* dst, const void* src, size_t size);
+
+// Copies large ranges with `StreamingCopy` on several threads, since a single
+// core cannot saturate the memory bandwidth of most hosts.
+class ParallelCopier {
+ public:
+  struct Range {
+    void* dst;
+    const void* src;
+    size_t size;
+  };
+
+  // Ranges smaller than this are copied by the calling thread alone.
+  static constexpr size_t kMinParallelBytes = 256 << 10;
+
+  // Copies with `thread_count` threads including the calling one. Helper
+  // threads are restricted to `cpus` unless it is empty.
+  explicit ParallelCopier(int thread_count, const std::vector<int>& cpus = {});
+  ParallelCopier(const ParallelCopier&) = delete;
+  ParallelCopier& operator=(const ParallelCopier&) = delete;
+  ParallelCopier(ParallelCopier&&) = delete;
+  ParallelCopier& operator=(ParallelCopier&&) = delete;
+  ~ParallelCopier();
+
+  // Copies `size` bytes from `src` to `dst`, blocking until done.
+  void Copy(void* dst, const void* src, size_t size);
+
+  // Copies all of `ranges`, e.g., many small segments, blocking until done.
+  // Each thread copies about the same number of bytes.
+  void Copy(const std::vector<Range>& ranges);
+
+ private:
+  // Ranges copied by one thread.
+  using Part = std::vector<Range>;
+
+  void Work(const std::vector<int>& cpus);
+
+  std::vector<std::thread> threads_;
+  std::mutex mtx_;
+  // Signals new parts or stopping to helper threads.
+  std::condition_variable parts_cv_;
+  // Signals finished parts to the calling thread.
+  std::condition_variable done_cv_;
+  std::vector<Part> parts_;
+  // Parts handed out but not finished.
+  int pending_count_ = 0;
+  bool is_stopping_ = false;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_PARALLEL_COPY_H_
@@ -0,0 +1,78 @@
+#include "frt/devices/parallel_copy.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace fpga::internal {
+namespace {
+
+TEST(ParallelCopyTest, StreamingCopyHandlesUnalignedRanges) {
+  std::vector<char> src(256);
+  std::iota(src.begin(), src.end(), 0);
+  for (size_t dst_offset : {0, 1, 15}) {
+    for (size_t src_offset : {0, 3}) {
+      for (size_t size : {0, 7, 16, 64, 100, 200}) {
+        std::vector<char> dst(256, -1);
+
+        StreamingCopy(dst.data() + dst_offset, src.data() + src_offset, size);
+
+        for (size_t i = 0; i < dst.size(); ++i) {
+          const char expected = i >= dst_offset && i < dst_offset + size
+                                    ? src[i - dst_offset + src_offset]
+                                    : -1;
+          ASSERT_EQ(dst[i], expected)
+              << "dst_offset = " << dst_offset << ", src_offset = "
+              << src_offset << ", size = " << size << ", i = " << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(ParallelCopyTest, CopierSplitsLargeRangesAcrossThreads) {
+  constexpr size_t kSize = ParallelCopier::kMinParallelBytes * 3 + 5;
+  std::vector<int> src(kSize / sizeof(int) + 1);
+  std::iota(src.begin(), src.end(), 0);
+  ParallelCopier copier(/*thread_count=*/4);
+
+  for (int i = 0; i < 3; ++i) {
+    std::vector<int> dst(src.size());
+    copier.Copy(dst.data(), reinterpret_cast<char*>(src.data()) + 1, kSize);
+
+    EXPECT_EQ(memcmp(dst.data(), reinterpret_cast<char*>(src.data()) + 1,
+                     kSize),
+              0);
+  }
+}
+
+TEST(ParallelCopyTest, CopierBalancesManyRangesAcrossThreads) {
+  constexpr size_t kRangeCount = 1000;
+  constexpr size_t kRangeSize = ParallelCopier::kMinParallelBytes / 100;
+  std::vector<char> src(kRangeCount * kRangeSize);
+  std::iota(src.begin(), src.end(), 0);
+  // Reverses the order of the ranges.
+  std::vector<char> dst(src.size());
+  std::vector<ParallelCopier::Range> ranges;
+  for (size_t i = 0; i < kRangeCount; ++i) {
+    ranges.push_back({dst.data() + (kRangeCount - 1 - i) * kRangeSize,
+                      src.data() + i * kRangeSize, kRangeSize});
+  }
+  ParallelCopier copier(/*thread_count=*/3);
+
+  copier.Copy(ranges);
+
+  for (size_t i = 0; i < kRangeCount; ++i) {
+    ASSERT_EQ(memcmp(dst.data() + (kRangeCount - 1 - i) * kRangeSize,
+                     src.data() + i * kRangeSize, kRangeSize),
+              0)
+        << "i = " << i;
+  }
+}
+
+}  // namespace
+}  // namespace fpga::internal
@@ -0,0 +1,522 @@
+#include "frt/devices/software_device.h"
+
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+#include <nlohmann/json.hpp>
+
+#include "frt/arg_info.h"
+#include "frt/software_kernel.h"
+#include "frt/stream_interface.h"
+
+namespace fpga {
+
+namespace {
+
+std::mutex& GetKernelsMutex() {
+  static auto* mtx = new std::mutex;
+  return *mtx;
+}
+
+std::unordered_map<std::string, SoftwareKernel>& GetKernels() {
+  static auto* kernels = new std::unordered_map<std::string, SoftwareKernel>;
+  return *kernels;
+}
+
+}  // namespace
+
+bool RegisterSoftwareKernel(const std::string& name, SoftwareKernel kernel) {
+  std::lock_guard<std::mutex> lock(GetKernelsMutex());
+  LOG_IF(FATAL, !GetKernels().emplace(name, std::move(kernel)).second)
+      << "Software kernel '" << name << "' is already registered";
+  return true;
+}
+
+namespace internal {
+
+namespace {
+
+// A byte queue connecting the host and a software kernel. Ends of transfers
+// are kept as positions in the byte sequence.
+class Pipe : public SoftwareStream {
+ public:
+  size_t Read(void* ptr, size_t size) override {
+    std::unique_lock<std::mutex> lock(mtx_);
+    size_t n = 0;
+    while (n < size) {
+      cv_.wait(lock, [this] { return !data_.empty() || IsEndOfTransfer(); });
+      if (IsEndOfTransfer()) {
+        eot_positions_.pop_front();
+        break;
+      }
+      size_t chunk = std::min(size - n, data_.size());
+      if (!eot_positions_.empty()) {
+        chunk = std::min<size_t>(chunk, eot_positions_.front() - read_count_);
+      }
+      std::copy_n(data_.begin(), chunk, static_cast<char*>(ptr) + n);
+      data_.erase(data_.begin(), data_.begin() + chunk);
+      read_count_ += chunk;
+      n += chunk;
+    }
+    return n;
+  }
+
+  void Write(const void* ptr, size_t size, bool eot) override {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      const char* begin = static_cast<const char*>(ptr);
+      data_.insert(data_.end(), begin, begin + size);
+      write_count_ += size;
+      if (eot) {
+        eot_positions_.push_back(write_count_);
+      }
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  bool IsEndOfTransfer() const {
+    return !eot_positions_.empty() && eot_positions_.front() == read_count_;
+  }
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<char> data_;
+  std::deque<uint64_t> eot_positions_;
+  uint64_t read_count_ = 0;
+  uint64_t write_count_ = 0;
+};
+
+// Host side of a `Pipe`, owned by the `StreamWrapper`.
+class HostStream : public StreamInterface {
+ public:
+  HostStream(const std::string& name, std::shared_ptr<SoftwareStream> pipe)
+      : name_(name), pipe_(std::move(pipe)) {}
+
+  void Read(void* ptr, size_t size, bool eot) override {
+    const size_t n = pipe_->Read(ptr, size);
+    LOG_IF(WARNING, n < size) << "Stream '" << name_ << "' ended after " << n
+                              << " of " << size << " bytes";
+  }
+
+  void Write(const void* ptr, size_t size, bool eot) override {
+    pipe_->Write(ptr, size, eot);
+  }
+
+ private:
+  const std::string name_;
+  const std::shared_ptr<SoftwareStream> pipe_;
+};
+
+// Arguments captured when a kernel is enqueued.
+class KernelArgs : public SoftwareKernelArgs {
+ public:
+  size_t BufferSize(int index) const override {
+    return GetDeviceBuffer(index).size();
+  }
+
+  SoftwareStream& Stream(int index) const override {
+    auto it = streams.find(index);
+    LOG_IF(FATAL, it == streams.end())
+        << "Stream argument #" << index << " is not set";
+    return *it->second;
+  }
+
+  std::unordered_map<int, std::string> scalars;
+  std::unordered_map<int, std::shared_ptr<std::vector<char>>> buffers;
+  std::unordered_map<int, std::shared_ptr<SoftwareStream>> streams;
+
+ protected:
+  const void* GetScalar(int index, size_t size) const override {
+    auto it = scalars.find(index);
+    LOG_IF(FATAL, it == scalars.end())
+        << "Scalar argument #" << index << " is not set";
+    LOG_IF(FATAL, it->second.size() != size)
+        << "Scalar argument #" << index << " has " << it->second.size()
+        << " bytes; " << size << " bytes requested";
+    return it->second.data();
+  }
+
+  void* GetBuffer(int index) const override {
+    return GetDeviceBuffer(index).data();
+  }
+
+ private:
+  std::vector<char>& GetDeviceBuffer(int index) const {
+    auto it = buffers.find(index);
+    LOG_IF(FATAL, it == buffers.end())
+        << "Buffer argument #" << index << " is not set";
+    return *it->second;
+  }
+};
+
+ArgInfo::Cat ParseCat(const std::string& cat) {
+  if (cat == "scalar") return ArgInfo::kScalar;
+  if (cat == "mmap") return ArgInfo::kMmap;
+  if (cat == "stream") return ArgInfo::kStream;
+  LOG(FATAL) << "Unknown argument category: " << cat;
+  return ArgInfo::kScalar;
+}
+
+// Waits for a command enqueued after those of the run, which records their
+// times.
+class SoftwareRun : public DeviceRun {
+ public:
+  struct State {
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool is_done = false;
+    int64_t load_time_ns = 0;
+    int64_t compute_time_ns = 0;
+    int64_t store_time_ns = 0;
+  };
+
+  SoftwareRun(std::shared_ptr<State> state, size_t load_bytes,
+              size_t store_bytes)
+      : state_(std::move(state)),
+        load_bytes_(load_bytes),
+        store_bytes_(store_bytes) {}
+
+  void Wait() override {
+    std::unique_lock<std::mutex> lock(state_->mtx);
+    state_->cv.wait(lock, [this] { return state_->is_done; });
+  }
+
+  int64_t LoadTimeNanoSeconds() const override { return state_->load_time_ns; }
+  int64_t ComputeTimeNanoSeconds() const override {
+    return state_->compute_time_ns;
+  }
+  int64_t StoreTimeNanoSeconds() const override {
+    return state_->store_time_ns;
+  }
+  size_t LoadBytes() const override { return load_bytes_; }
+  size_t StoreBytes() const override { return store_bytes_; }
+
+ private:
+  const std::shared_ptr<State> state_;
+  const size_t load_bytes_;
+  const size_t store_bytes_;
+};
+
+}  // namespace
+
+SoftwareDevice::SoftwareDevice(const Bitstream& bitstream) {
+  const auto manifest = nlohmann::json::parse(
+      std::string(bitstream.Content()));
+  kernel_name_ = manifest.at("software_kernel").get<std::string>();
+  for (const auto& json_arg : manifest.at("args")) {
+    ArgInfo& arg = args_.emplace_back();
+    arg.index = args_.size() - 1;
+    arg.name = json_arg.at("name").get<std::string>();
+    arg.type = json_arg.value("type", "");
+    arg.cat = ParseCat(json_arg.at("cat").get<std::string>());
+  }
+  bandwidth_gbps_ = manifest.value("bandwidth_gbps", 0.);
+  compute_latency_ = std::chrono::nanoseconds(
+      static_cast<int64_t>(manifest.value("compute_latency_us", 0.) * 1e3));
+  {
+    std::lock_guard<std::mutex> lock(GetKernelsMutex());
+    auto it = GetKernels().find(kernel_name_);
+    LOG_IF(FATAL, it == GetKernels().end())
+        << "Software kernel '" << kernel_name_ << "' is not registered";
+    kernel_ = it->second;
+  }
+  startup_phases_.Record("manifest");
+
+  worker_ = std::thread([this] {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (true) {
+      cv_.wait(lock, [this] { return !commands_.empty() || is_stopping_; });
+      if (commands_.empty()) break;
+      auto command = std::move(commands_.front());
+      commands_.pop_front();
+      is_busy_ = true;
+      lock.unlock();
+      command();
+      lock.lock();
+      is_busy_ = false;
+      cv_.notify_all();
+    }
+  });
+  LOG(INFO) << "Running software kernel '" << kernel_name_ << "'";
+}
+
+SoftwareDevice::~SoftwareDevice() {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    is_stopping_ = true;
+  }
+  cv_.notify_all();
+  worker_.join();
+}
+
+std::unique_ptr<Device> SoftwareDevice::New(const Bitstream& bitstream) {
+  // Other JSON files are left to other backends.
+  if (bitstream.Header().find("\"software_kernel\"") ==
+      std::string_view::npos) {
+    return nullptr;
+  }
+  return std::make_unique<SoftwareDevice>(bitstream);
+}
+
+void SoftwareDevice::SetScalarArg(int index, const void* arg, int size) {
+  CheckArg(index, ArgInfo::kScalar);
+  scalars_[index].assign(static_cast<const char*>(arg), size);
+}
+
+void SoftwareDevice::SetBufferArg(int index, Tag tag, const BufferArg& arg) {
+  CheckArg(index, ArgInfo::kMmap);
+  buffer_table_.insert_or_assign(index, arg);
+  // Enqueued commands keep using the previous device buffer, if any.
+  auto& buffer = device_copies_[index];
+  if (buffer == nullptr || buffer.use_count() > 1 ||
+      buffer->size() != arg.SizeInBytes()) {
+    buffer = std::make_shared<std::vector<char>>(arg.SizeInBytes());
+  }
+  if (tag == Tag::kReadOnly || tag == Tag::kReadWrite) {
+    store_indices_.insert(index);
+  }
+  if (tag == Tag::kWriteOnly || tag == Tag::kReadWrite) {
+    load_indices_.insert(index);
+  }
+}
+
+void SoftwareDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
+  CheckArg(index, ArgInfo::kStream);
+  auto pipe = std::make_shared<Pipe>();
+  streams_[index] = pipe;
+  arg.Attach(std::make_unique<HostStream>(arg.name, std::move(pipe)));
+}
+
+size_t SoftwareDevice::SuspendBuffer(int index) {
+  return load_indices_.erase(index) + store_indices_.erase(index);
+}
+
+int SoftwareDevice::CreateDeviceBuffer(size_t size) {
+  device_buffers_.push_back(std::make_shared<std::vector<char>>(size));
+  return device_buffers_.size() - 1;
+}
+
+void SoftwareDevice::SetDeviceBufferArg(int index, int id) {
+  CheckArg(index, ArgInfo::kMmap);
+  SuspendBuffer(index);
+  buffer_table_.erase(index);
+  device_copies_[index] = device_buffers_.at(id);
+}
+
+void SoftwareDevice::ReadDeviceBuffer(int id, size_t offset, size_t size,
+                                      void* host_ptr) {
+  DeviceMemory buffer = device_buffers_.at(id);
+  Enqueue([this, buffer, offset, size, host_ptr] {
+    const auto tic = std::chrono::steady_clock::now();
+    memcpy(host_ptr, buffer->data() + offset, size);
+    WaitForTransfer(tic, size);
+  });
+  Finish();
+}
+
+void SoftwareDevice::WriteDeviceBuffer(int id, size_t offset, size_t size,
+                                       const void* host_ptr) {
+  DeviceMemory buffer = device_buffers_.at(id);
+  Enqueue([this, buffer, offset, size, host_ptr] {
+    const auto tic = std::chrono::steady_clock::now();
+    memcpy(buffer->data() + offset, host_ptr, size);
+    WaitForTransfer(tic, size);
+  });
+  Finish();
+}
+
+void* SoftwareDevice::MapBuffer(int index, size_t offset, size_t size,
+                                MapMode mode) {
+  CheckArg(index, ArgInfo::kMmap);
+  auto it = device_copies_.find(index);
+  LOG_IF(FATAL, it == device_copies_.end())
+      << "Buffer argument #" << index << " is not set";
+  LOG_IF(FATAL, offset + size > it->second->size())
+      << "Cannot map bytes [" << offset << ", " << offset + size
+      << ") of buffer argument #" << index << "; the buffer has only "
+      << it->second->size() << " bytes";
+  // Device copies live in host memory, so they are mapped in place once
+  // previous commands finish.
+  Finish();
+  return it->second->data() + offset;
+}
+
+void SoftwareDevice::UnmapBuffer(int index, void* ptr) {}
+
+void SoftwareDevice::WriteToDevice() {
+  std::vector<std::pair<BufferArg, DeviceMemory>> buffers;
+  for (int index : load_indices_) {
+    buffers.emplace_back(buffer_table_.at(index), device_copies_.at(index));
+  }
+  Enqueue([this, buffers = std::move(buffers)] {
+    load_time_ = Transfer(buffers, /*to_device=*/true).count();
+  });
+}
+
+void SoftwareDevice::ReadFromDevice() {
+  std::vector<std::pair<BufferArg, DeviceMemory>> buffers;
+  for (int index : store_indices_) {
+    buffers.emplace_back(buffer_table_.at(index), device_copies_.at(index));
+  }
+  Enqueue([this, buffers = std::move(buffers)] {
+    store_time_ = Transfer(buffers, /*to_device=*/false).count();
+  });
+}
+
+void SoftwareDevice::Exec() {
+  auto args = std::make_shared<KernelArgs>();
+  args->scalars = scalars_;
+  args->buffers = device_copies_;
+  args->streams = streams_;
+  Enqueue([this, args] {
+    const auto tic = std::chrono::steady_clock::now();
+    kernel_(*args);
+    std::this_thread::sleep_until(tic + compute_latency_);
+    compute_time_ = std::chrono::nanoseconds(
+                        std::chrono::steady_clock::now() - tic)
+                        .count();
+  });
+}
+
+void SoftwareDevice::Finish() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  cv_.wait(lock, [this] { return commands_.empty() && !is_busy_; });
+}
+
+std::unique_ptr<DeviceRun> SoftwareDevice::TakeRun() {
+  auto state = std::make_shared<SoftwareRun::State>();
+  // Commands run in order, so the times are those of the run's commands.
+  Enqueue([this, state] {
+    {
+      std::lock_guard<std::mutex> lock(state->mtx);
+      state->load_time_ns = load_time_;
+      state->compute_time_ns = compute_time_;
+      state->store_time_ns = store_time_;
+      state->is_done = true;
+    }
+    state->cv.notify_all();
+  });
+  return std::make_unique<SoftwareRun>(std::move(state), LoadBytes(),
+                                       StoreBytes());
+}
+
+std::vector<ArgInfo> SoftwareDevice::GetArgsInfo() const { return args_; }
+
+int64_t SoftwareDevice::LoadTimeNanoSeconds() const { return load_time_; }
+
+int64_t SoftwareDevice::ComputeTimeNanoSeconds() const {
+  return compute_time_;
+}
+
+int64_t SoftwareDevice::StoreTimeNanoSeconds() const { return store_time_; }
+
+size_t SoftwareDevice::LoadBytes() const {
+  size_t total_size = 0;
+  for (int index : load_indices_) {
+    total_size += buffer_table_.at(index).ActiveSizeInBytes();
+  }
+  return total_size;
+}
+
+size_t SoftwareDevice::StoreBytes() const {
+  size_t total_size = 0;
+  for (int index : store_indices_) {
+    total_size += buffer_table_.at(index).ActiveSizeInBytes();
+  }
+  return total_size;
+}
+
+std::vector<StartupPhase> SoftwareDevice::GetStartupPhases() const {
+  return startup_phases_.Get();
+}
+
+std::vector<BufferInfo> SoftwareDevice::GetBuffersInfo() const {
+  // Buffers are always copied to device copies.
+  std::vector<BufferInfo> infos;
+  infos.reserve(buffer_table_.size());
+  for (const auto& [index, buffer_arg] : buffer_table_) {
+    BufferInfo& info = infos.emplace_back();
+    info.index = index;
+    info.size = buffer_arg.SizeInBytes();
+    if (load_indices_.count(index)) {
+      info.load_bytes = buffer_arg.ActiveSizeInBytes();
+    }
+  }
+  std::sort(infos.begin(), infos.end(),
+            [](const BufferInfo& lhs, const BufferInfo& rhs) {
+              return lhs.index < rhs.index;
+            });
+  return infos;
+}
+
+std::vector<MemoryBank> SoftwareDevice::GetMemoryTopology() const {
+  return {};
+}
+
+std::string SoftwareDevice::GetPcieBdf() const { return ""; }
+
+DeviceMemoryStats SoftwareDevice::GetDeviceMemoryStats() const { return {}; }
+
+void SoftwareDevice::CheckArg(int index, ArgInfo::Cat cat) const {
+  LOG_IF(FATAL, index < 0 || index >= args_.size())
+      << "Cannot set argument #" << index << "; there are only "
+      << args_.size() << " arguments";
+  LOG_IF(FATAL, args_[index].cat != cat)
+      << "Cannot set argument '" << args_[index].name << "' as a " << cat
+      << "; it is a " << args_[index].cat;
+}
+
+std::chrono::nanoseconds SoftwareDevice::Transfer(
+    const std::vector<std::pair<BufferArg, DeviceMemory>>& buffers,
+    bool to_device) const {
+  const auto tic = std::chrono::steady_clock::now();
+  size_t total_size = 0;
+  for (const auto& [host_buffer, device_buffer] : buffers) {
+    const size_t offset = host_buffer.ActiveOffsetInBytes();
+    const size_t size = host_buffer.ActiveSizeInBytes();
+    if (to_device) {
+      memcpy(device_buffer->data() + offset, host_buffer.Get() + offset, size);
+    } else {
+      memcpy(host_buffer.Get() + offset, device_buffer->data() + offset, size);
+    }
+    total_size += size;
+  }
+  WaitForTransfer(tic, total_size);
+  return std::chrono::steady_clock::now() - tic;
+}
+
+void SoftwareDevice::WaitForTransfer(std::chrono::steady_clock::time_point tic,
+                                     size_t size) const {
+  if (bandwidth_gbps_ > 0) {
+    // 1 GB/s is 1 byte/ns.
+    std::this_thread::sleep_until(
+        tic + std::chrono::nanoseconds(
+                  static_cast<int64_t>(size / bandwidth_gbps_)));
+  }
+}
+
+void SoftwareDevice::Enqueue(std::function<void()> command) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    commands_.push_back(std::move(command));
+  }
+  cv_.notify_all();
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,144 @@
+#ifndef FPGA_RUNTIME_SOFTWARE_DEVICE_H_
+#define FPGA_RUNTIME_SOFTWARE_DEVICE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "frt/arg_info.h"
+#include "frt/bitstream.h"
+#include "frt/buffer_arg.h"
+#include "frt/buffer_info.h"
+#include "frt/device.h"
+#include "frt/device_memory_stats.h"
+#include "frt/device_run.h"
+#include "frt/devices/startup_phase_recorder.h"
+#include "frt/map_mode.h"
+#include "frt/memory_bank.h"
+#include "frt/software_kernel.h"
+#include "frt/startup_phase.h"
+#include "frt/stream_wrapper.h"
+#include "frt/tag.h"
+
+namespace fpga {
+namespace internal {
+
+// Runs a C++ function registered with `FRT_REGISTER_SOFTWARE_KERNEL` in place
+// of an FPGA kernel, as described by a JSON manifest (see `software_kernel.h`).
+// Buffers are copied to and from device copies in host memory, optionally at
+// a simulated bandwidth. Commands run in order on a worker thread, so that
+// the host can use streams while the kernel is running.
+class SoftwareDevice : public Device {
+ public:
+  static constexpr std::string_view kManifestExtension = ".json";
+
+  SoftwareDevice(const Bitstream& bitstream);
+  SoftwareDevice(const SoftwareDevice&) = delete;
+  SoftwareDevice& operator=(const SoftwareDevice&) = delete;
+  SoftwareDevice(SoftwareDevice&&) = delete;
+  SoftwareDevice& operator=(SoftwareDevice&&) = delete;
+
+  ~SoftwareDevice() override;
+
+  static std::unique_ptr<Device> New(const Bitstream& bitstream);
+
+  void SetScalarArg(int index, const void* arg, int size) override;
+  void SetBufferArg(int index, Tag tag, const BufferArg& arg) override;
+  void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override;
+  size_t SuspendBuffer(int index) override;
+  int CreateDeviceBuffer(size_t size) override;
+  void SetDeviceBufferArg(int index, int id) override;
+  void ReadDeviceBuffer(int id, size_t offset, size_t size,
+                        void* host_ptr) override;
+  void WriteDeviceBuffer(int id, size_t offset, size_t size,
+                         const void* host_ptr) override;
+  void* MapBuffer(int index, size_t offset, size_t size,
+                  MapMode mode) override;
+  void UnmapBuffer(int index, void* ptr) override;
+
+  void WriteToDevice() override;
+  void ReadFromDevice() override;
+  void Exec() override;
+  void Finish() override;
+  std::unique_ptr<DeviceRun> TakeRun() override;
+
+  std::vector<ArgInfo> GetArgsInfo() const override;
+  int64_t LoadTimeNanoSeconds() const override;
+  int64_t ComputeTimeNanoSeconds() const override;
+  int64_t StoreTimeNanoSeconds() const override;
+  size_t LoadBytes() const override;
+  size_t StoreBytes() const override;
+  std::vector<StartupPhase> GetStartupPhases() const override;
+  std::vector<BufferInfo> GetBuffersInfo() const override;
+  std::vector<MemoryBank> GetMemoryTopology() const override;
+  std::string GetPcieBdf() const override;
+  DeviceMemoryStats GetDeviceMemoryStats() const override;
+
+ private:
+  using DeviceMemory = std::shared_ptr<std::vector<char>>;
+
+  // Checks that argument `index` exists and is of category `cat`.
+  void CheckArg(int index, ArgInfo::Cat cat) const;
+
+  // Copies the active ranges of buffers between host and device, taking at
+  // least as long as the simulated bandwidth allows. Returns the elapsed time.
+  std::chrono::nanoseconds Transfer(
+      const std::vector<std::pair<BufferArg, DeviceMemory>>& buffers,
+      bool to_device) const;
+
+  // Sleeps until transferring `size` bytes since `tic` would have finished
+  // at the simulated bandwidth.
+  void WaitForTransfer(std::chrono::steady_clock::time_point tic,
+                       size_t size) const;
+
+  // Runs `command` on the worker thread after previous commands.
+  void Enqueue(std::function<void()> command);
+
+  StartupPhaseRecorder startup_phases_;
+  std::string kernel_name_;
+  SoftwareKernel kernel_;
+  std::vector<ArgInfo> args_;
+  // Simulated transfer bandwidth in GB/s; 0 means unlimited.
+  double bandwidth_gbps_ = 0;
+  std::chrono::nanoseconds compute_latency_{0};
+
+  std::unordered_map<int, std::string> scalars_;
+  std::unordered_map<int, BufferArg> buffer_table_;
+  // Device copies of host buffers, by argument index.
+  std::unordered_map<int, DeviceMemory> device_copies_;
+  // Buffers without a host mirror, by id.
+  std::vector<DeviceMemory> device_buffers_;
+  std::unordered_map<int, std::shared_ptr<SoftwareStream>> streams_;
+  std::unordered_set<int> load_indices_;
+  std::unordered_set<int> store_indices_;
+
+  std::atomic<int64_t> load_time_{0};
+  std::atomic<int64_t> compute_time_{0};
+  std::atomic<int64_t> store_time_{0};
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> commands_;
+  bool is_busy_ = false;
+  bool is_stopping_ = false;
+  std::thread worker_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_SOFTWARE_DEVICE_H_
@@ -0,0 +1,107 @@
+#include "frt/devices/staging_ring.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <glog/logging.h>
+#include <CL/cl2.hpp>
+
+#include "frt/devices/opencl_util.h"
+
+namespace fpga {
+namespace internal {
+
+StagingRing::StagingRing(const cl::Context& context,
+                         const cl::CommandQueue& cmd, size_t chunk_size,
+                         int slot_count, int thread_count,
+                         const std::vector<int>& cpus)
+    : cmd_(cmd),
+      chunk_size_(chunk_size),
+      slots_(std::max(slot_count, 1)),
+      copier_(thread_count, cpus) {
+  VLOG(1) << "Allocating a staging ring of " << slots_.size() << " x "
+          << chunk_size << " bytes";
+  cl_int err;
+  for (Slot& slot : slots_) {
+    slot.buffer = cl::Buffer(context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR,
+                             chunk_size, /* host_ptr = */ nullptr, &err);
+    CL_CHECK(err);
+    slot.ptr = static_cast<char*>(cmd_.enqueueMapBuffer(
+        slot.buffer, /* blocking = */ CL_TRUE, CL_MAP_READ | CL_MAP_WRITE,
+        /* offset = */ 0, chunk_size, /* events = */ nullptr,
+        /* event = */ nullptr, &err));
+    CL_CHECK(err);
+  }
+}
+
+StagingRing::~StagingRing() {
+  for (Slot& slot : slots_) {
+    Wait(slot);
+    CL_CHECK(cmd_.enqueueUnmapMemObject(slot.buffer, slot.ptr));
+  }
+  CL_CHECK(cmd_.finish());
+}
+
+std::vector<cl::Event> StagingRing::Write(const cl::Buffer& buffer,
+                                          size_t offset, const void* src,
+                                          size_t size) {
+  std::vector<cl::Event> events;
+  for (size_t done = 0, i = 0; done < size; done += chunk_size_, ++i) {
+    Slot& slot = slots_[i % slots_.size()];
+    const size_t chunk_size = std::min(chunk_size_, size - done);
+    Wait(slot);
+    copier_.Copy(slot.ptr, static_cast<const char*>(src) + done, chunk_size);
+    CL_CHECK(cmd_.enqueueWriteBuffer(buffer, /* blocking = */ CL_FALSE,
+                                     offset + done, chunk_size, slot.ptr,
+                                     /* events = */ nullptr, &slot.event));
+    // Starts the transfer while the next chunk is being copied.
+    CL_CHECK(cmd_.flush());
+    events.push_back(slot.event);
+  }
+  if (!events.empty()) {
+    CL_CHECK(cl::WaitForEvents(events));
+  }
+  return events;
+}
+
+std::vector<cl::Event> StagingRing::Read(const cl::Buffer& buffer,
+                                         size_t offset, void* dst,
+                                         size_t size) {
+  const size_t chunk_count = (size + chunk_size_ - 1) / chunk_size_;
+  std::vector<cl::Event> events;
+  events.reserve(chunk_count);
+  const auto enqueue = [&](size_t i) {
+    Slot& slot = slots_[i % slots_.size()];
+    CL_CHECK(cmd_.enqueueReadBuffer(
+        buffer, /* blocking = */ CL_FALSE, offset + i * chunk_size_,
+        std::min(chunk_size_, size - i * chunk_size_), slot.ptr,
+        /* events = */ nullptr, &slot.event));
+    events.push_back(slot.event);
+  };
+  // Keeps every slot busy, copying out each chunk once it arrives.
+  for (size_t i = 0; i < std::min(chunk_count, slots_.size()); ++i) {
+    enqueue(i);
+  }
+  CL_CHECK(cmd_.flush());
+  for (size_t i = 0; i < chunk_count; ++i) {
+    Slot& slot = slots_[i % slots_.size()];
+    Wait(slot);
+    copier_.Copy(static_cast<char*>(dst) + i * chunk_size_, slot.ptr,
+                 std::min(chunk_size_, size - i * chunk_size_));
+    if (i + slots_.size() < chunk_count) {
+      enqueue(i + slots_.size());
+      CL_CHECK(cmd_.flush());
+    }
+  }
+  return events;
+}
+
+void StagingRing::Wait(Slot& slot) {
+  if (slot.event() != nullptr) {
+    CL_CHECK(slot.event.wait());
+    slot.event = cl::Event();
+  }
+}
+
+}  // namespace internal
+}  // namespace fpga
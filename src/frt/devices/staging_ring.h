@@ -0,0 +1,65 @@
+#ifndef FPGA_RUNTIME_STAGING_RING_H_
+#define FPGA_RUNTIME_STAGING_RING_H_
+
+#include <cstddef>
+
+#include <vector>
+
+#include <CL/cl2.hpp>
+
+#include "frt/devices/parallel_copy.h"
+
+namespace fpga {
+namespace internal {
+
+// A ring of pinned, page-aligned host buffers that transfers between device
+// buffers and host memory the runtime cannot DMA from directly, e.g., memory
+// of a `std::vector` that is not aligned. Transfers are split into chunks of
+// the size of a slot; each chunk is copied into or out of a slot by several
+// threads while the slots around it are being transferred by DMA.
+class StagingRing {
+ public:
+  // Allocates `slot_count` slots of `chunk_size` bytes in `context`, and
+  // copies with `thread_count` threads restricted to `cpus` unless empty.
+  StagingRing(const cl::Context& context, const cl::CommandQueue& cmd,
+              size_t chunk_size, int slot_count, int thread_count,
+              const std::vector<int>& cpus);
+  StagingRing(const StagingRing&) = delete;
+  StagingRing& operator=(const StagingRing&) = delete;
+  StagingRing(StagingRing&&) = delete;
+  StagingRing& operator=(StagingRing&&) = delete;
+  ~StagingRing();
+
+  // Writes `size` bytes at `src` to `buffer` at `offset`, blocking until done.
+  // Returns the events of the DMA transfers.
+  std::vector<cl::Event> Write(const cl::Buffer& buffer, size_t offset,
+                               const void* src, size_t size);
+
+  // Reads `size` bytes of `buffer` at `offset` to `dst`, blocking until done.
+  // Returns the events of the DMA transfers.
+  std::vector<cl::Event> Read(const cl::Buffer& buffer, size_t offset,
+                              void* dst, size_t size);
+
+ private:
+  struct Slot {
+    // Allocated with `CL_MEM_ALLOC_HOST_PTR`, which runtimes back by pinned
+    // memory, and mapped into `ptr` for the lifetime of the ring.
+    cl::Buffer buffer;
+    char* ptr;
+    // The last transfer using the slot, if any.
+    cl::Event event;
+  };
+
+  // Waits until the last transfer using `slot` finishes.
+  static void Wait(Slot& slot);
+
+  cl::CommandQueue cmd_;
+  const size_t chunk_size_;
+  std::vector<Slot> slots_;
+  ParallelCopier copier_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_STAGING_RING_H_
@@ -0,0 +1,41 @@
+#ifndef FPGA_RUNTIME_STARTUP_PHASE_RECORDER_H_
+#define FPGA_RUNTIME_STARTUP_PHASE_RECORDER_H_
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "frt/startup_phase.h"
+
+namespace fpga {
+namespace internal {
+
+// Records consecutive startup phases. The first phase starts when the
+// recorder is constructed and each phase starts when the previous one ends.
+class StartupPhaseRecorder {
+ public:
+  // Ends the current phase as `name` and starts the next one.
+  void Record(std::string name) {
+    const auto now = std::chrono::steady_clock::now();
+    Add(std::move(name), now - tic_);
+    tic_ = now;
+  }
+
+  // Adds a phase measured elsewhere, e.g., one that runs after startup.
+  void Add(std::string name, std::chrono::nanoseconds duration) {
+    phases_.push_back({std::move(name), duration.count()});
+  }
+
+  const std::vector<StartupPhase>& Get() const { return phases_; }
+
+ private:
+  std::chrono::steady_clock::time_point tic_ =
+      std::chrono::steady_clock::now();
+  std::vector<StartupPhase> phases_;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_STARTUP_PHASE_RECORDER_H_
@@ -0,0 +1,155 @@
+#include "frt/devices/sysfs.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+DEFINE_string(sysfs_root, "/sys",
+              "where sysfs is mounted; used to discover PCIe devices and "
+              "NUMA nodes");
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+// Returns the first line of `path`, or an empty string if it cannot be read.
+std::string ReadLine(const fs::path& path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// Reads a device directory such as "/sys/bus/pci/devices/0000:3b:00.1".
+std::optional<PciDevice> ReadPciDevice(const fs::path& dir) {
+  PciDevice device;
+  device.bdf = NormalizeBdf(dir.filename().string());
+  const std::string vendor_id = ReadLine(dir / "vendor");
+  if (device.bdf.empty() || vendor_id.empty()) {
+    return std::nullopt;
+  }
+  device.vendor_id = strtoul(vendor_id.c_str(), nullptr, 16);
+  device.device_id = strtoul(ReadLine(dir / "device").c_str(), nullptr, 16);
+  if (const std::string numa_node = ReadLine(dir / "numa_node");
+      !numa_node.empty()) {
+    device.numa_node = atoi(numa_node.c_str());
+  }
+  std::error_code ec;
+  if (fs::path driver = fs::read_symlink(dir / "driver", ec); !ec) {
+    device.driver = driver.filename().string();
+  }
+  return device;
+}
+
+fs::path GetPciDevicesDir(const std::string& sysfs_root) {
+  return fs::path(sysfs_root) / "bus" / "pci" / "devices";
+}
+
+}  // namespace
+
+std::string GetSysfsRoot() { return FLAGS_sysfs_root; }
+
+std::string NormalizeBdf(std::string_view bdf) {
+  const std::string text(bdf);
+  unsigned domain = 0, bus, device, function;
+  int length = 0;
+  if (sscanf(text.c_str(), "%x:%x:%x.%x%n", &domain, &bus, &device, &function,
+             &length) != 4 ||
+      length != static_cast<int>(text.size())) {
+    domain = 0;
+    if (sscanf(text.c_str(), "%x:%x.%x%n", &bus, &device, &function,
+               &length) != 3 ||
+        length != static_cast<int>(text.size())) {
+      return "";
+    }
+  }
+  if (domain > 0xffff || bus > 0xff || device > 0x1f || function > 0x7) {
+    return "";
+  }
+  char normalized[16];
+  snprintf(normalized, sizeof(normalized), "%04x:%02x:%02x.%x", domain, bus,
+           device, function);
+  return normalized;
+}
+
+std::vector<PciDevice> ScanPciDevices(const std::string& sysfs_root) {
+  std::vector<PciDevice> devices;
+  std::error_code ec;
+  for (fs::directory_iterator it(GetPciDevicesDir(sysfs_root), ec), end;
+       !ec && it != end; it.increment(ec)) {
+    if (auto device = ReadPciDevice(it->path())) {
+      devices.push_back(std::move(*device));
+    }
+  }
+  std::sort(devices.begin(), devices.end(),
+            [](const PciDevice& lhs, const PciDevice& rhs) {
+              return lhs.bdf < rhs.bdf;
+            });
+  return devices;
+}
+
+std::optional<PciDevice> FindPciDevice(std::string_view bdf,
+                                       const std::string& sysfs_root) {
+  const std::string normalized = NormalizeBdf(bdf);
+  if (normalized.empty()) {
+    return std::nullopt;
+  }
+  return ReadPciDevice(GetPciDevicesDir(sysfs_root) / normalized);
+}
+
+std::vector<int> ParseCpuList(std::string_view cpu_list) {
+  std::vector<int> cpus;
+  const std::string text(cpu_list);
+  for (size_t pos = 0; pos < text.size();) {
+    size_t end = text.find(',', pos);
+    if (end == std::string::npos) end = text.size();
+    const std::string range = text.substr(pos, end - pos);
+    int first, last, length = 0;
+    if (sscanf(range.c_str(), "%d-%d%n", &first, &last, &length) != 2 ||
+        length != static_cast<int>(range.size())) {
+      if (sscanf(range.c_str(), "%d%n", &first, &length) != 1 ||
+          length != static_cast<int>(range.size())) {
+        return {};
+      }
+      last = first;
+    }
+    if (first < 0 || last < first) return {};
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    pos = end + 1;
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::vector<int> GetNumaNodeCpus(int node, const std::string& sysfs_root) {
+  if (node < 0) return {};
+  return ParseCpuList(ReadLine(fs::path(sysfs_root) / "devices" / "system" /
+                               "node" / ("node" + std::to_string(node)) /
+                               "cpulist"));
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,57 @@
+#ifndef FPGA_RUNTIME_SYSFS_H_
+#define FPGA_RUNTIME_SYSFS_H_
+
+#include <cstdint>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fpga {
+namespace internal {
+
+constexpr uint16_t kXilinxPciVendorId = 0x10ee;
+constexpr uint16_t kIntelFpgaPciVendorId = 0x1172;
+
+// A PCIe function found in sysfs.
+struct PciDevice {
+  // Normalized Bus:Device:Function with domain, e.g., "0000:3b:00.1".
+  std::string bdf;
+  uint16_t vendor_id = 0;
+  uint16_t device_id = 0;
+  // -1 if the platform does not report NUMA affinity.
+  int numa_node = -1;
+  // Name of the bound driver, e.g., "xclmgmt". Empty if none is bound.
+  std::string driver;
+};
+
+// Returns the sysfs mount point, which can be overridden with `--sysfs_root`
+// for testing.
+std::string GetSysfsRoot();
+
+// Returns `bdf` as "dddd:bb:dd.f" in lowercase, adding domain 0 if missing.
+// Returns an empty string if `bdf` is malformed.
+std::string NormalizeBdf(std::string_view bdf);
+
+// Returns all PCIe functions under `sysfs_root`, sorted by BDF. Empty if sysfs
+// is not available, e.g., in some containers.
+std::vector<PciDevice> ScanPciDevices(
+    const std::string& sysfs_root = GetSysfsRoot());
+
+// Returns the PCIe function at `bdf` without scanning the whole bus.
+std::optional<PciDevice> FindPciDevice(
+    std::string_view bdf, const std::string& sysfs_root = GetSysfsRoot());
+
+// Returns the CPUs in a list such as "0-3,8,10-11", sorted. Returns an empty
+// vector if `cpu_list` is malformed.
+std::vector<int> ParseCpuList(std::string_view cpu_list);
+
+// Returns the CPUs of NUMA node `node`, sorted. Empty if the node is unknown.
+std::vector<int> GetNumaNodeCpus(
+    int node, const std::string& sysfs_root = GetSysfsRoot());
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_SYSFS_H_
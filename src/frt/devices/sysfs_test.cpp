@@ -0,0 +1,129 @@
+#include "frt/devices/sysfs.h"
+
+#include <cstdlib>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+namespace fpga::internal {
+namespace {
+
+class SysfsTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char root[] = "/tmp/frt-sysfs-test.XXXXXX";
+    ASSERT_NE(mkdtemp(root), nullptr);
+    root_ = root;
+  }
+
+  void TearDown() override { fs::remove_all(root_); }
+
+  // Creates a fake PCIe function like those under /sys/bus/pci/devices.
+  void AddDevice(const std::string& bdf, const std::string& vendor_id,
+                 const std::string& device_id, const std::string& numa_node,
+                 const std::string& driver) {
+    const fs::path dir = fs::path(root_) / "bus" / "pci" / "devices" / bdf;
+    fs::create_directories(dir);
+    std::ofstream(dir / "vendor") << vendor_id << "\n";
+    std::ofstream(dir / "device") << device_id << "\n";
+    std::ofstream(dir / "numa_node") << numa_node << "\n";
+    if (!driver.empty()) {
+      const fs::path driver_dir = fs::path(root_) / "bus" / "pci" / "drivers" /
+                                  driver;
+      fs::create_directories(driver_dir);
+      fs::create_directory_symlink(driver_dir, dir / "driver");
+    }
+  }
+
+  std::string root_;
+};
+
+TEST(NormalizeBdfTest, AddsDomainAndLowercases) {
+  EXPECT_EQ(NormalizeBdf("3B:00.1"), "0000:3b:00.1");
+  EXPECT_EQ(NormalizeBdf("0001:d8:1f.7"), "0001:d8:1f.7");
+}
+
+TEST(NormalizeBdfTest, RejectsMalformedBdf) {
+  EXPECT_EQ(NormalizeBdf(""), "");
+  EXPECT_EQ(NormalizeBdf("3b:00"), "");
+  EXPECT_EQ(NormalizeBdf("3b:00.1 "), "");
+  EXPECT_EQ(NormalizeBdf("3b:20.0"), "");
+  EXPECT_EQ(NormalizeBdf("3b:00.8"), "");
+}
+
+TEST(ParseCpuListTest, ExpandsRanges) {
+  EXPECT_EQ(ParseCpuList("0-3,8,10-11"),
+            std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+  EXPECT_EQ(ParseCpuList("5"), std::vector<int>({5}));
+  EXPECT_EQ(ParseCpuList(""), std::vector<int>());
+}
+
+TEST(ParseCpuListTest, RejectsMalformedList) {
+  EXPECT_EQ(ParseCpuList("0-"), std::vector<int>());
+  EXPECT_EQ(ParseCpuList("3-1"), std::vector<int>());
+  EXPECT_EQ(ParseCpuList("0,,1"), std::vector<int>());
+}
+
+TEST_F(SysfsTest, ScanPciDevicesReturnsSortedDevices) {
+  AddDevice("0000:d8:00.1", "0x10ee", "0x5005", "1", "xocl");
+  AddDevice("0000:3b:00.0", "0x8086", "0x2030", "0", "");
+
+  const auto devices = ScanPciDevices(root_);
+
+  ASSERT_EQ(devices.size(), 2);
+  EXPECT_EQ(devices[0].bdf, "0000:3b:00.0");
+  EXPECT_EQ(devices[0].vendor_id, 0x8086);
+  EXPECT_EQ(devices[0].driver, "");
+  EXPECT_EQ(devices[1].bdf, "0000:d8:00.1");
+  EXPECT_EQ(devices[1].vendor_id, kXilinxPciVendorId);
+  EXPECT_EQ(devices[1].device_id, 0x5005);
+  EXPECT_EQ(devices[1].numa_node, 1);
+  EXPECT_EQ(devices[1].driver, "xocl");
+}
+
+TEST_F(SysfsTest, ScanPciDevicesReturnsEmptyWithoutSysfs) {
+  EXPECT_TRUE(ScanPciDevices(root_ + "/nonexistent").empty());
+}
+
+TEST_F(SysfsTest, FindPciDeviceAcceptsShortBdf) {
+  AddDevice("0000:d8:00.1", "0x10ee", "0x5005", "-1", "xocl");
+
+  const auto device = FindPciDevice("D8:00.1", root_);
+
+  ASSERT_TRUE(device.has_value());
+  EXPECT_EQ(device->bdf, "0000:d8:00.1");
+  EXPECT_EQ(device->numa_node, -1);
+}
+
+TEST_F(SysfsTest, FindPciDeviceReturnsNulloptIfMissing) {
+  AddDevice("0000:d8:00.1", "0x10ee", "0x5005", "1", "xocl");
+
+  EXPECT_FALSE(FindPciDevice("0000:d8:00.0", root_).has_value());
+  EXPECT_FALSE(FindPciDevice("not a bdf", root_).has_value());
+}
+
+TEST_F(SysfsTest, GetNumaNodeCpusReadsCpuList) {
+  const fs::path dir = fs::path(root_) / "devices" / "system" / "node";
+  fs::create_directories(dir / "node1");
+  std::ofstream(dir / "node1" / "cpulist") << "16-19,48\n";
+
+  EXPECT_EQ(GetNumaNodeCpus(1, root_), std::vector<int>({16, 17, 18, 19, 48}));
+  EXPECT_TRUE(GetNumaNodeCpus(0, root_).empty());
+  EXPECT_TRUE(GetNumaNodeCpus(-1, root_).empty());
+}
+
+}  // namespace
+}  // namespace fpga::internal
@@ -1,12 +1,16 @@
 #include "frt/devices/tapa_fast_cosim_device.h"
 
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <ios>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -14,6 +18,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <tinyxml.h>
 #include <unistd.h>
 
@@ -24,6 +30,9 @@
 #include <zip_file.hpp>
 
 #include "frt/arg_info.h"
+#include "frt/devices/file_cache.h"
+#include "frt/devices/finished_run.h"
+#include "frt/devices/metadata_cache.h"
 #include "frt/devices/xilinx_environ.h"
 
 #ifdef __cpp_lib_filesystem
@@ -68,15 +77,46 @@ std::string GetOutputDataPath(const std::string& work_dir, int index) {
   return work_dir + "/" + std::to_string(index) + "_out.bin";
 }
 
+// Returns the data file holding the simulated device memory, i.e., the output
+// data file after `Exec` and the input data file before, which is also what
+// the next `Exec` starts from.
+std::string GetDeviceDataPath(const std::string& work_dir, int index) {
+  std::string path = GetOutputDataPath(work_dir, index);
+  return fs::exists(path) ? path : GetInputDataPath(work_dir, index);
+}
+
 std::string GetConfigPath(const std::string& work_dir) {
   return work_dir + "/config.json";
 }
 
-}  // namespace
+// Returns an identifier of the zip content without decompressing anything,
+// i.e., the fingerprint of the central directory, which records the CRC-32 of
+// every file.
+std::string GetXoId(std::string_view content) {
+  constexpr std::string_view kEndOfCentralDirMagic("PK\5\6", 4);
+  constexpr size_t kEndOfCentralDirSize = 22;
+  // The end of central directory record is followed by a comment of at most
+  // 64 KiB.
+  const size_t search_begin =
+      content.size() > kEndOfCentralDirSize + 0xffff
+          ? content.size() - kEndOfCentralDirSize - 0xffff
+          : 0;
+  if (auto pos = content.rfind(kEndOfCentralDirMagic);
+      pos != std::string_view::npos && pos >= search_begin &&
+      pos + kEndOfCentralDirSize <= content.size()) {
+    uint32_t central_dir_size, central_dir_offset;
+    memcpy(&central_dir_size, content.data() + pos + 12, 4);
+    memcpy(&central_dir_offset, content.data() + pos + 16, 4);
+    if (uint64_t(central_dir_offset) + central_dir_size <= content.size()) {
+      return FingerprintToString(Fingerprint(
+          content.substr(central_dir_offset, central_dir_size)));
+    }
+  }
+  return FingerprintToString(Fingerprint(content));
+}
 
-TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
-    : xo_path(fs::absolute(xo_path)), work_dir(GetWorkDirectory()) {
-  miniz_cpp::zip_file xo_file = this->xo_path;
+KernelMetadata ParseMetadata(const std::string& xo_path) {
+  miniz_cpp::zip_file xo_file = xo_path;
   std::string kernel_xml;
   for (auto& info : xo_file.infolist()) {
     constexpr std::string_view kSuffix = "/kernel.xml";
@@ -89,6 +129,7 @@ TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
   LOG_IF(FATAL, kernel_xml.empty())
       << "Missing 'kernel.xml' in '" << xo_path << "'";
 
+  KernelMetadata metadata;
   TiXmlDocument doc;
   doc.Parse(kernel_xml.data(), nullptr, TIXML_ENCODING_UTF8);
   for (const TiXmlElement* xml_arg = doc.FirstChildElement("root")
@@ -98,9 +139,9 @@ TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
        xml_arg != nullptr; xml_arg = xml_arg->NextSiblingElement("arg")) {
     ArgInfo arg;
     arg.index = atoi(xml_arg->Attribute("id"));
-    LOG_IF(FATAL, arg.index != args_.size())
-        << "Expecting argument #" << args_.size() << ", got argument #"
-        << arg.index << " in the metadata";
+    LOG_IF(FATAL, arg.index != metadata.args.size())
+        << "Expecting argument #" << metadata.args.size()
+        << ", got argument #" << arg.index << " in the metadata";
     arg.name = xml_arg->Attribute("name");
     arg.type = xml_arg->Attribute("type");
     switch (int cat = atoi(xml_arg->Attribute("addressQualifier")); cat) {
@@ -116,26 +157,40 @@ TapaFastCosimDevice::TapaFastCosimDevice(std::string_view xo_path)
       default:
         LOG(WARNING) << "Unknown argument category: " << cat;
     }
-    args_.push_back(arg);
+    metadata.args.push_back(arg);
   }
+  return metadata;
+}
+
+}  // namespace
+
+TapaFastCosimDevice::TapaFastCosimDevice(const Bitstream& bitstream)
+    : xo_path(fs::absolute(bitstream.Path())), work_dir(GetWorkDirectory()) {
+  args_ = GetKernelMetadata("tapa", GetXoId(bitstream.Content()), [this] {
+            return ParseMetadata(xo_path);
+          }).args;
+  startup_phases_.Record("metadata");
 
   LOG(INFO) << "Running hardware simulation with TAPA fast cosim";
 }
 
 TapaFastCosimDevice::~TapaFastCosimDevice() {
+  for (const auto& [ptr, mapping] : mappings_) {
+    munmap(mapping.first, mapping.second);
+  }
   if (FLAGS_xosim_work_dir.empty()) {
     fs::remove_all(work_dir);
   }
 }
 
-std::unique_ptr<Device> TapaFastCosimDevice::New(std::string_view path,
-                                                 std::string_view content) {
+std::unique_ptr<Device> TapaFastCosimDevice::New(const Bitstream& bitstream) {
   constexpr std::string_view kZipMagic("PK\3\4", 4);
-  if (content.size() < kZipMagic.size() ||
-      memcmp(content.data(), kZipMagic.data(), kZipMagic.size()) != 0) {
+  if (std::string_view header = bitstream.Header();
+      header.size() < kZipMagic.size() ||
+      memcmp(header.data(), kZipMagic.data(), kZipMagic.size()) != 0) {
     return nullptr;
   }
-  return std::make_unique<TapaFastCosimDevice>(path);
+  return std::make_unique<TapaFastCosimDevice>(bitstream);
 }
 
 void TapaFastCosimDevice::SetScalarArg(int index, const void* arg, int size) {
@@ -164,7 +219,8 @@ void TapaFastCosimDevice::SetBufferArg(int index, Tag tag,
   LOG_IF(FATAL, args_[index].cat != ArgInfo::kMmap)
       << "Cannot set argument '" << args_[index].name
       << "' as an mmap; it is a " << args_[index].cat;
-  buffer_table_.insert({index, arg});
+  buffer_table_.insert_or_assign(index, arg);
+  written_indices_.erase(index);
   if (tag == Tag::kReadOnly || tag == Tag::kReadWrite) {
     store_indices_.insert(index);
   }
@@ -181,10 +237,95 @@ size_t TapaFastCosimDevice::SuspendBuffer(int index) {
   return load_indices_.erase(index) + store_indices_.erase(index);
 }
 
+int TapaFastCosimDevice::CreateDeviceBuffer(size_t size) {
+  LOG(FATAL) << "TAPA fast cosim device does not support device buffers";
+  return -1;
+}
+
+void TapaFastCosimDevice::SetDeviceBufferArg(int index, int id) {
+  LOG(FATAL) << "TAPA fast cosim device does not support device buffers";
+}
+
+void TapaFastCosimDevice::ReadDeviceBuffer(int id, size_t offset, size_t size,
+                                           void* host_ptr) {
+  LOG(FATAL) << "TAPA fast cosim device does not support device buffers";
+}
+
+void TapaFastCosimDevice::WriteDeviceBuffer(int id, size_t offset, size_t size,
+                                            const void* host_ptr) {
+  LOG(FATAL) << "TAPA fast cosim device does not support device buffers";
+}
+
+void* TapaFastCosimDevice::MapBuffer(int index, size_t offset, size_t size,
+                                     MapMode mode) {
+  auto it = buffer_table_.find(index);
+  LOG_IF(FATAL, it == buffer_table_.end())
+      << "Buffer argument #" << index << " is not set";
+  const size_t buffer_size = it->second.SizeInBytes();
+  LOG_IF(FATAL, offset + size > buffer_size)
+      << "Cannot map bytes [" << offset << ", " << offset + size
+      << ") of buffer argument #" << index << "; the buffer has only "
+      << buffer_size << " bytes";
+
+  std::string path = GetDeviceDataPath(work_dir, index);
+  if (mode == MapMode::kRead) {
+    LOG_IF(FATAL, !fs::exists(path))
+        << "Cannot map buffer argument #" << index
+        << " for reading before it is written to the device";
+  } else {
+    // Writes go to the input data file, so the output data file of the last
+    // `Exec` is stale from now on.
+    const std::string input_path = GetInputDataPath(work_dir, index);
+    const std::string output_path = GetOutputDataPath(work_dir, index);
+    if (path == output_path) {
+      if (mode == MapMode::kReadWrite) {
+        fs::copy_file(output_path, input_path,
+                      fs::copy_options::overwrite_existing);
+      }
+      fs::remove(output_path);
+      path = input_path;
+    }
+    written_indices_.insert(index);
+  }
+
+  const bool is_writable = mode != MapMode::kRead;
+  const int fd = open(path.c_str(), is_writable ? O_RDWR | O_CREAT : O_RDONLY,
+                      0644);
+  LOG_IF(FATAL, fd < 0) << "Cannot open '" << path << "': " << strerror(errno);
+  LOG_IF(FATAL, is_writable && ftruncate(fd, buffer_size) != 0)
+      << "Cannot resize '" << path << "': " << strerror(errno);
+  // `mmap` requires a page-aligned offset.
+  const size_t page_offset = offset % sysconf(_SC_PAGESIZE);
+  const size_t length = std::max<size_t>(page_offset + size, 1);
+  void* base = mmap(nullptr, length,
+                    is_writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_SHARED, fd, offset - page_offset);
+  LOG_IF(FATAL, base == MAP_FAILED)
+      << "Cannot map '" << path << "': " << strerror(errno);
+  close(fd);
+
+  void* ptr = static_cast<char*>(base) + page_offset;
+  mappings_[ptr] = {base, length};
+  return ptr;
+}
+
+void TapaFastCosimDevice::UnmapBuffer(int index, void* ptr) {
+  auto it = mappings_.find(ptr);
+  LOG_IF(FATAL, it == mappings_.end())
+      << "Cannot unmap " << ptr
+      << ", which is not mapped from buffer argument #" << index;
+  // Mappings are shared, so changes are already in the data file.
+  LOG_IF(FATAL, munmap(it->second.first, it->second.second) != 0)
+      << "Cannot unmap buffer argument #" << index << ": " << strerror(errno);
+  mappings_.erase(it);
+}
+
 void TapaFastCosimDevice::WriteToDevice() {
-  // All buffers must have a data file.
+  // All buffers must have a data file, covering the whole buffer since the
+  // simulated device memory is initialized from it.
   auto tic = clock::now();
   for (const auto& [index, buffer_arg] : buffer_table_) {
+    if (written_indices_.count(index) != 0) continue;
     std::ofstream(GetInputDataPath(work_dir, index),
                   std::ios::out | std::ios::binary)
         .write(buffer_arg.Get(), buffer_arg.SizeInBytes());
@@ -196,9 +337,11 @@ void TapaFastCosimDevice::ReadFromDevice() {
   auto tic = clock::now();
   for (int index : store_indices_) {
     auto buffer_arg = buffer_table_.at(index);
-    std::ifstream(GetOutputDataPath(work_dir, index),
-                  std::ios::in | std::ios::binary)
-        .read(buffer_arg.Get(), buffer_arg.SizeInBytes());
+    std::ifstream file(GetDeviceDataPath(work_dir, index),
+                       std::ios::in | std::ios::binary);
+    file.seekg(buffer_arg.ActiveOffsetInBytes());
+    file.read(buffer_arg.Get() + buffer_arg.ActiveOffsetInBytes(),
+              buffer_arg.ActiveSizeInBytes());
   }
   store_time_ = clock::now() - tic;
 }
@@ -246,6 +389,11 @@ void TapaFastCosimDevice::Finish() {
   // Not implemented.
 }
 
+std::unique_ptr<DeviceRun> TapaFastCosimDevice::TakeRun() {
+  // Simulation is synchronous, so runs are finished when taken.
+  return std::make_unique<FinishedRun>(*this);
+}
+
 std::vector<ArgInfo> TapaFastCosimDevice::GetArgsInfo() const { return args_; }
 
 int64_t TapaFastCosimDevice::LoadTimeNanoSeconds() const {
@@ -272,10 +420,41 @@ size_t TapaFastCosimDevice::StoreBytes() const {
   size_t total_size = 0;
   for (int index : store_indices_) {
     auto buffer_arg = buffer_table_.at(index);
-    total_size += buffer_arg.SizeInBytes();
+    total_size += buffer_arg.ActiveSizeInBytes();
   }
   return total_size;
 }
 
+std::vector<StartupPhase> TapaFastCosimDevice::GetStartupPhases() const {
+  return startup_phases_.Get();
+}
+
+std::vector<MemoryBank> TapaFastCosimDevice::GetMemoryTopology() const {
+  return {};
+}
+
+std::string TapaFastCosimDevice::GetPcieBdf() const { return ""; }
+
+DeviceMemoryStats TapaFastCosimDevice::GetDeviceMemoryStats() const {
+  return {};
+}
+
+std::vector<BufferInfo> TapaFastCosimDevice::GetBuffersInfo() const {
+  // Buffers are always copied through data files.
+  std::vector<BufferInfo> infos;
+  infos.reserve(buffer_table_.size());
+  for (const auto& [index, buffer_arg] : buffer_table_) {
+    BufferInfo& info = infos.emplace_back();
+    info.index = index;
+    info.size = buffer_arg.SizeInBytes();
+    info.load_bytes = info.size;
+  }
+  std::sort(infos.begin(), infos.end(),
+            [](const BufferInfo& lhs, const BufferInfo& rhs) {
+              return lhs.index < rhs.index;
+            });
+  return infos;
+}
+
 }  // namespace internal
 }  // namespace fpga
@@ -2,23 +2,33 @@
 #define FPGA_RUNTIME_TAPA_FAST_COSIM_
 
 #include <chrono>
+#include <memory>
 #include <ratio>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 
 #include <CL/cl2.hpp>
 #include <unordered_set>
 
+#include "frt/bitstream.h"
 #include "frt/buffer.h"
+#include "frt/buffer_info.h"
 #include "frt/device.h"
+#include "frt/device_memory_stats.h"
+#include "frt/device_run.h"
+#include "frt/devices/startup_phase_recorder.h"
+#include "frt/map_mode.h"
+#include "frt/memory_bank.h"
+#include "frt/startup_phase.h"
 
 namespace fpga {
 namespace internal {
 
 class TapaFastCosimDevice : public Device {
  public:
-  TapaFastCosimDevice(std::string_view bitstream);
+  TapaFastCosimDevice(const Bitstream& bitstream);
   TapaFastCosimDevice(const TapaFastCosimDevice&) = delete;
   TapaFastCosimDevice& operator=(const TapaFastCosimDevice&) = delete;
   TapaFastCosimDevice(TapaFastCosimDevice&&) = delete;
@@ -26,18 +36,27 @@ class TapaFastCosimDevice : public Device {
 
   ~TapaFastCosimDevice() override;
 
-  static std::unique_ptr<Device> New(std::string_view path,
-                                     std::string_view content);
+  static std::unique_ptr<Device> New(const Bitstream& bitstream);
 
   void SetScalarArg(int index, const void* arg, int size) override;
   void SetBufferArg(int index, Tag tag, const BufferArg& arg) override;
   void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override;
   size_t SuspendBuffer(int index) override;
+  int CreateDeviceBuffer(size_t size) override;
+  void SetDeviceBufferArg(int index, int id) override;
+  void ReadDeviceBuffer(int id, size_t offset, size_t size,
+                        void* host_ptr) override;
+  void WriteDeviceBuffer(int id, size_t offset, size_t size,
+                         const void* host_ptr) override;
+  void* MapBuffer(int index, size_t offset, size_t size,
+                  MapMode mode) override;
+  void UnmapBuffer(int index, void* ptr) override;
 
   void WriteToDevice() override;
   void ReadFromDevice() override;
   void Exec() override;
   void Finish() override;
+  std::unique_ptr<DeviceRun> TakeRun() override;
 
   std::vector<ArgInfo> GetArgsInfo() const override;
   int64_t LoadTimeNanoSeconds() const override;
@@ -45,6 +64,11 @@ class TapaFastCosimDevice : public Device {
   int64_t StoreTimeNanoSeconds() const override;
   size_t LoadBytes() const override;
   size_t StoreBytes() const override;
+  std::vector<StartupPhase> GetStartupPhases() const override;
+  std::vector<BufferInfo> GetBuffersInfo() const override;
+  std::vector<MemoryBank> GetMemoryTopology() const override;
+  std::string GetPcieBdf() const override;
+  DeviceMemoryStats GetDeviceMemoryStats() const override;
 
   const std::string xo_path;
   const std::string work_dir;
@@ -55,10 +79,16 @@ class TapaFastCosimDevice : public Device {
   std::vector<ArgInfo> args_;
   std::unordered_set<int> load_indices_;
   std::unordered_set<int> store_indices_;
+  // Indices of buffers whose input data file was mapped for writing, which
+  // `WriteToDevice` must not overwrite.
+  std::unordered_set<int> written_indices_;
+  // Mapped regions of data files, by the address returned by `MapBuffer`.
+  std::unordered_map<void*, std::pair<void*, size_t>> mappings_;
 
   std::chrono::nanoseconds load_time_;
   std::chrono::nanoseconds compute_time_;
   std::chrono::nanoseconds store_time_;
+  StartupPhaseRecorder startup_phases_;
 };
 
 }  // namespace internal
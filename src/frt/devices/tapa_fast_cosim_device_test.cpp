@@ -0,0 +1,90 @@
+#include "frt/devices/tapa_fast_cosim_device.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include <zip_file.hpp>
+
+#include "frt.h"
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+namespace fpga::internal {
+namespace {
+
+constexpr std::string_view kKernelXml = R"(<?xml version="1.0"?>
+<root>
+  <kernel name="Copy">
+    <args>
+      <arg id="0" name="mem" type="int*" addressQualifier="1"/>
+    </args>
+  </kernel>
+</root>
+)";
+
+class TapaFastCosimDeviceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char root[] = "/tmp/frt-tapa-fast-cosim-test.XXXXXX";
+    ASSERT_NE(mkdtemp(root), nullptr);
+    root_ = root;
+    setenv("FRT_CACHE_DIR", root_.c_str(), /*overwrite=*/1);
+
+    xo_path_ = root_ + "/Copy.xo";
+    miniz_cpp::zip_file xo;
+    xo.writestr("Copy/kernel.xml", std::string(kKernelXml));
+    xo.save(xo_path_);
+  }
+
+  void TearDown() override {
+    unsetenv("FRT_CACHE_DIR");
+    fs::remove_all(root_);
+  }
+
+  std::string root_;
+  std::string xo_path_;
+};
+
+TEST_F(TapaFastCosimDeviceTest, MapForReadingSeesDataMappedForWriting) {
+  constexpr size_t kN = 1024;
+  std::vector<int> host(kN, 1);
+  Bitstream bitstream(xo_path_);
+  TapaFastCosimDevice device(bitstream);
+  device.SetBufferArg(0, Tag::kReadWrite, fpga::ReadWrite(host.data(), kN));
+  device.WriteToDevice();
+
+  // Stands in for the output data file `Exec` leaves behind.
+  const std::vector<int> stale(kN, 2);
+  std::ofstream(device.work_dir + "/0_out.bin", std::ios::binary)
+      .write(reinterpret_cast<const char*>(stale.data()), kN * sizeof(int));
+
+  auto* written = static_cast<int*>(
+      device.MapBuffer(0, 0, kN * sizeof(int), MapMode::kWrite));
+  std::fill(written, written + kN, 3);
+  device.UnmapBuffer(0, written);
+
+  const auto* read = static_cast<const int*>(
+      device.MapBuffer(0, 0, kN * sizeof(int), MapMode::kRead));
+  EXPECT_EQ(std::vector<int>(read, read + kN), std::vector<int>(kN, 3));
+  device.UnmapBuffer(0, const_cast<int*>(read));
+
+  device.ReadFromDevice();
+  EXPECT_EQ(host, std::vector<int>(kN, 3));
+}
+
+}  // namespace
+}  // namespace fpga::internal
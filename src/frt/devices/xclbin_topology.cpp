@@ -0,0 +1,166 @@
+#include "frt/devices/xclbin_topology.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <glog/logging.h>
+#include <xclbin.h>
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+// Returns the content of section `kind` of `binary`, or an empty string if it
+// is missing or out of bounds.
+std::string_view GetSection(std::string_view binary, axlf_section_kind kind) {
+  if (binary.size() < offsetof(axlf, m_sections)) return {};
+  const auto axlf_top = reinterpret_cast<const axlf*>(binary.data());
+  const uint64_t num_sections = axlf_top->m_header.m_numSections;
+  if (num_sections > (binary.size() - offsetof(axlf, m_sections)) /
+                         sizeof(axlf_section_header)) {
+    return {};
+  }
+  const auto section = xclbin::get_axlf_section(axlf_top, kind);
+  if (section == nullptr || section->m_sectionOffset > binary.size() ||
+      section->m_sectionSize > binary.size() - section->m_sectionOffset) {
+    return {};
+  }
+  return binary.substr(section->m_sectionOffset, section->m_sectionSize);
+}
+
+// Returns `section` as a `Table` of `m_count` `Entry`s, or nullptr if it does
+// not fit.
+template <typename Table, typename Entry>
+const Table* GetTable(std::string_view section) {
+  constexpr size_t kHeaderSize = sizeof(Table) - sizeof(Entry);
+  if (section.size() < kHeaderSize) return nullptr;
+  const auto table = reinterpret_cast<const Table*>(section.data());
+  const int32_t count = table->m_count;
+  if (count < 0 || static_cast<size_t>(count) >
+                       (section.size() - kHeaderSize) / sizeof(Entry)) {
+    return nullptr;
+  }
+  return table;
+}
+
+std::string GetMemoryType(uint8_t type) {
+  switch (type) {
+    case MEM_DDR3:
+      return "DDR3";
+    case MEM_DDR4:
+      return "DDR4";
+    case MEM_DRAM:
+      return "DRAM";
+    case MEM_PREALLOCATED_GLOB:
+      return "PREALLOCATED_GLOB";
+    case MEM_ARE:
+      return "ARE";
+    case MEM_HBM:
+      return "HBM";
+    case MEM_BRAM:
+      return "BRAM";
+    case MEM_URAM:
+      return "URAM";
+    case MEM_HOST:
+      return "HOST";
+  }
+  return "UNKNOWN";
+}
+
+// Returns the NUL-terminated string in `chars` of at most `size` bytes.
+std::string ToString(const void* chars, size_t size) {
+  const auto data = static_cast<const char*>(chars);
+  return std::string(data, std::find(data, data + size, '\0'));
+}
+
+}  // namespace
+
+XclbinTopology ParseXclbinTopology(std::string_view binary,
+                                   const std::vector<std::string>& kernel_names,
+                                   const std::vector<int>& kernel_arg_counts) {
+  XclbinTopology topology;
+  const auto mem_topo = GetTable<mem_topology, mem_data>(
+      GetSection(binary, MEM_TOPOLOGY));
+  const auto ip_layout_table =
+      GetTable<ip_layout, ip_data>(GetSection(binary, IP_LAYOUT));
+  const auto connectivity_table =
+      GetTable<connectivity, connection>(GetSection(binary, CONNECTIVITY));
+  if (mem_topo == nullptr || ip_layout_table == nullptr ||
+      connectivity_table == nullptr) {
+    VLOG(1) << "xclbin has no valid memory topology";
+    return topology;
+  }
+
+  std::unordered_map<std::string, int> kernel_arg_offsets;
+  for (size_t i = 0; i < kernel_names.size(); ++i) {
+    kernel_arg_offsets[kernel_names[i]] = kernel_arg_counts[i];
+  }
+
+  std::unordered_map<int, MemoryBank> banks;
+  for (int i = 0; i < mem_topo->m_count; ++i) {
+    const mem_data& mem = mem_topo->m_mem_data[i];
+    if (!mem.m_used || mem.m_type == MEM_STREAMING ||
+        mem.m_type == MEM_STREAMING_CONNECTION) {
+      continue;
+    }
+    MemoryBank& bank = banks[i];
+    bank.index = i;
+    bank.tag = ToString(mem.m_tag, sizeof(mem.m_tag));
+    bank.type = GetMemoryType(mem.m_type);
+    bank.base_address = mem.m_base_address;
+    bank.size = mem.m_size * 1024;  // `m_size` is in KiB.
+  }
+
+  for (int i = 0; i < connectivity_table->m_count; ++i) {
+    const connection& conn = connectivity_table->m_connection[i];
+    auto bank = banks.find(conn.mem_data_index);
+    if (bank == banks.end() || conn.m_ip_layout_index < 0 ||
+        conn.m_ip_layout_index >= ip_layout_table->m_count) {
+      continue;
+    }
+    const ip_data& ip = ip_layout_table->m_ip_data[conn.m_ip_layout_index];
+    if (ip.m_type != IP_KERNEL) continue;
+
+    // Compute units are named "kernel:instance".
+    std::string kernel_name = ToString(ip.m_name, sizeof(ip.m_name));
+    kernel_name = kernel_name.substr(0, kernel_name.find(':'));
+    auto offset = kernel_arg_offsets.find(kernel_name);
+    if (offset == kernel_arg_offsets.end()) {
+      LOG(WARNING) << "Memory connection of unknown kernel '" << kernel_name
+                   << "'";
+      continue;
+    }
+    const int arg_index = offset->second + conn.arg_index;
+    topology.arg_banks[arg_index].push_back(conn.mem_data_index);
+    bank->second.arg_indices.push_back(arg_index);
+  }
+
+  for (auto& [index, bank_indices] : topology.arg_banks) {
+    std::sort(bank_indices.begin(), bank_indices.end());
+    bank_indices.erase(std::unique(bank_indices.begin(), bank_indices.end()),
+                       bank_indices.end());
+  }
+  topology.banks.reserve(banks.size());
+  for (auto& [index, bank] : banks) {
+    std::sort(bank.arg_indices.begin(), bank.arg_indices.end());
+    bank.arg_indices.erase(
+        std::unique(bank.arg_indices.begin(), bank.arg_indices.end()),
+        bank.arg_indices.end());
+    topology.banks.push_back(std::move(bank));
+  }
+  std::sort(topology.banks.begin(), topology.banks.end(),
+            [](const MemoryBank& lhs, const MemoryBank& rhs) {
+              return lhs.index < rhs.index;
+            });
+  return topology;
+}
+
+}  // namespace internal
+}  // namespace fpga
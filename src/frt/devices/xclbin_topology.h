@@ -0,0 +1,35 @@
+#ifndef FPGA_RUNTIME_XCLBIN_TOPOLOGY_H_
+#define FPGA_RUNTIME_XCLBIN_TOPOLOGY_H_
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "frt/memory_bank.h"
+
+namespace fpga {
+namespace internal {
+
+// Memory banks of an xclbin and how kernel arguments connect to them.
+struct XclbinTopology {
+  // Banks that are in use, sorted by index.
+  std::vector<MemoryBank> banks;
+  // Maps the index of each connected argument to the indices of the banks its
+  // ports connect to, sorted. An argument of a kernel with several compute
+  // units may connect to more than one bank.
+  std::unordered_map<int, std::vector<int>> arg_banks;
+};
+
+// Parses the `MEM_TOPOLOGY`, `IP_LAYOUT`, and `CONNECTIVITY` sections of xclbin
+// `binary`. Arguments are indexed across kernels, i.e., argument `i` of
+// `kernel_names[k]` has index `kernel_arg_counts[k] + i`. Returns an empty
+// topology if the sections are missing or malformed.
+XclbinTopology ParseXclbinTopology(std::string_view binary,
+                                   const std::vector<std::string>& kernel_names,
+                                   const std::vector<int>& kernel_arg_counts);
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_XCLBIN_TOPOLOGY_H_
@@ -0,0 +1,150 @@
+#include "frt/devices/xclbin_topology.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <xclbin.h>
+
+namespace fpga::internal {
+namespace {
+
+// Builds a synthetic xclbin with the given sections.
+class XclbinBuilder {
+ public:
+  template <typename Entry>
+  XclbinBuilder& AddTable(axlf_section_kind kind,
+                          const std::vector<Entry>& entries) {
+    // All tables begin with a 32-bit count padded to the entry alignment.
+    std::string content(alignof(Entry), '\0');
+    const int32_t count = entries.size();
+    memcpy(&content[0], &count, sizeof(count));
+    content.append(reinterpret_cast<const char*>(entries.data()),
+                   entries.size() * sizeof(Entry));
+    sections_.emplace_back(kind, std::move(content));
+    return *this;
+  }
+
+  std::string Build() const {
+    const size_t header_size = offsetof(axlf, m_sections) +
+                               sections_.size() * sizeof(axlf_section_header);
+    std::string binary(header_size, '\0');
+    memcpy(&binary[0], "xclbin2", 8);
+    auto axlf_top = reinterpret_cast<axlf*>(&binary[0]);
+    axlf_top->m_header.m_numSections = sections_.size();
+    std::vector<axlf_section_header> headers;
+    for (const auto& [kind, content] : sections_) {
+      binary.resize((binary.size() + 7) / 8 * 8);
+      auto& header = headers.emplace_back();
+      header.m_sectionKind = kind;
+      header.m_sectionOffset = binary.size();
+      header.m_sectionSize = content.size();
+      binary += content;
+    }
+    memcpy(&binary[offsetof(axlf, m_sections)], headers.data(),
+           headers.size() * sizeof(axlf_section_header));
+    return binary;
+  }
+
+ private:
+  std::vector<std::pair<axlf_section_kind, std::string>> sections_;
+};
+
+mem_data Mem(MEM_TYPE type, bool used, const char* tag, uint64_t base,
+             uint64_t size_kib) {
+  mem_data mem = {};
+  mem.m_type = type;
+  mem.m_used = used;
+  mem.m_base_address = base;
+  mem.m_size = size_kib;
+  strncpy(reinterpret_cast<char*>(mem.m_tag), tag, sizeof(mem.m_tag));
+  return mem;
+}
+
+ip_data Ip(IP_TYPE type, const char* name) {
+  ip_data ip = {};
+  ip.m_type = type;
+  strncpy(reinterpret_cast<char*>(ip.m_name), name, sizeof(ip.m_name));
+  return ip;
+}
+
+TEST(XclbinTopologyTest, MapsArgumentsToConnectedBanks) {
+  const std::string binary =
+      XclbinBuilder()
+          .AddTable<mem_data>(
+              MEM_TOPOLOGY,
+              {
+                  Mem(MEM_HBM, true, "HBM[0]", 0x0, 256 * 1024),
+                  Mem(MEM_HBM, true, "HBM[1]", 0x10000000, 256 * 1024),
+                  Mem(MEM_DDR4, false, "DDR[0]", 0x4000000000, 16 << 20),
+                  Mem(MEM_STREAMING, true, "stream", 0, 0),
+              })
+          .AddTable<ip_data>(IP_LAYOUT,
+                             {
+                                 Ip(IP_KERNEL, "vadd:vadd_1"),
+                                 Ip(IP_DNASC, "dna"),
+                                 Ip(IP_KERNEL, "scale:scale_1"),
+                                 Ip(IP_KERNEL, "scale:scale_2"),
+                             })
+          .AddTable<connection>(CONNECTIVITY,
+                                {
+                                    {0, 0, 0},  // vadd.a -> HBM[0]
+                                    {1, 0, 1},  // vadd.b -> HBM[1]
+                                    {0, 2, 1},  // scale_1.x -> HBM[1]
+                                    {0, 3, 0},  // scale_2.x -> HBM[0]
+                                    {1, 2, 3},  // streaming
+                                    {0, 1, 0},  // not a kernel
+                                })
+          .Build();
+
+  const XclbinTopology topology =
+      ParseXclbinTopology(binary, {"vadd", "scale"}, {0, 3});
+
+  ASSERT_EQ(topology.banks.size(), 2);
+  EXPECT_EQ(topology.banks[0].index, 0);
+  EXPECT_EQ(topology.banks[0].tag, "HBM[0]");
+  EXPECT_EQ(topology.banks[0].type, "HBM");
+  EXPECT_EQ(topology.banks[0].size, 256 << 20);
+  EXPECT_EQ(topology.banks[0].arg_indices, std::vector<int>({0, 3}));
+  EXPECT_EQ(topology.banks[1].index, 1);
+  EXPECT_EQ(topology.banks[1].base_address, 0x10000000);
+  EXPECT_EQ(topology.banks[1].arg_indices, std::vector<int>({1, 3}));
+  ASSERT_EQ(topology.arg_banks.size(), 3);
+  EXPECT_EQ(topology.arg_banks.at(0), std::vector<int>({0}));
+  EXPECT_EQ(topology.arg_banks.at(1), std::vector<int>({1}));
+  EXPECT_EQ(topology.arg_banks.at(3), std::vector<int>({0, 1}));
+}
+
+TEST(XclbinTopologyTest, ReturnsEmptyWithoutSections) {
+  const std::string binary =
+      XclbinBuilder()
+          .AddTable<mem_data>(MEM_TOPOLOGY,
+                              {Mem(MEM_DDR4, true, "DDR[0]", 0, 1024)})
+          .Build();
+
+  const XclbinTopology topology = ParseXclbinTopology(binary, {"vadd"}, {0});
+
+  EXPECT_TRUE(topology.banks.empty());
+  EXPECT_TRUE(topology.arg_banks.empty());
+}
+
+TEST(XclbinTopologyTest, ReturnsEmptyForTruncatedSections) {
+  std::string binary =
+      XclbinBuilder()
+          .AddTable<mem_data>(MEM_TOPOLOGY,
+                              {Mem(MEM_DDR4, true, "DDR[0]", 0, 1024)})
+          .AddTable<ip_data>(IP_LAYOUT, {Ip(IP_KERNEL, "vadd:vadd_1")})
+          .AddTable<connection>(CONNECTIVITY, {{0, 0, 0}})
+          .Build();
+  binary.resize(binary.size() - 1);
+
+  EXPECT_TRUE(ParseXclbinTopology(binary, {"vadd"}, {0}).banks.empty());
+  EXPECT_TRUE(ParseXclbinTopology("xclbin2", {"vadd"}, {0}).banks.empty());
+}
+
+}  // namespace
+}  // namespace fpga::internal
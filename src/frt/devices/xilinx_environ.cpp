@@ -1,15 +1,31 @@
 #include "xilinx_environ.h"
 
+#include <cstdlib>
+
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
 
 #include <subprocess.hpp>
 
+#include "frt/devices/file_cache.h"
+
 namespace fpga::xilinx {
 
 namespace {
 
+using fpga::internal::Fingerprint;
+using fpga::internal::FingerprintToString;
+using fpga::internal::GetCacheDirectory;
+using fpga::internal::GetFileStamp;
+using fpga::internal::ReadCacheFile;
+using fpga::internal::WriteCacheFile;
+
 void UpdateEnviron(std::string_view script, Environ& environ) {
   subprocess::OutBuffer output = subprocess::check_output(
       {
@@ -29,9 +45,109 @@ void UpdateEnviron(std::string_view script, Environ& environ) {
   }
 }
 
-}  // namespace
+// Variables that bash maintains by itself and that depend on how and where the
+// scripts are sourced rather than on the scripts.
+bool IsShellManaged(std::string_view name) {
+  return name == "_" || name == "SHLVL" || name == "PWD" || name == "OLDPWD";
+}
 
-Environ GetEnviron() {
+// Variables that sourcing the scripts set or changed, with the values they had
+// before, so that cached results are replayed only onto the environment they
+// were computed from.
+struct EnvironChanges {
+  Environ values;
+  // Previous values of `values`; missing if they were unset.
+  Environ inputs;
+};
+
+// Returns the variables of `environ` that differ from the current environment,
+// excluding those managed by the shell.
+EnvironChanges GetChanges(const Environ& environ) {
+  EnvironChanges changes;
+  for (const auto& [name, value] : environ) {
+    if (IsShellManaged(name)) continue;
+    const char* current = getenv(name.c_str());
+    if (current != nullptr && value == current) continue;
+    changes.values[name] = value;
+    if (current != nullptr) {
+      changes.inputs[name] = current;
+    }
+  }
+  return changes;
+}
+
+// Returns whether `changes` were computed from the current environment, i.e.,
+// whether each changed variable still has its previous value, or already has
+// the value the scripts set.
+bool AppliesToCurrentEnviron(const EnvironChanges& changes) {
+  for (const auto& [name, value] : changes.values) {
+    if (IsShellManaged(name)) continue;
+    const char* current = getenv(name.c_str());
+    if (current != nullptr && value == current) continue;
+    auto it = changes.inputs.find(name);
+    const bool is_unchanged = it == changes.inputs.end()
+                                  ? current == nullptr
+                                  : current != nullptr && it->second == current;
+    if (!is_unchanged) return false;
+  }
+  return true;
+}
+
+// Returns the current environment with `changes` applied.
+Environ ApplyToCurrentEnviron(const EnvironChanges& changes) {
+  Environ environ;
+  for (char** env = ::environ; *env != nullptr; ++env) {
+    std::string_view line = *env;
+    auto pos = line.find('=');
+    if (pos == std::string_view::npos) continue;
+    environ[std::string(line.substr(0, pos))] = line.substr(pos + 1);
+  }
+  for (const auto& [name, value] : changes.values) {
+    if (IsShellManaged(name)) continue;
+    environ[name] = value;
+  }
+  return environ;
+}
+
+// Identifies everything `ComputeEnviron` depends on without running any
+// subprocess: the relevant environment variables and the `*_hls` executables
+// that would be used to locate the Xilinx tools.
+std::string GetCacheKey() {
+  std::string key = "frt-xilinx-environ-v3";
+  key += '\0';
+  for (const char* env : {
+           "XILINX_VITIS",
+           "XILINX_SDX",
+           "XILINX_HLS",
+           "XILINX_VIVADO",
+           "XILINX_XRT",
+           "PATH",
+           "HOME",
+       }) {
+    key += env;
+    if (const char* value = getenv(env)) {
+      key += '=';
+      key += value;
+    }
+    key += '\0';
+  }
+  if (const char* path = getenv("PATH")) {
+    std::istringstream dirs(path);
+    for (std::string dir; getline(dirs, dir, ':');) {
+      for (std::string_view hls : {"vitis_hls", "vivado_hls"}) {
+        const std::string exe = dir + "/" + std::string(hls);
+        if (access(exe.c_str(), X_OK) == 0) {
+          key += exe + "@" + GetFileStamp(exe);
+          key += '\0';
+        }
+      }
+    }
+  }
+  return key;
+}
+
+// Returns the environment together with the scripts it was sourced from.
+Environ ComputeEnviron(std::vector<std::string>& scripts) {
   std::string xilinx_tool;
   for (const char* env : {
            "XILINX_VITIS",
@@ -70,11 +186,106 @@ Environ GetEnviron() {
   }
 
   Environ environ;
-  UpdateEnviron(xilinx_tool + "/settings64.sh", environ);
+  scripts.push_back(xilinx_tool + "/settings64.sh");
+  UpdateEnviron(scripts.back(), environ);
   if (const char* xrt = getenv("XILINX_XRT")) {
-    UpdateEnviron(std::string(xrt) + "/setup.sh", environ);
+    scripts.push_back(std::string(xrt) + "/setup.sh");
+    UpdateEnviron(scripts.back(), environ);
   }
   return environ;
 }
 
+// Cache file layout: a sequence of NUL-terminated strings, i.e., the key,
+// the number of scripts, a (path, stamp) pair for each script, and then a
+// `name=value` string per changed variable, each followed by `=` and its
+// previous value, or an empty string if it was unset.
+std::string SerializeEnviron(const std::string& key,
+                             const std::vector<std::string>& scripts,
+                             const EnvironChanges& changes) {
+  std::string content = key;
+  auto append = [&content](std::string_view piece) {
+    content += piece;
+    content += '\0';
+  };
+  append(std::to_string(scripts.size()));
+  for (const auto& script : scripts) {
+    append(script);
+    append(GetFileStamp(script));
+  }
+  for (const auto& [name, value] : changes.values) {
+    append(name + "=" + value);
+    auto it = changes.inputs.find(name);
+    append(it == changes.inputs.end() ? "" : "=" + it->second);
+  }
+  return content;
+}
+
+bool DeserializeEnviron(std::string_view content, const std::string& key,
+                        EnvironChanges& changes) {
+  if (content.substr(0, key.size()) != key) return false;
+  content.remove_prefix(key.size());
+  auto next = [&content](std::string_view& piece) {
+    auto pos = content.find('\0');
+    if (pos == std::string_view::npos) return false;
+    piece = content.substr(0, pos);
+    content.remove_prefix(pos + 1);
+    return true;
+  };
+  std::string_view piece;
+  if (!next(piece)) return false;
+  for (int count = atoi(std::string(piece).c_str()); count > 0; --count) {
+    std::string_view script, stamp;
+    if (!next(script) || !next(stamp) ||
+        GetFileStamp(std::string(script)) != stamp) {
+      return false;
+    }
+  }
+  while (next(piece)) {
+    auto pos = piece.find('=');
+    std::string_view input;
+    if (pos == std::string_view::npos || !next(input)) return false;
+    const std::string name(piece.substr(0, pos));
+    changes.values[name] = piece.substr(pos + 1);
+    if (!input.empty()) {
+      changes.inputs[name] = input.substr(1);
+    }
+  }
+  return content.empty();
+}
+
+}  // namespace
+
+Environ GetEnviron() {
+  static std::mutex mtx;
+  static std::unordered_map<std::string, EnvironChanges> memo;
+
+  const std::string key = GetCacheKey();
+  std::lock_guard<std::mutex> lock(mtx);
+  if (auto it = memo.find(key);
+      it != memo.end() && AppliesToCurrentEnviron(it->second)) {
+    return ApplyToCurrentEnviron(it->second);
+  }
+
+  EnvironChanges changes;
+  std::string cache_path = GetCacheDirectory("xilinx_environ");
+  if (!cache_path.empty()) {
+    cache_path += "/" + FingerprintToString(Fingerprint(key));
+    if (std::string content; ReadCacheFile(cache_path, content) &&
+                             DeserializeEnviron(content, key, changes) &&
+                             AppliesToCurrentEnviron(changes)) {
+      memo[key] = changes;
+      return ApplyToCurrentEnviron(changes);
+    }
+    changes = {};
+  }
+
+  std::vector<std::string> scripts;
+  changes = GetChanges(ComputeEnviron(scripts));
+  if (!cache_path.empty()) {
+    WriteCacheFile(cache_path, SerializeEnviron(key, scripts, changes));
+  }
+  memo[key] = changes;
+  return ApplyToCurrentEnviron(changes);
+}
+
 }  // namespace fpga::xilinx
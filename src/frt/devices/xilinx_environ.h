@@ -5,6 +5,12 @@ namespace fpga::xilinx {
 
 using Environ = std::unordered_map<std::string, std::string>;
 
+// Returns the environment set up by the Xilinx tool and XRT scripts. The
+// variables the scripts set or changed are memoized in the process and cached
+// on disk (see `file_cache.h`), keyed by the relevant environment variables
+// and invalidated when the sourced scripts or the tool executables change, or
+// when a changed variable has neither its value from before nor after the
+// scripts, so that values of other runs are never replayed.
 Environ GetEnviron();
 
 }  // namespace fpga::xilinx
@@ -0,0 +1,82 @@
+#include "frt/devices/xilinx_environ.h"
+
+#include <cstdlib>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#ifdef __cpp_lib_filesystem
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+namespace fpga::xilinx {
+namespace {
+
+class XilinxEnvironTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    char root[] = "/tmp/frt-xilinx-environ-test.XXXXXX";
+    ASSERT_NE(mkdtemp(root), nullptr);
+    root_ = root;
+
+    // A fake tool whose settings script counts how many times it is sourced.
+    fs::create_directories(root_ + "/tool");
+    fs::create_directories(root_ + "/cache");
+    fs::create_directories(root_ + "/cwd");
+    std::ofstream(root_ + "/tool/settings64.sh")
+        << "echo x >>\"" << root_ << "/count\"\n"
+        << "export FRT_TEST_SETTINGS=" << root_ << "\n";
+    setenv("XILINX_VITIS", (root_ + "/tool").c_str(), /*overwrite=*/1);
+    setenv("FRT_CACHE_DIR", (root_ + "/cache").c_str(), /*overwrite=*/1);
+    unsetenv("XILINX_XRT");
+    cwd_ = fs::current_path().string();
+  }
+
+  void TearDown() override {
+    fs::current_path(cwd_);
+    unsetenv("XILINX_VITIS");
+    unsetenv("FRT_CACHE_DIR");
+    fs::remove_all(root_);
+  }
+
+  // Returns how many times the settings script was sourced.
+  size_t GetSourceCount() const {
+    std::ifstream count(root_ + "/count");
+    return std::count(std::istreambuf_iterator<char>(count),
+                      std::istreambuf_iterator<char>(), '\n');
+  }
+
+  std::string root_;
+  std::string cwd_;
+};
+
+TEST_F(XilinxEnvironTest, IgnoresShellManagedVariables) {
+  setenv("_", "/usr/bin/first-program", /*overwrite=*/1);
+  Environ environ = GetEnviron();
+  EXPECT_EQ(environ["FRT_TEST_SETTINGS"], root_);
+  EXPECT_EQ(environ["_"], "/usr/bin/first-program");
+  ASSERT_EQ(GetSourceCount(), 1);
+
+  // Launching from another program and directory must still hit the cache.
+  setenv("_", "/usr/bin/second-program", /*overwrite=*/1);
+  fs::current_path(root_ + "/cwd");
+  setenv("PWD", (root_ + "/cwd").c_str(), /*overwrite=*/1);
+  environ = GetEnviron();
+  EXPECT_EQ(environ["FRT_TEST_SETTINGS"], root_);
+  EXPECT_EQ(environ["_"], "/usr/bin/second-program");
+  EXPECT_EQ(environ["PWD"], root_ + "/cwd");
+  EXPECT_EQ(GetSourceCount(), 1);
+}
+
+}  // namespace
+}  // namespace fpga::xilinx
@@ -1,7 +1,9 @@
 #include "frt/devices/xilinx_opencl_device.h"
 
+#include <cstdint>
 #include <cstdlib>
 
+#include <algorithm>
 #include <fstream>
 #include <initializer_list>
 #include <memory>
@@ -14,6 +16,7 @@
 #include <unistd.h>
 
 #include <CL/cl.h>
+#include <CL/cl_ext_xilinx.h>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <tinyxml.h>
@@ -22,8 +25,13 @@
 #include <nlohmann/json.hpp>
 #include <subprocess.hpp>
 
+#include "frt/devices/file_cache.h"
+#include "frt/devices/metadata_cache.h"
 #include "frt/devices/opencl_device_matcher.h"
+#include "frt/devices/opencl_inventory.h"
 #include "frt/devices/opencl_util.h"
+#include "frt/devices/sysfs.h"
+#include "frt/devices/xclbin_topology.h"
 #include "frt/devices/xilinx_environ.h"
 #include "frt/devices/xilinx_opencl_stream.h"
 #include "frt/stream_wrapper.h"
@@ -40,6 +48,9 @@ namespace fs = std::experimental::filesystem;
 DEFINE_string(xocl_bdf, "",
               "if not empty, use the specified PCIe Bus:Device:Function "
               "instead of trying to match device name");
+DEFINE_bool(xocl_bank_placement, true,
+            "allocate each buffer in the memory bank that its kernel argument "
+            "connects to instead of letting XRT choose");
 
 namespace fpga {
 namespace internal {
@@ -91,21 +102,23 @@ class DeviceMatcher : public OpenclDeviceMatcher {
   DeviceMatcher& operator=(const DeviceMatcher&) = delete;
   DeviceMatcher& operator=(DeviceMatcher&&) = delete;
 
-  std::string GetTargetName() const override { return target_device_name_; }
+  std::string GetTargetName() const override {
+    if (!FLAGS_xocl_bdf.empty()) {
+      return Concat({target_device_name_, " (bdf=", FLAGS_xocl_bdf, ")"});
+    }
+    return target_device_name_;
+  }
 
-  std::string Match(cl::Device device) const override {
-    const std::string device_name = device.getInfo<CL_DEVICE_NAME>();
-    char bdf[32];
-    size_t bdf_size = 0;
-    cl_int rc = clGetDeviceInfo(device.get(), CL_DEVICE_PCIE_BDF, sizeof(bdf), bdf,
-                             &bdf_size);
-    if (rc != CL_SUCCESS) { return ""; }
+  std::string Match(const OpenclDeviceEntry& device) const override {
+    const std::string& device_name = device.name;
     const std::string device_name_and_bdf =
-        Concat({device_name, " (bdf=", bdf, ")"});
-    LOG(INFO) << "Found device: " << device_name_and_bdf;
+        device.bdf.empty() ? device_name
+                           : Concat({device_name, " (bdf=", device.bdf, ")"});
 
-    if (const std::string target_bdf = FLAGS_xocl_bdf; !target_bdf.empty()) {
-      if (target_bdf == bdf) {
+    if (!FLAGS_xocl_bdf.empty()) {
+      // Malformed BDFs reported by the platform are compared as is.
+      if (NormalizeBdf(FLAGS_xocl_bdf) == device.bdf ||
+          FLAGS_xocl_bdf == device.bdf) {
         return device_name_and_bdf;
       }
       return "";
@@ -145,51 +158,53 @@ class DeviceMatcher : public OpenclDeviceMatcher {
   const std::vector<std::string_view> target_device_name_pieces_;
 };
 
-}  // namespace
+// Fails early if `bdf` does not name a PCIe function, before paying for
+// OpenCL platform enumeration.
+void CheckBdf(const std::string& bdf) {
+  // Malformed BDFs are not found either, and fall back to the scan below.
+  if (auto device = FindPciDevice(bdf); device.has_value()) {
+    LOG_IF(WARNING, device->vendor_id != kXilinxPciVendorId)
+        << "PCIe device " << device->bdf << " is not a Xilinx device";
+    return;
+  }
+  // The bus is only scanned to tell what the user may have meant.
+  const std::vector<PciDevice> pci_devices = ScanPciDevices();
+  if (pci_devices.empty()) {
+    return;  // sysfs not available; let OpenCL find out.
+  }
+  std::string xilinx_bdfs;
+  for (const auto& device : pci_devices) {
+    if (device.vendor_id == kXilinxPciVendorId) {
+      xilinx_bdfs += " " + device.bdf;
+    }
+  }
+  LOG(FATAL) << "No PCIe device at --xocl_bdf '" << bdf << "'"
+             << (NormalizeBdf(bdf).empty() ? ", expecting [dddd:]bb:dd.f" : "")
+             << "; Xilinx devices:" << (xilinx_bdfs.empty() ? " none" : "")
+             << xilinx_bdfs;
+}
 
-XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
-  std::string target_device_name;
-  std::vector<std::string> kernel_names;
-  std::vector<int> kernel_arg_counts;
+KernelMetadata ParseMetadata(const axlf* axlf_top) {
+  KernelMetadata metadata;
   int arg_count = 0;
-  const auto axlf_top = reinterpret_cast<const axlf*>(binaries.begin()->data());
-  switch (axlf_top->m_header.m_mode) {
-    case XCLBIN_FLAT:
-    case XCLBIN_PR:
-    case XCLBIN_TANDEM_STAGE2:
-    case XCLBIN_TANDEM_STAGE2_WITH_PR:
-      break;
-    case XCLBIN_HW_EMU:
-      setenv("XCL_EMULATION_MODE", "hw_emu", 0);
-      break;
-    case XCLBIN_SW_EMU:
-      setenv("XCL_EMULATION_MODE", "sw_emu", 0);
-      break;
-    default:
-      LOG(FATAL) << "Unknown xclbin mode";
-  }
-  target_device_name =
-      reinterpret_cast<const char*>(axlf_top->m_header.m_platformVBNV);
-  LOG_IF(FATAL, target_device_name.empty())
-      << "Cannot determine target device name from binary";
-  if (auto metadata = xclbin::get_axlf_section(axlf_top, EMBEDDED_METADATA)) {
+  if (auto section = xclbin::get_axlf_section(axlf_top, EMBEDDED_METADATA)) {
     TiXmlDocument doc;
     doc.Parse(
-        reinterpret_cast<const char*>(axlf_top) + metadata->m_sectionOffset,
+        reinterpret_cast<const char*>(axlf_top) + section->m_sectionOffset,
         nullptr, TIXML_ENCODING_UTF8);
     auto xml_core = doc.FirstChildElement("project")
                         ->FirstChildElement("platform")
                         ->FirstChildElement("device")
                         ->FirstChildElement("core");
-    std::string target_meta = xml_core->Attribute("target");
+    metadata.mode = xml_core->Attribute("target");
     for (auto xml_kernel = xml_core->FirstChildElement("kernel");
          xml_kernel != nullptr;
          xml_kernel = xml_kernel->NextSiblingElement("kernel")) {
-      kernel_names.push_back(xml_kernel->Attribute("name"));
-      kernel_arg_counts.push_back(arg_count);
+      metadata.kernel_names.push_back(xml_kernel->Attribute("name"));
+      metadata.kernel_arg_counts.push_back(arg_count);
       for (auto xml_arg = xml_kernel->FirstChildElement("arg");
            xml_arg != nullptr; xml_arg = xml_arg->NextSiblingElement("arg")) {
-        auto& arg = arg_table_[arg_count];
+        auto& arg = metadata.args.emplace_back();
         arg.index = arg_count;
         ++arg_count;
         arg.name = xml_arg->Attribute("name");
@@ -210,15 +225,52 @@ XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
         }
       }
     }
-    // m_mode doesn't always work
-    if (target_meta == "hw_em") {
-      setenv("XCL_EMULATION_MODE", "hw_emu", 0);
-    } else if (target_meta == "csim") {
-      setenv("XCL_EMULATION_MODE", "sw_emu", 0);
-    }
   } else {
     LOG(FATAL) << "Cannot determine kernel name from binary";
   }
+  return metadata;
+}
+
+}  // namespace
+
+XilinxOpenclDevice::XilinxOpenclDevice(const Bitstream& bitstream) {
+  std::string target_device_name;
+  const auto axlf_top =
+      reinterpret_cast<const axlf*>(bitstream.Content().data());
+  switch (axlf_top->m_header.m_mode) {
+    case XCLBIN_FLAT:
+    case XCLBIN_PR:
+    case XCLBIN_TANDEM_STAGE2:
+    case XCLBIN_TANDEM_STAGE2_WITH_PR:
+      break;
+    case XCLBIN_HW_EMU:
+      setenv("XCL_EMULATION_MODE", "hw_emu", 0);
+      break;
+    case XCLBIN_SW_EMU:
+      setenv("XCL_EMULATION_MODE", "sw_emu", 0);
+      break;
+    default:
+      LOG(FATAL) << "Unknown xclbin mode";
+  }
+  target_device_name =
+      reinterpret_cast<const char*>(axlf_top->m_header.m_platformVBNV);
+  LOG_IF(FATAL, target_device_name.empty())
+      << "Cannot determine target device name from binary";
+  const KernelMetadata metadata =
+      GetKernelMetadata("xilinx", GetCachedProgramId(bitstream),
+                        [axlf_top] { return ParseMetadata(axlf_top); });
+  for (const auto& arg : metadata.args) {
+    arg_table_[arg.index] = arg;
+  }
+  topology_ = ParseXclbinTopology(bitstream.Content(), metadata.kernel_names,
+                                  metadata.kernel_arg_counts);
+  startup_phases_.Record("metadata");
+  // m_mode doesn't always work
+  if (metadata.mode == "hw_em") {
+    setenv("XCL_EMULATION_MODE", "hw_emu", 0);
+  } else if (metadata.mode == "csim") {
+    setenv("XCL_EMULATION_MODE", "sw_emu", 0);
+  }
 
   if (const char* xcl_emulation_mode = getenv("XCL_EMULATION_MODE")) {
     for (const auto& [name, value] : xilinx::GetEnviron()) {
@@ -299,20 +351,23 @@ XilinxOpenclDevice::XilinxOpenclDevice(const cl::Program::Binaries& binaries) {
     }
   } else {
     LOG(INFO) << "Running on-board execution with Xilinx OpenCL";
+    if (!FLAGS_xocl_bdf.empty()) {
+      CheckBdf(FLAGS_xocl_bdf);
+    }
   }
+  startup_phases_.Record("environment");
 
-  Initialize(binaries, /*vendor_name=*/"Xilinx",
-             DeviceMatcher(target_device_name), kernel_names,
-             kernel_arg_counts);
+  Initialize(bitstream, /*vendor_name=*/"Xilinx",
+             DeviceMatcher(target_device_name), metadata.kernel_names,
+             metadata.kernel_arg_counts);
 }
 
-std::unique_ptr<Device> XilinxOpenclDevice::New(
-    const cl::Program::Binaries& binaries) {
-  if (binaries.size() != 1 || binaries.begin()->size() < 8 ||
-      memcmp(binaries.begin()->data(), "xclbin2", 8) != 0) {
+std::unique_ptr<Device> XilinxOpenclDevice::New(const Bitstream& bitstream) {
+  if (std::string_view header = bitstream.Header();
+      header.size() < 8 || memcmp(header.data(), "xclbin2", 8) != 0) {
     return nullptr;
   }
-  return std::make_unique<XilinxOpenclDevice>(binaries);
+  return std::make_unique<XilinxOpenclDevice>(bitstream);
 }
 
 void XilinxOpenclDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
@@ -325,32 +380,84 @@ void XilinxOpenclDevice::SetStreamArg(int index, Tag tag, StreamWrapper& arg) {
 #endif  // FRT_ENABLE_XOCL_STREAM
 }
 
-void XilinxOpenclDevice::WriteToDevice() {
-  if (!load_indices_.empty()) {
-    load_event_.resize(1);
-    CL_CHECK(cmd_.enqueueMigrateMemObjects(GetLoadBuffers(), /* flags = */ 0,
-                                           /* events = */ nullptr,
-                                           load_event_.data()));
-  } else {
-    load_event_.clear();
-  }
+std::vector<MemoryBank> XilinxOpenclDevice::GetMemoryTopology() const {
+  return topology_.banks;
 }
 
-void XilinxOpenclDevice::ReadFromDevice() {
-  if (!store_indices_.empty()) {
-    store_event_.resize(1);
-    CL_CHECK(cmd_.enqueueMigrateMemObjects(
-        GetStoreBuffers(), CL_MIGRATE_MEM_OBJECT_HOST, &compute_event_,
-        store_event_.data()));
-  } else {
-    store_event_.clear();
+std::string XilinxOpenclDevice::GetProgramId(
+    const Bitstream& bitstream) const {
+  // The UUID identifies an xclbin without reading all of it; fall back to
+  // the file if it is not set.
+  const auto axlf_top =
+      reinterpret_cast<const axlf*>(bitstream.Content().data());
+  const auto& uuid = axlf_top->m_header.uuid;
+  if (std::all_of(std::begin(uuid), std::end(uuid),
+                  [](unsigned char byte) { return byte == 0; })) {
+    return OpenclDevice::GetProgramId(bitstream);
   }
+  return "uuid:" + FingerprintToString(Fingerprint(std::string_view(
+                       reinterpret_cast<const char*>(uuid), sizeof(uuid))));
 }
 
 cl::Buffer XilinxOpenclDevice::CreateBuffer(int index, cl_mem_flags flags,
                                             void* host_ptr, size_t size) {
-  flags |= CL_MEM_USE_HOST_PTR;
-  return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+  // Staged buffers have no host pointer.
+  if (host_ptr != nullptr) {
+    flags |= CL_MEM_USE_HOST_PTR;
+  }
+  const int bank = GetArgBank(index);
+  if (bank < 0) {
+    return OpenclDevice::CreateBuffer(index, flags, host_ptr, size);
+  }
+
+  VLOG(1) << "Allocating buffer argument #" << index << " in memory bank "
+          << bank;
+  cl_mem_ext_ptr_t ext;
+  ext.flags = bank | XCL_MEM_TOPOLOGY;
+  ext.obj = host_ptr;
+  ext.param = nullptr;
+  auto buffer = OpenclDevice::CreateBuffer(
+      index, flags | CL_MEM_EXT_PTR_XILINX, &ext, size);
+  // The host pointer is hidden behind the extension pointer.
+  BufferInfo& info = buffer_info_table_.at(index);
+  info.zero_copy =
+      host_ptr != nullptr &&
+      reinterpret_cast<uintptr_t>(host_ptr) % GetZeroCopyAlignment() == 0;
+  info.memory_bank = bank;
+  return buffer;
+}
+
+int XilinxOpenclDevice::GetArgBank(int index) const {
+  auto it = topology_.arg_banks.find(index);
+  if (!FLAGS_xocl_bank_placement || it == topology_.arg_banks.end()) {
+    return -1;
+  }
+  // If compute units connect the argument to different banks, XRT runs the
+  // kernel on those connected to the chosen bank.
+  return it->second.front();
+}
+
+cl::Buffer XilinxOpenclDevice::CreateArenaBuffer(int bank, void* host_ptr,
+                                                 size_t size) {
+  if (bank < 0) {
+    return OpenclDevice::CreateArenaBuffer(bank, host_ptr, size);
+  }
+  cl_mem_ext_ptr_t ext;
+  ext.flags = bank | XCL_MEM_TOPOLOGY;
+  ext.obj = host_ptr;
+  ext.param = nullptr;
+  cl_int err;
+  cl::Buffer buffer(context_,
+                    CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR |
+                        CL_MEM_EXT_PTR_XILINX,
+                    size, &ext, &err);
+  CL_CHECK(err);
+  return buffer;
+}
+
+size_t XilinxOpenclDevice::GetZeroCopyAlignment() const {
+  // XRT silently copies host memory that is not page-aligned.
+  return 4096;
 }
 
 }  // namespace internal
@@ -5,28 +5,38 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include <CL/cl2.hpp>
 
+#include "frt/bitstream.h"
 #include "frt/devices/opencl_device.h"
+#include "frt/devices/xclbin_topology.h"
+#include "frt/memory_bank.h"
 
 namespace fpga {
 namespace internal {
 
 class XilinxOpenclDevice : public OpenclDevice {
  public:
-  XilinxOpenclDevice(const cl::Program::Binaries& binaries);
+  XilinxOpenclDevice(const Bitstream& bitstream);
 
-  static std::unique_ptr<Device> New(const cl::Program::Binaries& binaries);
+  static std::unique_ptr<Device> New(const Bitstream& bitstream);
 
   void SetStreamArg(int index, Tag tag, StreamWrapper& arg) override;
-  void WriteToDevice() override;
-  void ReadFromDevice() override;
+  std::vector<MemoryBank> GetMemoryTopology() const override;
 
  private:
+  std::string GetProgramId(const Bitstream& bitstream) const override;
   cl::Buffer CreateBuffer(int index, cl_mem_flags flags, void* host_ptr,
                           size_t size) override;
+  size_t GetZeroCopyAlignment() const override;
+  int GetArgBank(int index) const override;
+  cl::Buffer CreateArenaBuffer(int bank, void* host_ptr, size_t size) override;
+
+  XclbinTopology topology_;
 };
 
 }  // namespace internal
@@ -0,0 +1,256 @@
+#include "frt/host_buffer_pool.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include <sys/mman.h>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "frt/devices/numa.h"
+
+DEFINE_uint64(host_buffer_pool_max_mib, 1024,
+              "maximum size of freed host buffers kept for reuse in MiB");
+DEFINE_bool(host_buffer_pool_pin, false,
+            "lock pooled host buffers in memory with mlock");
+DEFINE_string(host_buffer_pool_huge_pages, "none",
+              "pages backing pooled host buffers of at least 2 MiB; one of "
+              "'1g', '2m' (hugetlbfs), 'thp' (transparent), or 'none'");
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+HostBufferPool::HugePages ParseHugePages(const std::string& name) {
+  if (name == "1g") return HostBufferPool::HugePages::k1GiB;
+  if (name == "2m") return HostBufferPool::HugePages::k2MiB;
+  if (name == "thp") return HostBufferPool::HugePages::kTransparent;
+  LOG_IF(FATAL, name != "none")
+      << "Unknown --host_buffer_pool_huge_pages '" << name
+      << "'; expecting '1g', '2m', 'thp', or 'none'";
+  return HostBufferPool::HugePages::kNone;
+}
+
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+HostBufferPool& HostBufferPool::Get() {
+  static auto* pool = new HostBufferPool(
+      FLAGS_host_buffer_pool_max_mib << 20, FLAGS_host_buffer_pool_pin,
+      ParseHugePages(FLAGS_host_buffer_pool_huge_pages));
+  return *pool;
+}
+
+HostBufferPool::HostBufferPool(size_t max_cached_bytes, bool pin,
+                               HugePages huge_pages)
+    : max_cached_bytes_(max_cached_bytes),
+      pin_(pin),
+      huge_pages_(huge_pages) {}
+
+HostBufferPool::~HostBufferPool() {
+  for (const auto& [size_class, ptrs] : free_lists_) {
+    for (void* ptr : ptrs) {
+      Free(ptr, size_class);
+    }
+  }
+}
+
+void* HostBufferPool::Allocate(size_t size) {
+  const size_t size_class = GetSizeClass(size);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto it = free_lists_.find(size_class);
+        it != free_lists_.end() && !it->second.empty()) {
+      void* ptr = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= GetLengthLocked(ptr, size_class);
+      ++stats_.hits;
+      stats_.saved_nanoseconds = miss_nanoseconds_ * stats_.hits /
+                                 (stats_.misses == 0 ? 1 : stats_.misses);
+      return ptr;
+    }
+  }
+
+  const auto tic = std::chrono::steady_clock::now();
+  void* ptr = huge_pages_ != HugePages::kNone && size_class >= kHugePageSize
+                  ? MapHugePages(size_class)
+                  : aligned_alloc(kAlignment, size_class);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  // Binds the pages before `mlock` faults them in.
+  const int node = numa_node_;
+  if (node >= 0 && !BindToNumaNode(ptr, size_class, node)) {
+    LOG_FIRST_N(WARNING, 1) << "Cannot bind host buffers to NUMA node "
+                            << node << ": " << strerror(errno);
+  }
+  if (pin_ && mlock(ptr, size_class) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "Cannot pin host buffers: " << strerror(errno)
+                            << "; check `ulimit -l`";
+  }
+  const auto toc = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  ++stats_.misses;
+  miss_nanoseconds_ += std::chrono::nanoseconds(toc - tic).count();
+  return ptr;
+}
+
+void HostBufferPool::Deallocate(void* ptr, size_t size) {
+  if (ptr == nullptr) return;
+  const size_t size_class = GetSizeClass(size);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // Huge pages may map more than the size class.
+    const size_t length = GetLengthLocked(ptr, size_class);
+    if (cached_bytes_ + length <= max_cached_bytes_) {
+      free_lists_[size_class].push_back(ptr);
+      cached_bytes_ += length;
+      return;
+    }
+  }
+  Free(ptr, size_class);
+}
+
+void HostBufferPool::SetNumaNode(int node) { numa_node_ = node; }
+
+size_t HostBufferPool::CachedBytes() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return cached_bytes_;
+}
+
+CacheStats HostBufferPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return stats_;
+}
+
+size_t HostBufferPool::HugePageBytes() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return huge_page_bytes_;
+}
+
+size_t HostBufferPool::GetSizeClass(size_t size) {
+  if (size <= kAlignment) return kAlignment;
+  // Rounds up to a quarter of the largest power of two not above `size`, so
+  // that at most a quarter, or a page for small sizes, is wasted.
+  size_t step = size_t(1) << (63 - __builtin_clzll(size));
+  step = std::max(step / 4, kAlignment);
+  return (size + step - 1) / step * step;
+}
+
+void* HostBufferPool::MapHugePages(size_t size) {
+  void* ptr = nullptr;
+  size_t length = 0;
+  bool is_huge = true;
+  switch (huge_pages_) {
+    case HugePages::k1GiB:
+      // Smaller allocations would waste most of a 1 GiB page.
+      if (size >= kHugePageSize1GiB) {
+        length = RoundUp(size, kHugePageSize1GiB);
+        if ((ptr = MapHugetlbPages(length, 30)) != nullptr) break;
+        LOG_FIRST_N(WARNING, 1)
+            << "Cannot allocate 1 GiB huge pages: " << strerror(errno)
+            << "; check /sys/kernel/mm/hugepages/hugepages-1048576kB";
+      }
+      [[fallthrough]];
+    case HugePages::k2MiB:
+      length = RoundUp(size, kHugePageSize);
+      if ((ptr = MapHugetlbPages(length, 21)) != nullptr) break;
+      LOG_FIRST_N(WARNING, 1)
+          << "Cannot allocate 2 MiB huge pages: " << strerror(errno)
+          << "; check /proc/sys/vm/nr_hugepages";
+      [[fallthrough]];
+    case HugePages::kTransparent:
+      // Aligning the mapping lets the kernel back all of it by huge pages.
+      length = RoundUp(size, kHugePageSize);
+      if ((ptr = MapAlignedPages(length)) == nullptr) return nullptr;
+      if (madvise(ptr, length, MADV_HUGEPAGE) != 0) {
+        LOG_FIRST_N(WARNING, 1)
+            << "Cannot use transparent huge pages: " << strerror(errno)
+            << "; check /sys/kernel/mm/transparent_hugepage/enabled";
+        is_huge = false;
+      }
+      break;
+    case HugePages::kNone:
+      length = size;
+      if ((ptr = MapAlignedPages(length)) == nullptr) return nullptr;
+      is_huge = false;
+      break;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  mappings_[ptr] = {length, is_huge};
+  if (is_huge) {
+    huge_page_bytes_ += length;
+  }
+  return ptr;
+}
+
+void* HostBufferPool::MapHugetlbPages(size_t length, int page_shift) {
+  void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                       (page_shift << MAP_HUGE_SHIFT),
+                   /*fd=*/-1, /*offset=*/0);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+void* HostBufferPool::MapAlignedPages(size_t length) {
+  // Maps an extra huge page and unmaps what is outside the aligned range.
+  const size_t mapped_length = length + kHugePageSize;
+  void* mapped = mmap(nullptr, mapped_length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, /*fd=*/-1, /*offset=*/0);
+  if (mapped == MAP_FAILED) return nullptr;
+  char* begin = static_cast<char*>(mapped);
+  char* end = begin + mapped_length;
+  char* ptr = reinterpret_cast<char*>(
+      RoundUp(reinterpret_cast<uintptr_t>(begin), kHugePageSize));
+  if (ptr != begin) {
+    munmap(begin, ptr - begin);
+  }
+  if (ptr + length != end) {
+    munmap(ptr + length, end - (ptr + length));
+  }
+  return ptr;
+}
+
+size_t HostBufferPool::GetLengthLocked(void* ptr, size_t size_class) const {
+  if (auto it = mappings_.find(ptr); it != mappings_.end()) {
+    return it->second.length;
+  }
+  return size_class;
+}
+
+void HostBufferPool::Free(void* ptr, size_t size_class) {
+  if (pin_) {
+    munlock(ptr, size_class);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto it = mappings_.find(ptr); it != mappings_.end()) {
+      const Mapping mapping = it->second;
+      mappings_.erase(it);
+      if (mapping.is_huge) {
+        huge_page_bytes_ -= mapping.length;
+      }
+      munmap(ptr, mapping.length);
+      return;
+    }
+  }
+  free(ptr);
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,120 @@
+#ifndef FPGA_RUNTIME_HOST_BUFFER_POOL_H_
+#define FPGA_RUNTIME_HOST_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "frt/cache_stats.h"
+
+namespace fpga {
+namespace internal {
+
+// Thread-safe pool of page-aligned host allocations. Freed allocations are
+// kept in size classes, each a quarter of a power of two apart, and handed
+// out again to later requests of a similar size. Page-aligned host memory
+// lets OpenCL runtimes use it for DMA directly with `CL_MEM_USE_HOST_PTR`;
+// recycling it also saves faulting (and optionally pinning) its pages again.
+//
+// Large allocations can be backed by huge pages, which take fewer TLB entries
+// on the host and fewer page descriptors to pin for DMA.
+class HostBufferPool {
+ public:
+  static constexpr size_t kAlignment = 4096;
+  // Allocations smaller than this always use regular pages.
+  static constexpr size_t kHugePageSize = 2 << 20;
+  // Allocations smaller than this use 2 MiB pages even in `k1GiB` mode.
+  static constexpr size_t kHugePageSize1GiB = size_t(1) << 30;
+
+  // Pages backing allocations of at least `kHugePageSize` bytes. Each mode
+  // falls back to the next one if the system does not provide the pages.
+  enum class HugePages {
+    // hugetlbfs pages of 1 GiB, reserved in `/sys/kernel/mm/hugepages`, for
+    // allocations of at least `kHugePageSize1GiB` bytes.
+    k1GiB,
+    // hugetlbfs pages of 2 MiB, reserved in `/proc/sys/vm/nr_hugepages`.
+    k2MiB,
+    // Transparent huge pages requested with `madvise`.
+    kTransparent,
+    // Regular pages.
+    kNone,
+  };
+
+  // Returns the process-wide pool, configured by `--host_buffer_pool_*`.
+  static HostBufferPool& Get();
+
+  // Keeps at most `max_cached_bytes` of freed allocations, counting the whole
+  // mapping of those backed by huge pages. Allocations are
+  // locked in memory with `mlock` if `pin` is set.
+  HostBufferPool(size_t max_cached_bytes, bool pin,
+                 HugePages huge_pages = HugePages::kNone);
+  HostBufferPool(const HostBufferPool&) = delete;
+  HostBufferPool& operator=(const HostBufferPool&) = delete;
+  HostBufferPool(HostBufferPool&&) = delete;
+  HostBufferPool& operator=(HostBufferPool&&) = delete;
+  ~HostBufferPool();
+
+  // Returns `kAlignment`-aligned memory of at least `size` bytes.
+  void* Allocate(size_t size);
+
+  // Returns `ptr`, allocated with the same `size`, to the pool.
+  void Deallocate(void* ptr, size_t size);
+
+  // Makes later allocations prefer NUMA node `node`, or no node if negative.
+  // Memory already in the pool is not moved.
+  void SetNumaNode(int node);
+
+  // Returns the number of bytes of freed allocations kept for reuse.
+  size_t CachedBytes() const;
+
+  CacheStats GetStats() const;
+
+  // Returns the number of bytes currently allocated with huge pages, including
+  // transparent ones that the kernel may not have been able to provide.
+  size_t HugePageBytes() const;
+
+  // Returns the size actually allocated for `size` bytes.
+  static size_t GetSizeClass(size_t size);
+
+ private:
+  // Maps at least `size` bytes with the first available kind of huge pages,
+  // starting from `huge_pages_`, and records the mapping.
+  void* MapHugePages(size_t size);
+  // Maps `length` bytes of hugetlbfs pages of `1 << page_shift` bytes.
+  // Returns nullptr if they are not available.
+  static void* MapHugetlbPages(size_t length, int page_shift);
+  // Maps `length` bytes aligned to `kHugePageSize`.
+  static void* MapAlignedPages(size_t length);
+
+  // Returns the bytes mapped for `ptr` of `size_class`. Requires `mtx_`.
+  size_t GetLengthLocked(void* ptr, size_t size_class) const;
+  void Free(void* ptr, size_t size_class);
+
+  const size_t max_cached_bytes_;
+  const bool pin_;
+  const HugePages huge_pages_;
+  std::atomic<int> numa_node_{-1};
+
+  mutable std::mutex mtx_;
+  std::unordered_map<size_t, std::vector<void*>> free_lists_;
+  size_t cached_bytes_ = 0;
+  CacheStats stats_;
+  // Total time spent on misses, to estimate the time saved by hits.
+  int64_t miss_nanoseconds_ = 0;
+  // Allocations made with `mmap` instead of `aligned_alloc`.
+  struct Mapping {
+    size_t length;
+    bool is_huge;
+  };
+  std::unordered_map<void*, Mapping> mappings_;
+  size_t huge_page_bytes_ = 0;
+};
+
+}  // namespace internal
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_HOST_BUFFER_POOL_H_
@@ -0,0 +1,70 @@
+#include "frt/host_buffer_pool.h"
+
+#include <cstring>
+
+#include <benchmark/benchmark.h>
+
+namespace fpga::internal {
+namespace {
+
+using HugePages = HostBufferPool::HugePages;
+
+// Runs each benchmark with every kind of pages, as `range(0)`, and buffers of
+// `range(1)` MiB.
+void HugePagesArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"huge_pages", "mib"});
+  for (auto huge_pages : {HugePages::k1GiB, HugePages::k2MiB,
+                          HugePages::kTransparent, HugePages::kNone}) {
+    for (int mib : {64, 1024}) {
+      benchmark->Args({static_cast<int>(huge_pages), mib});
+    }
+  }
+}
+
+// Reports how many bytes the system actually backed by huge pages, since each
+// kind falls back to the next one if it is not available.
+void ReportHugePageBytes(benchmark::State& state, const HostBufferPool& pool) {
+  state.counters["huge_page_bytes"] = pool.HugePageBytes();
+}
+
+// Measures allocating a buffer and pinning it with `mlock`, which faults in
+// all of its pages. This approximates what registering fresh host memory for
+// DMA costs, e.g., with `CL_MEM_USE_HOST_PTR`. Pinning needs a large enough
+// `ulimit -l`; otherwise only page faults are measured.
+void BM_AllocateAndPin(benchmark::State& state) {
+  const size_t size = size_t(state.range(1)) << 20;
+  HostBufferPool pool(/*max_cached_bytes=*/0, /*pin=*/true,
+                      static_cast<HugePages>(state.range(0)));
+  for (auto _ : state) {
+    void* ptr = pool.Allocate(size);
+    benchmark::DoNotOptimize(ptr);
+    ReportHugePageBytes(state, pool);
+    pool.Deallocate(ptr, size);
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_AllocateAndPin)->Apply(HugePagesArgs)->UseRealTime();
+
+// Measures host-side copies between buffers whose pages are already present,
+// where huge pages save TLB misses.
+void BM_Memcpy(benchmark::State& state) {
+  const size_t size = size_t(state.range(1)) << 20;
+  HostBufferPool pool(/*max_cached_bytes=*/0, /*pin=*/false,
+                      static_cast<HugePages>(state.range(0)));
+  auto src = static_cast<char*>(pool.Allocate(size));
+  auto dst = static_cast<char*>(pool.Allocate(size));
+  memset(src, 1, size);
+  memset(dst, 0, size);
+  for (auto _ : state) {
+    memcpy(dst, src, size);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * size);
+  ReportHugePageBytes(state, pool);
+  pool.Deallocate(dst, size);
+  pool.Deallocate(src, size);
+}
+BENCHMARK(BM_Memcpy)->Apply(HugePagesArgs)->UseRealTime();
+
+}  // namespace
+}  // namespace fpga::internal
@@ -0,0 +1,105 @@
+#include "frt/host_buffer_pool.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "frt/aligned_allocator.h"
+
+namespace fpga::internal {
+namespace {
+
+bool IsAligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % HostBufferPool::kAlignment == 0;
+}
+
+TEST(HostBufferPoolTest, GetSizeClassWastesAtMostAQuarterOrAPage) {
+  EXPECT_EQ(HostBufferPool::GetSizeClass(1), 4096);
+  EXPECT_EQ(HostBufferPool::GetSizeClass(4096), 4096);
+  EXPECT_EQ(HostBufferPool::GetSizeClass(4097), 8192);
+  EXPECT_EQ(HostBufferPool::GetSizeClass(1 << 20), 1 << 20);
+  EXPECT_EQ(HostBufferPool::GetSizeClass((1 << 20) + 1), 5 << 18);
+  for (size_t size = 4096; size < (size_t(1) << 32); size = size * 3 + 1) {
+    EXPECT_GE(HostBufferPool::GetSizeClass(size), size);
+    EXPECT_LE(HostBufferPool::GetSizeClass(size),
+              size + std::max(size / 4, HostBufferPool::kAlignment));
+  }
+}
+
+TEST(HostBufferPoolTest, AllocateReusesFreedMemoryOfSameClass) {
+  HostBufferPool pool(/*max_cached_bytes=*/1 << 20, /*pin=*/false);
+
+  void* ptr = pool.Allocate(10000);
+  pool.Deallocate(ptr, 10000);
+
+  EXPECT_TRUE(IsAligned(ptr));
+  EXPECT_EQ(pool.CachedBytes(), HostBufferPool::GetSizeClass(10000));
+  EXPECT_EQ(pool.Allocate(12000), ptr);
+  EXPECT_EQ(pool.CachedBytes(), 0);
+  EXPECT_EQ(pool.GetStats().hits, 1);
+  EXPECT_EQ(pool.GetStats().misses, 1);
+  pool.Deallocate(ptr, 12000);
+}
+
+TEST(HostBufferPoolTest, DeallocateFreesBeyondLimit) {
+  HostBufferPool pool(/*max_cached_bytes=*/8192, /*pin=*/false);
+
+  void* small = pool.Allocate(8192);
+  void* large = pool.Allocate(16384);
+  pool.Deallocate(large, 16384);
+  pool.Deallocate(small, 8192);
+
+  EXPECT_EQ(pool.CachedBytes(), 8192);
+  EXPECT_EQ(pool.Allocate(8192), small);
+  EXPECT_EQ(pool.GetStats().hits, 1);
+  pool.Deallocate(small, 8192);
+}
+
+TEST(HostBufferPoolTest, HugePagesFallBackGracefully) {
+  // Whichever pages the system provides, large allocations are aligned to a
+  // huge page and small ones use regular pages.
+  for (auto huge_pages : {HostBufferPool::HugePages::k1GiB,
+                          HostBufferPool::HugePages::k2MiB,
+                          HostBufferPool::HugePages::kTransparent}) {
+    HostBufferPool pool(/*max_cached_bytes=*/0, /*pin=*/false, huge_pages);
+    constexpr size_t kSize = 3 * HostBufferPool::kHugePageSize;
+
+    char* large = static_cast<char*>(pool.Allocate(kSize));
+    void* small = pool.Allocate(HostBufferPool::kAlignment);
+    std::fill(large, large + kSize, 1);
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large) %
+                  HostBufferPool::kHugePageSize,
+              0);
+    EXPECT_EQ(large[kSize - 1], 1);
+    // Allocations below 1 GiB are not rounded up to 1 GiB pages.
+    EXPECT_LE(pool.HugePageBytes(), HostBufferPool::GetSizeClass(kSize));
+    pool.Deallocate(small, HostBufferPool::kAlignment);
+    pool.Deallocate(large, kSize);
+    EXPECT_EQ(pool.HugePageBytes(), 0);
+  }
+}
+
+TEST(HostBufferPoolTest, CacheLimitCountsMappedHugePages) {
+  // 2.5 MiB is mapped as two 2 MiB huge pages, which exceed the limit.
+  HostBufferPool pool(/*max_cached_bytes=*/3 << 20, /*pin=*/false,
+                      HostBufferPool::HugePages::kTransparent);
+  constexpr size_t kSize = 5 * HostBufferPool::kHugePageSize / 4;
+
+  pool.Deallocate(pool.Allocate(kSize), kSize);
+
+  EXPECT_EQ(pool.CachedBytes(), 0);
+}
+
+TEST(AlignedAllocatorTest, VectorIsPageAligned) {
+  std::vector<float, AlignedAllocator<float>> vec(1000, 1.f);
+
+  EXPECT_TRUE(IsAligned(vec.data()));
+  EXPECT_EQ(vec[999], 1.f);
+}
+
+}  // namespace
+}  // namespace fpga::internal
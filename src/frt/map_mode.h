@@ -0,0 +1,18 @@
+#ifndef FPGA_RUNTIME_MAP_MODE_H_
+#define FPGA_RUNTIME_MAP_MODE_H_
+
+namespace fpga {
+
+// How the host accesses a buffer mapped with `Instance::Map`.
+enum class MapMode {
+  // Reads the contents on the device.
+  kRead,
+  // Overwrites the mapped range; its previous contents are undefined.
+  kWrite,
+  // Reads the contents on the device and modifies them.
+  kReadWrite,
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_MAP_MODE_H_
@@ -0,0 +1,140 @@
+#include "frt/mapped_file.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+// Returns an address aligned to `kHugePageSize` with `size` bytes of address
+// space reserved after it.
+void* ReserveAligned(size_t size) {
+  const size_t reserved_size = size + kHugePageSize;
+  void* reserved = mmap(nullptr, reserved_size, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                        /*fd=*/-1, /*offset=*/0);
+  if (reserved == MAP_FAILED) return nullptr;
+  char* begin = static_cast<char*>(reserved);
+  char* end = begin + reserved_size;
+  char* aligned = reinterpret_cast<char*>(
+      (reinterpret_cast<uintptr_t>(begin) + kHugePageSize - 1) /
+      kHugePageSize * kHugePageSize);
+  if (aligned != begin) {
+    munmap(begin, aligned - begin);
+  }
+  if (aligned + size != end) {
+    munmap(aligned + size, end - (aligned + size));
+  }
+  return aligned;
+}
+
+}  // namespace
+
+FileMapping FileMapping::Open(const std::string& path,
+                              const MappedFileOptions& options) {
+  return FileMapping(path, /*size=*/0, /*writable=*/false, options);
+}
+
+FileMapping FileMapping::Create(const std::string& path, size_t size,
+                                const MappedFileOptions& options) {
+  return FileMapping(path, size, /*writable=*/true, options);
+}
+
+FileMapping::FileMapping(const std::string& path, size_t size, bool writable,
+                         const MappedFileOptions& options)
+    : path_(path), writable_(writable) {
+  const int fd =
+      writable
+          ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)
+          : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  LOG_IF(FATAL, fd < 0) << "Cannot open '" << path
+                        << "': " << strerror(errno);
+  if (writable) {
+    LOG_IF(FATAL, ftruncate(fd, size) != 0)
+        << "Cannot resize '" << path << "' to " << size
+        << " bytes: " << strerror(errno);
+  } else {
+    struct stat stat_buf;
+    LOG_IF(FATAL, fstat(fd, &stat_buf) != 0)
+        << "Cannot stat '" << path << "': " << strerror(errno);
+    size = stat_buf.st_size;
+  }
+  size_ = size;
+
+  if (size > 0) {
+    void* addr = nullptr;
+    int flags = writable ? MAP_SHARED : MAP_PRIVATE;
+    if (options.populate) {
+      flags |= MAP_POPULATE;
+    }
+    if (options.huge_page_aligned &&
+        (addr = ReserveAligned(size)) != nullptr) {
+      flags |= MAP_FIXED;
+    }
+    ptr_ = mmap(addr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                flags, fd, /*offset=*/0);
+    LOG_IF(FATAL, ptr_ == MAP_FAILED)
+        << "Cannot mmap '" << path << "': " << strerror(errno);
+    if (options.huge_page_aligned && madvise(ptr_, size, MADV_HUGEPAGE) != 0) {
+      VLOG(1) << "Cannot use huge pages for '" << path
+              << "': " << strerror(errno);
+    }
+    if (options.readahead) {
+      madvise(ptr_, size, MADV_SEQUENTIAL);
+      if (!writable) {
+        madvise(ptr_, size, MADV_WILLNEED);
+      }
+    }
+  }
+  close(fd);
+}
+
+FileMapping::FileMapping(FileMapping&& other) noexcept
+    : path_(std::move(other.path_)),
+      ptr_(std::exchange(other.ptr_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      writable_(other.writable_) {}
+
+FileMapping& FileMapping::operator=(FileMapping&& other) noexcept {
+  if (this != &other) {
+    if (ptr_ != nullptr) {
+      munmap(ptr_, size_);
+    }
+    path_ = std::move(other.path_);
+    ptr_ = std::exchange(other.ptr_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    writable_ = other.writable_;
+  }
+  return *this;
+}
+
+FileMapping::~FileMapping() {
+  if (ptr_ != nullptr) {
+    munmap(ptr_, size_);
+  }
+}
+
+void FileMapping::Sync() const {
+  if (writable_ && ptr_ != nullptr) {
+    LOG_IF(ERROR, msync(ptr_, size_, MS_SYNC) != 0)
+        << "Cannot sync '" << path_ << "': " << strerror(errno);
+  }
+}
+
+}  // namespace internal
+}  // namespace fpga
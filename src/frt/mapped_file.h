@@ -0,0 +1,121 @@
+#ifndef FPGA_RUNTIME_MAPPED_FILE_H_
+#define FPGA_RUNTIME_MAPPED_FILE_H_
+
+#include <cstddef>
+
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
+
+namespace fpga {
+
+struct MappedFileOptions {
+  // Faults in all pages when mapping, so that reading the file from disk does
+  // not happen during the first transfer.
+  bool populate = false;
+  // Tells the kernel that the file is accessed sequentially and, for files
+  // opened with `Open`, starts reading it ahead in the background.
+  bool readahead = true;
+  // Aligns the mapping to a 2 MiB huge page and asks for huge pages where the
+  // file system supports them.
+  bool huge_page_aligned = false;
+};
+
+namespace internal {
+
+// Owns a memory mapping of a whole file.
+class FileMapping {
+ public:
+  // Maps `path` read-only. Writes through the mapping are not allowed.
+  static FileMapping Open(const std::string& path,
+                          const MappedFileOptions& options);
+
+  // Creates `path` with `size` bytes, replacing any existing file, and maps it
+  // shared and writable, so that writes land in the file.
+  static FileMapping Create(const std::string& path, size_t size,
+                            const MappedFileOptions& options);
+
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+  FileMapping(FileMapping&& other) noexcept;
+  FileMapping& operator=(FileMapping&& other) noexcept;
+  ~FileMapping();
+
+  void* Get() const { return ptr_; }
+  size_t Size() const { return size_; }
+  bool IsWritable() const { return writable_; }
+
+  // Writes modified pages back to the file, blocking until done.
+  void Sync() const;
+
+ private:
+  FileMapping(const std::string& path, size_t size, bool writable,
+              const MappedFileOptions& options);
+
+  std::string path_;
+  void* ptr_ = nullptr;
+  size_t size_ = 0;
+  bool writable_ = false;
+};
+
+}  // namespace internal
+
+// An array of `T` backed by a memory-mapped file, which can be passed to
+// `Instance::SetArg` directly, e.g.,
+//
+//   auto input = fpga::MappedFile<float>::Open("input.bin");
+//   auto output = fpga::MappedFile<float>::Create("output.bin", n);
+//   fpga::Invoke(bitstream, input, output, n);
+//
+// A file opened with `Open` is written to the device like `fpga::WriteOnly`,
+// and a file created with `Create` is read back into the file like
+// `fpga::ReadOnly`, so results land in it without an extra copy. Mappings are
+// page-aligned, so they are transferred without a copy where the backend
+// supports it.
+template <typename T>
+class MappedFile {
+ public:
+  // Maps all elements of an existing file read-only. The file size must be a
+  // multiple of `sizeof(T)`.
+  static MappedFile Open(const std::string& path,
+                         const MappedFileOptions& options = {}) {
+    auto mapping = internal::FileMapping::Open(path, options);
+    LOG_IF(FATAL, mapping.Size() % sizeof(T) != 0)
+        << "Size of '" << path << "' (" << mapping.Size()
+        << " bytes) is not a multiple of " << sizeof(T) << " bytes";
+    return MappedFile(std::move(mapping));
+  }
+
+  // Creates a file of `n` elements and maps it writable.
+  static MappedFile Create(const std::string& path, size_t n,
+                           const MappedFileOptions& options = {}) {
+    return MappedFile(
+        internal::FileMapping::Create(path, n * sizeof(T), options));
+  }
+
+  // Returns the elements. Those of a file opened with `Open` must not be
+  // modified.
+  T* data() const { return static_cast<T*>(mapping_.Get()); }
+  size_t size() const { return mapping_.Size() / sizeof(T); }
+  T* begin() const { return data(); }
+  T* end() const { return data() + size(); }
+  T& operator[](size_t i) const { return data()[i]; }
+
+  // Returns whether the file was created with `Create`.
+  bool IsWritable() const { return mapping_.IsWritable(); }
+
+  // Writes modified elements back to the file, blocking until done. Otherwise
+  // the kernel writes them back eventually, even after the file is unmapped.
+  void Sync() const { mapping_.Sync(); }
+
+ private:
+  explicit MappedFile(internal::FileMapping mapping)
+      : mapping_(std::move(mapping)) {}
+
+  internal::FileMapping mapping_;
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_MAPPED_FILE_H_
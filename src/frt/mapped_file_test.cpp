@@ -0,0 +1,59 @@
+#include "frt/mapped_file.h"
+
+#include <cstdint>
+
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace fpga {
+namespace {
+
+class MappedFileTest : public testing::Test {
+ protected:
+  void TearDown() override { unlink(path_.c_str()); }
+
+  const std::string path_ = testing::TempDir() + "/mapped_file_test.bin";
+};
+
+TEST_F(MappedFileTest, CreateWritesThroughToFile) {
+  MappedFileOptions options;
+  options.populate = true;
+  options.huge_page_aligned = true;
+
+  {
+    auto file = MappedFile<int>::Create(path_, 1000, options);
+    for (int i = 0; i < 1000; ++i) {
+      file[i] = i;
+    }
+    EXPECT_TRUE(file.IsWritable());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(file.data()) % (2 << 20), 0);
+    file.Sync();
+  }
+  auto file = MappedFile<int>::Open(path_);
+
+  EXPECT_FALSE(file.IsWritable());
+  ASSERT_EQ(file.size(), 1000);
+  EXPECT_EQ(file[999], 999);
+}
+
+TEST_F(MappedFileTest, OpenEmptyFile) {
+  std::ofstream(path_).close();
+
+  auto file = MappedFile<float>::Open(path_);
+
+  EXPECT_EQ(file.size(), 0);
+  EXPECT_EQ(file.begin(), file.end());
+}
+
+TEST_F(MappedFileTest, OpenRejectsPartialElements) {
+  std::ofstream(path_) << "abc";
+
+  EXPECT_DEATH(MappedFile<float>::Open(path_), "not a multiple of 4 bytes");
+}
+
+}  // namespace
+}  // namespace fpga
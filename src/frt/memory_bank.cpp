@@ -0,0 +1,28 @@
+#include "frt/memory_bank.h"
+
+#include <ostream>
+#include <vector>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const MemoryBank& bank) {
+  os << "MemoryBank: {index: " << bank.index << ", tag: '" << bank.tag
+     << "', type: '" << bank.type << "', base_address: 0x" << std::hex
+     << bank.base_address << std::dec << ", size: " << bank.size
+     << ", arg_indices: [";
+  for (size_t i = 0; i < bank.arg_indices.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << bank.arg_indices[i];
+  }
+  return os << "]}";
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<MemoryBank>& banks) {
+  os << "MemoryTopology: {";
+  for (size_t i = 0; i < banks.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << banks[i];
+  }
+  return os << "}";
+}
+
+}  // namespace fpga
@@ -0,0 +1,32 @@
+#ifndef FPGA_RUNTIME_MEMORY_BANK_H_
+#define FPGA_RUNTIME_MEMORY_BANK_H_
+
+#include <cstdint>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fpga {
+
+// A memory bank of the device, e.g., a DDR channel or an HBM pseudo-channel.
+struct MemoryBank {
+  // Index of the bank in the memory topology of the bitstream.
+  int index = 0;
+  // Name of the bank, e.g., "DDR[0]" or "HBM[31]".
+  std::string tag;
+  // Kind of memory, e.g., "DDR4" or "HBM".
+  std::string type;
+  uint64_t base_address = 0;
+  uint64_t size = 0;
+  // Indices of the buffer arguments connected to the bank, sorted.
+  std::vector<int> arg_indices;
+};
+
+std::ostream& operator<<(std::ostream& os, const MemoryBank& bank);
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<MemoryBank>& banks);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_MEMORY_BANK_H_
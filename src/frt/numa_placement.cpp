@@ -0,0 +1,17 @@
+#include "frt/numa_placement.h"
+
+#include <ostream>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const NumaPlacement& placement) {
+  os << "NumaPlacement: {bdf: '" << placement.bdf
+     << "', node: " << placement.node << ", cpus: [";
+  for (size_t i = 0; i < placement.cpus.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << placement.cpus[i];
+  }
+  return os << "], host_buffers_bound: "
+            << (placement.host_buffers_bound ? "true" : "false") << "}";
+}
+
+}  // namespace fpga
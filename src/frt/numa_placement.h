@@ -0,0 +1,27 @@
+#ifndef FPGA_RUNTIME_NUMA_PLACEMENT_H_
+#define FPGA_RUNTIME_NUMA_PLACEMENT_H_
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fpga {
+
+// Where host memory and threads are placed relative to the device.
+struct NumaPlacement {
+  // PCIe Bus:Device:Function of the device. Empty if unknown.
+  std::string bdf;
+  // NUMA node the device is attached to. -1 if unknown.
+  int node = -1;
+  // CPUs of `node`, sorted.
+  std::vector<int> cpus;
+  // Whether host buffers newly allocated by `fpga::AlignedAllocator` prefer
+  // `node`.
+  bool host_buffers_bound = false;
+};
+
+std::ostream& operator<<(std::ostream& os, const NumaPlacement& placement);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_NUMA_PLACEMENT_H_
@@ -0,0 +1,77 @@
+#include "frt/run.h"
+
+#include <cstdint>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace fpga {
+
+Run::Run(std::unique_ptr<internal::DeviceRun> run,
+         std::vector<std::shared_ptr<internal::SegmentedStorage>> scatters,
+         std::shared_ptr<int> runs_in_flight)
+    : run_(std::move(run)),
+      scatters_(std::move(scatters)),
+      runs_in_flight_(std::move(runs_in_flight)),
+      queue_depth_(++*runs_in_flight_) {}
+
+Run& Run::operator=(Run&& other) {
+  if (this != &other) {
+    Wait();
+    run_ = std::move(other.run_);
+    scatters_ = std::move(other.scatters_);
+    runs_in_flight_ = std::move(other.runs_in_flight_);
+    queue_depth_ = other.queue_depth_;
+    is_done_ = other.is_done_;
+  }
+  return *this;
+}
+
+Run::~Run() { Wait(); }
+
+void Run::Wait() {
+  // Moved-from runs have nothing to wait for.
+  if (run_ == nullptr || is_done_) return;
+  run_->Wait();
+  for (auto& storage : scatters_) {
+    storage->Scatter();
+  }
+  scatters_.clear();
+  --*runs_in_flight_;
+  is_done_ = true;
+}
+
+int64_t Run::LoadTimeNanoSeconds() {
+  return GetWaitedRun().LoadTimeNanoSeconds();
+}
+
+int64_t Run::ComputeTimeNanoSeconds() {
+  return GetWaitedRun().ComputeTimeNanoSeconds();
+}
+
+int64_t Run::StoreTimeNanoSeconds() {
+  return GetWaitedRun().StoreTimeNanoSeconds();
+}
+
+double Run::LoadThroughputGbps() {
+  const internal::DeviceRun& run = GetWaitedRun();
+  return static_cast<double>(run.LoadBytes()) /
+         static_cast<double>(run.LoadTimeNanoSeconds());
+}
+
+double Run::StoreThroughputGbps() {
+  const internal::DeviceRun& run = GetWaitedRun();
+  return static_cast<double>(run.StoreBytes()) /
+         static_cast<double>(run.StoreTimeNanoSeconds());
+}
+
+const internal::DeviceRun& Run::GetWaitedRun() {
+  LOG_IF(FATAL, run_ == nullptr) << "Cannot access a moved-from run";
+  Wait();
+  return *run_;
+}
+
+}  // namespace fpga
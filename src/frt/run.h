@@ -0,0 +1,88 @@
+#ifndef FPGA_RUNTIME_RUN_H_
+#define FPGA_RUNTIME_RUN_H_
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include "frt/device_run.h"
+#include "frt/segmented_buffer.h"
+
+namespace fpga {
+
+class Instance;
+
+// An invocation enqueued by `Instance::Launch`, which owns the commands and
+// times of that invocation only, so that several runs can be in flight on one
+// instance and waited for individually, e.g.,
+//
+//   std::deque<fpga::Run> runs;
+//   for (int i = 0; i < n; ++i) {
+//     if (runs.size() == depth) runs.pop_front();  // Waits for the oldest.
+//     runs.push_back(instance.Launch(fpga::WriteOnly(in[i], size),
+//                                    fpga::ReadOnly(out[i], size)));
+//   }
+//
+// Runs in flight must not share buffers, which may otherwise be overwritten
+// by later runs before earlier ones finish. Like the instance, runs are not
+// thread-safe. Runs may outlive the instance, which waits for them when
+// destroyed.
+class Run {
+ public:
+  Run(const Run&) = delete;
+  Run& operator=(const Run&) = delete;
+  Run(Run&&) = default;
+  // Waits for the run assigned to, like the destructor.
+  Run& operator=(Run&& other);
+  // Waits for the run if it has not been waited for.
+  ~Run();
+
+  // Blocks until the run finishes and its results are in host memory,
+  // including segmented buffers. Returns immediately if already waited for.
+  void Wait();
+
+  // Returns the number of runs of the instance in flight when this one was
+  // launched, including itself.
+  int QueueDepth() const { return queue_depth_; }
+
+  // The following wait for the run first, and must not be called on moved-from
+  // runs.
+
+  // Returns the load time in nanoseconds.
+  int64_t LoadTimeNanoSeconds();
+
+  // Returns the compute time in nanoseconds.
+  int64_t ComputeTimeNanoSeconds();
+
+  // Returns the store time in nanoseconds.
+  int64_t StoreTimeNanoSeconds();
+
+  // Returns the load throughput in GB/s.
+  double LoadThroughputGbps();
+
+  // Returns the store throughput in GB/s.
+  double StoreThroughputGbps();
+
+ private:
+  friend class Instance;
+
+  Run(std::unique_ptr<internal::DeviceRun> run,
+      std::vector<std::shared_ptr<internal::SegmentedStorage>> scatters,
+      std::shared_ptr<int> runs_in_flight);
+
+  // Waits for the run and returns it. Fails if the run has been moved from.
+  const internal::DeviceRun& GetWaitedRun();
+
+  std::unique_ptr<internal::DeviceRun> run_;
+  // Segmented buffers unpacked by `Wait`.
+  std::vector<std::shared_ptr<internal::SegmentedStorage>> scatters_;
+  // Runs of the instance in flight, shared with it.
+  std::shared_ptr<int> runs_in_flight_;
+  int queue_depth_ = 0;
+  bool is_done_ = false;
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_RUN_H_
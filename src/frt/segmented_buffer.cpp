@@ -0,0 +1,60 @@
+#include "frt/segmented_buffer.h"
+
+#include <cstddef>
+
+#include <utility>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "frt/devices/parallel_copy.h"
+
+DEFINE_int32(segmented_buffer_threads, 4,
+             "number of threads packing and unpacking segmented buffer "
+             "arguments created with fpga::Gather and fpga::Scatter");
+
+namespace fpga {
+namespace internal {
+
+namespace {
+
+ParallelCopier& GetCopier() {
+  static auto* copier = new ParallelCopier(FLAGS_segmented_buffer_threads);
+  return *copier;
+}
+
+}  // namespace
+
+SegmentedStorage::SegmentedStorage(Tag tag, std::vector<Segment> segments)
+    : tag_(tag), segments_(std::move(segments)) {
+  offsets_.reserve(segments_.size());
+  size_t size = 0;
+  for (const Segment& segment : segments_) {
+    offsets_.push_back(size);
+    size += segment.size;
+  }
+  packed_.resize(size);
+}
+
+void SegmentedStorage::Gather() {
+  std::vector<ParallelCopier::Range> ranges;
+  ranges.reserve(segments_.size());
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    ranges.push_back(
+        {packed_.data() + offsets_[i], segments_[i].ptr, segments_[i].size});
+  }
+  GetCopier().Copy(ranges);
+}
+
+void SegmentedStorage::Scatter() {
+  std::vector<ParallelCopier::Range> ranges;
+  ranges.reserve(segments_.size());
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    ranges.push_back(
+        {segments_[i].ptr, packed_.data() + offsets_[i], segments_[i].size});
+  }
+  GetCopier().Copy(ranges);
+}
+
+}  // namespace internal
+}  // namespace fpga
@@ -0,0 +1,140 @@
+#ifndef FPGA_RUNTIME_SEGMENTED_BUFFER_H_
+#define FPGA_RUNTIME_SEGMENTED_BUFFER_H_
+
+#include <cstddef>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "frt/aligned_allocator.h"
+#include "frt/span.h"
+#include "frt/tag.h"
+
+namespace fpga {
+
+class Instance;
+
+namespace internal {
+
+// Separately allocated segments of host memory and the page-aligned buffer
+// they are packed into back to back.
+class SegmentedStorage {
+ public:
+  struct Segment {
+    char* ptr;
+    size_t size;
+  };
+
+  SegmentedStorage(Tag tag, std::vector<Segment> segments);
+
+  Tag GetTag() const { return tag_; }
+  char* Get() { return packed_.data(); }
+  size_t SizeInBytes() const { return packed_.size(); }
+  // Returns the offset in bytes of segment `i` in the packed buffer.
+  size_t SegmentOffset(size_t i) const { return offsets_.at(i); }
+
+  // Copies all segments into the packed buffer in parallel.
+  void Gather();
+  // Copies the packed buffer back into all segments in parallel.
+  void Scatter();
+
+ private:
+  const Tag tag_;
+  const std::vector<Segment> segments_;
+  std::vector<size_t> offsets_;
+  std::vector<char, AlignedAllocator<char>> packed_;
+};
+
+}  // namespace internal
+
+// A buffer argument assembled from separately allocated segments, e.g.,
+// records or the rows of a `std::vector<std::vector<T>>`, which the kernel sees
+// back to back in one buffer, e.g.,
+//
+//   std::vector<std::vector<float>> rows = ...;
+//   instance.Invoke(fpga::Gather(rows), ...);
+//
+// The runtime packs the segments of `fpga::Gather` on several threads by
+// `WriteToDevice`, and unpacks the results of `fpga::Scatter` into its
+// segments by the `Finish` after `ReadFromDevice`, so that there is no copy
+// on the user side. Copies are cheap handles sharing the packed buffer; reuse
+// one across invocations so that the device buffer is reused as well.
+template <typename T, internal::Tag tag>
+class SegmentedBuffer {
+ public:
+  explicit SegmentedBuffer(const std::vector<Span<T>>& segments) {
+    std::vector<internal::SegmentedStorage::Segment> byte_segments;
+    byte_segments.reserve(segments.size());
+    for (const Span<T>& segment : segments) {
+      byte_segments.push_back(
+          {const_cast<char*>(reinterpret_cast<const char*>(segment.data())),
+           segment.size_bytes()});
+    }
+    storage_ = std::make_shared<internal::SegmentedStorage>(
+        tag, std::move(byte_segments));
+  }
+
+  // Returns the total number of elements of all segments.
+  size_t Size() const { return storage_->SizeInBytes() / sizeof(T); }
+
+  // Returns the index of the first element of segment `i` in the buffer that
+  // the kernel sees.
+  size_t SegmentOffset(size_t i) const {
+    return storage_->SegmentOffset(i) / sizeof(T);
+  }
+
+ private:
+  friend class Instance;
+
+  std::shared_ptr<internal::SegmentedStorage> storage_;
+};
+
+template <typename T>
+using GatherBuffer = SegmentedBuffer<T, internal::Tag::kWriteOnly>;
+template <typename T>
+using ScatterBuffer = SegmentedBuffer<T, internal::Tag::kReadOnly>;
+template <typename T>
+using GatherScatterBuffer = SegmentedBuffer<T, internal::Tag::kReadWrite>;
+
+// Writes `segments` to the device as one buffer, like `fpga::WriteOnly`.
+template <typename T>
+GatherBuffer<T> Gather(const std::vector<Span<T>>& segments) {
+  return GatherBuffer<T>(segments);
+}
+template <typename T, typename Allocator>
+GatherBuffer<const T> Gather(
+    const std::vector<std::vector<T, Allocator>>& segments) {
+  std::vector<Span<const T>> spans;
+  spans.reserve(segments.size());
+  for (const auto& segment : segments) {
+    spans.emplace_back(segment.data(), segment.size());
+  }
+  return GatherBuffer<const T>(spans);
+}
+
+// Reads one buffer back from the device into `segments`, like
+// `fpga::ReadOnly`.
+template <typename T>
+ScatterBuffer<T> Scatter(const std::vector<Span<T>>& segments) {
+  return ScatterBuffer<T>(segments);
+}
+template <typename T, typename Allocator>
+ScatterBuffer<T> Scatter(std::vector<std::vector<T, Allocator>>& segments) {
+  std::vector<Span<T>> spans;
+  spans.reserve(segments.size());
+  for (auto& segment : segments) {
+    spans.emplace_back(segment.data(), segment.size());
+  }
+  return ScatterBuffer<T>(spans);
+}
+
+// Writes `segments` to the device and reads them back, like `fpga::ReadWrite`.
+template <typename T>
+GatherScatterBuffer<T> GatherScatter(const std::vector<Span<T>>& segments) {
+  return GatherScatterBuffer<T>(segments);
+}
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_SEGMENTED_BUFFER_H_
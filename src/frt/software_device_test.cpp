@@ -0,0 +1,256 @@
+#include "frt/devices/software_device.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "frt.h"
+#include "frt/software_kernel.h"
+
+namespace fpga::internal {
+namespace {
+
+void VecAdd(const SoftwareKernelArgs& args) {
+  const auto* a = args.Buffer<const float>(0);
+  const auto* b = args.Buffer<const float>(1);
+  auto* c = args.Buffer<float>(2);
+  const auto n = args.Scalar<uint64_t>(3);
+  for (uint64_t i = 0; i < n; ++i) {
+    c[i] = a[i] + b[i];
+  }
+}
+FRT_REGISTER_SOFTWARE_KERNEL(VecAdd, &VecAdd);
+
+// Doubles every element of a transfer until the input ends.
+void Doubler(const SoftwareKernelArgs& args) {
+  auto& in = args.Stream(0);
+  auto& out = args.Stream(1);
+  for (int value; in.Read(value);) {
+    out.Write(value * 2);
+  }
+  out.Write(nullptr, 0, /*eot=*/true);
+}
+FRT_REGISTER_SOFTWARE_KERNEL(Doubler, &Doubler);
+
+constexpr std::string_view kVecAddManifest = R"({
+  "software_kernel": "VecAdd",
+  "args": [
+    {"name": "a", "type": "const float*", "cat": "mmap"},
+    {"name": "b", "type": "const float*", "cat": "mmap"},
+    {"name": "c", "type": "float*", "cat": "mmap"},
+    {"name": "n", "type": "uint64_t", "cat": "scalar"}
+  ],
+  "compute_latency_us": 2000
+})";
+
+constexpr std::string_view kDoublerManifest = R"({
+  "software_kernel": "Doubler",
+  "args": [
+    {"name": "in", "type": "int", "cat": "stream"},
+    {"name": "out", "type": "int", "cat": "stream"}
+  ]
+})";
+
+class SoftwareDeviceTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    for (const auto& path : paths_) {
+      unlink(path.c_str());
+    }
+  }
+
+  std::string WriteManifest(std::string_view content) {
+    std::string path = testing::TempDir() + "/software_device_test.XXXXXX" +
+                       std::string(SoftwareDevice::kManifestExtension);
+    close(mkstemps(&path[0], SoftwareDevice::kManifestExtension.size()));
+    std::ofstream(path).write(content.data(), content.size());
+    paths_.push_back(path);
+    return path;
+  }
+
+ private:
+  std::vector<std::string> paths_;
+};
+
+TEST_F(SoftwareDeviceTest, InvokeRunsRegisteredKernel) {
+  constexpr uint64_t kN = 1000;
+  std::vector<float> a(kN), b(kN), c(kN);
+  for (uint64_t i = 0; i < kN; ++i) {
+    a[i] = i;
+    b[i] = 2 * i;
+  }
+
+  auto instance = fpga::Invoke(WriteManifest(kVecAddManifest),
+                               fpga::WriteOnly(a.data(), kN),
+                               fpga::WriteOnly(b.data(), kN),
+                               fpga::ReadOnly(c.data(), kN), kN);
+
+  for (uint64_t i = 0; i < kN; ++i) {
+    ASSERT_EQ(c[i], 3 * i) << "i = " << i;
+  }
+  EXPECT_EQ(instance.GetArgsInfo().size(), 4);
+  EXPECT_EQ(instance.GetArgsInfo()[2].name, "c");
+  EXPECT_GE(instance.ComputeTimeNanoSeconds(), 2000000);
+}
+
+TEST_F(SoftwareDeviceTest, SlicesOnlyTransferActiveRange) {
+  constexpr uint64_t kN = 8;
+  std::vector<float> a(kN, 1), b(kN, 2), c(kN, -1);
+
+  fpga::Invoke(WriteManifest(kVecAddManifest),
+               fpga::WriteOnly(a.data(), kN).Slice(0, 4),
+               fpga::WriteOnly(b.data(), kN).Slice(0, 4),
+               fpga::ReadOnly(c.data(), kN).Slice(2, 2), kN);
+
+  // Only the first 4 elements of `a` and `b` are loaded, so the rest are 0.
+  EXPECT_EQ(c, std::vector<float>({-1, -1, 3, 3, -1, -1, -1, -1}));
+}
+
+TEST_F(SoftwareDeviceTest, DeviceBuffersStayOnDevice) {
+  constexpr uint64_t kN = 4;
+  const std::vector<float> a = {1, 2, 3, 4};
+  std::vector<float> b(kN), c(kN);
+  fpga::Instance instance(WriteManifest(kVecAddManifest));
+  auto sum = instance.CreateDeviceBuffer<float>(kN);
+
+  // sum = a + a; c = sum + a.
+  instance.Invoke(fpga::WriteOnly(a.data(), kN), fpga::WriteOnly(a.data(), kN),
+                  sum, kN);
+  instance.Invoke(sum, fpga::WriteOnly(a.data(), kN),
+                  fpga::ReadOnly(c.data(), kN), kN);
+  instance.ReadDeviceBuffer(sum, b.data());
+
+  EXPECT_EQ(b, std::vector<float>({2, 4, 6, 8}));
+  EXPECT_EQ(c, std::vector<float>({3, 6, 9, 12}));
+}
+
+TEST_F(SoftwareDeviceTest, MappedFilesAreTransferredDirectly) {
+  constexpr uint64_t kN = 4;
+  const std::vector<float> a = {1, 2, 3, 4};
+  const std::string a_path = testing::TempDir() + "/software_device_test.a";
+  const std::string c_path = testing::TempDir() + "/software_device_test.c";
+  std::ofstream(a_path, std::ios::binary)
+      .write(reinterpret_cast<const char*>(a.data()), kN * sizeof(float));
+
+  {
+    auto input = fpga::MappedFile<float>::Open(a_path);
+    auto output = fpga::MappedFile<float>::Create(c_path, kN);
+    fpga::Invoke(WriteManifest(kVecAddManifest), input, input, output, kN);
+  }
+  std::vector<float> c(kN);
+  std::ifstream(c_path, std::ios::binary)
+      .read(reinterpret_cast<char*>(c.data()), kN * sizeof(float));
+  unlink(a_path.c_str());
+  unlink(c_path.c_str());
+
+  EXPECT_EQ(c, std::vector<float>({2, 4, 6, 8}));
+}
+
+TEST_F(SoftwareDeviceTest, MapAccessesDeviceMemoryInPlace) {
+  constexpr uint64_t kN = 4;
+  const std::vector<float> a = {1, 2, 3, 4};
+  std::vector<float> c(kN);
+  fpga::Instance instance(WriteManifest(kVecAddManifest));
+  instance.Invoke(fpga::WriteOnly(a.data(), kN), fpga::WriteOnly(a.data(), kN),
+                  fpga::ReadOnly(c.data(), kN), kN);
+
+  // c = a + a on the device; update its tail and read it back in place.
+  auto span = instance.Map<float>(2, 2, 2, MapMode::kReadWrite);
+  ASSERT_EQ(span.size(), 2);
+  EXPECT_EQ(span[0], 6);
+  span[1] = 0;
+  instance.Unmap(2, span);
+  span = instance.Map<float>(2, 0, kN, MapMode::kRead);
+  const std::vector<float> mapped(span.begin(), span.end());
+  instance.Unmap(2, span);
+
+  EXPECT_EQ(mapped, std::vector<float>({2, 4, 6, 0}));
+  EXPECT_DEATH(instance.Map<float>(2, 2, kN, MapMode::kRead), "Cannot map");
+}
+
+TEST_F(SoftwareDeviceTest, SegmentedBuffersAreGatheredAndScattered) {
+  constexpr uint64_t kN = 6;
+  const std::vector<std::vector<float>> a = {{1, 2}, {}, {3, 4, 5, 6}};
+  const std::vector<float> b(kN, 10);
+  std::vector<std::vector<float>> c = {{0}, {0, 0, 0}, {0, 0}};
+  fpga::Instance instance(WriteManifest(kVecAddManifest));
+  auto gathered = fpga::Gather(a);
+  auto scattered = fpga::Scatter(c);
+  ASSERT_EQ(gathered.Size(), kN);
+  EXPECT_EQ(gathered.SegmentOffset(2), 2);
+
+  instance.Invoke(gathered, fpga::WriteOnly(b.data(), kN), scattered, kN);
+
+  EXPECT_EQ(c, std::vector<std::vector<float>>({{11}, {12, 13, 14}, {15, 16}}));
+}
+
+TEST_F(SoftwareDeviceTest, LaunchedRunsAreWaitedForIndividually) {
+  constexpr uint64_t kN = 4;
+  constexpr int kRunCount = 3;
+  std::vector<std::vector<float>> a(kRunCount), b(kRunCount), c(kRunCount);
+  for (int i = 0; i < kRunCount; ++i) {
+    a[i].assign(kN, i);
+    b[i].assign(kN, 10);
+    c[i].assign(kN, -1);
+  }
+  fpga::Instance instance(WriteManifest(kVecAddManifest));
+
+  std::vector<fpga::Run> runs;
+  for (int i = 0; i < kRunCount; ++i) {
+    runs.push_back(instance.Launch(fpga::WriteOnly(a[i].data(), kN),
+                                   fpga::WriteOnly(b[i].data(), kN),
+                                   fpga::ReadOnly(c[i].data(), kN), kN));
+    EXPECT_EQ(runs.back().QueueDepth(), i + 1);
+  }
+  EXPECT_EQ(instance.RunsInFlight(), kRunCount);
+  runs[1].Wait();
+
+  EXPECT_EQ(c[1], std::vector<float>(kN, 11));
+  EXPECT_EQ(instance.RunsInFlight(), kRunCount - 1);
+  for (int i = 0; i < kRunCount; ++i) {
+    EXPECT_GE(runs[i].ComputeTimeNanoSeconds(), 2000000) << "i = " << i;
+    EXPECT_EQ(c[i], std::vector<float>(kN, i + 10)) << "i = " << i;
+  }
+  EXPECT_EQ(instance.RunsInFlight(), 0);
+}
+
+TEST_F(SoftwareDeviceTest, StreamsConnectHostAndKernel) {
+  const std::vector<int> input = {1, 2, 3, 4, 5};
+  std::vector<int> output(input.size());
+  fpga::WriteStream in("in");
+  fpga::ReadStream out("out");
+
+  fpga::Instance instance(WriteManifest(kDoublerManifest));
+  instance.Invoke(in, out);
+  in.Write(input.data(), input.size());
+  out.Read(output.data(), output.size());
+  instance.Finish();
+
+  EXPECT_EQ(output, std::vector<int>({2, 4, 6, 8, 10}));
+}
+
+TEST_F(SoftwareDeviceTest, NewDeclinesOtherJson) {
+  Bitstream bitstream(WriteManifest(R"({"kernel": "VecAdd"})"));
+
+  EXPECT_EQ(SoftwareDevice::New(bitstream), nullptr);
+}
+
+TEST_F(SoftwareDeviceTest, SetArgWithWrongCategoryFails) {
+  const std::string path = WriteManifest(kVecAddManifest);
+
+  EXPECT_DEATH(
+      fpga::Instance(path).SetArg(3, fpga::WriteOnly<float>(nullptr, 0)),
+      "Cannot set argument 'n' as a");
+}
+
+}  // namespace
+}  // namespace fpga::internal
@@ -0,0 +1,101 @@
+#ifndef FPGA_RUNTIME_SOFTWARE_KERNEL_H_
+#define FPGA_RUNTIME_SOFTWARE_KERNEL_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include <functional>
+#include <string>
+
+namespace fpga {
+
+// Kernel side of a stream argument of a software kernel.
+class SoftwareStream {
+ public:
+  virtual ~SoftwareStream() = default;
+
+  // Reads `size` bytes into `ptr`, blocking until they are available or the
+  // host ends the transfer. Returns the number of bytes read, which is less
+  // than `size` only at the end of a transfer.
+  virtual size_t Read(void* ptr, size_t size) = 0;
+
+  // Writes `size` bytes from `ptr`. If `eot` is set, ends the transfer.
+  virtual void Write(const void* ptr, size_t size, bool eot) = 0;
+
+  // Reads one element. Returns false at the end of a transfer.
+  template <typename T>
+  bool Read(T& value) {
+    return Read(&value, sizeof(value)) == sizeof(value);
+  }
+
+  // Writes one element.
+  template <typename T>
+  void Write(const T& value, bool eot = false) {
+    Write(&value, sizeof(value), eot);
+  }
+};
+
+// Arguments of a software kernel, indexed as in its manifest.
+class SoftwareKernelArgs {
+ public:
+  virtual ~SoftwareKernelArgs() = default;
+
+  // Returns scalar argument `index`, which must be set with the same size.
+  template <typename T>
+  T Scalar(int index) const {
+    T value;
+    memcpy(&value, GetScalar(index, sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  // Returns the device copy of buffer argument `index`.
+  template <typename T>
+  T* Buffer(int index) const {
+    return static_cast<T*>(GetBuffer(index));
+  }
+
+  // Returns the size of buffer argument `index` in bytes.
+  virtual size_t BufferSize(int index) const = 0;
+
+  // Returns stream argument `index`.
+  virtual SoftwareStream& Stream(int index) const = 0;
+
+ protected:
+  virtual const void* GetScalar(int index, size_t size) const = 0;
+  virtual void* GetBuffer(int index) const = 0;
+};
+
+using SoftwareKernel = std::function<void(const SoftwareKernelArgs& args)>;
+
+// Registers `kernel` as `name` for manifests loaded by the software device.
+// Returns true so that it can initialize a static.
+bool RegisterSoftwareKernel(const std::string& name, SoftwareKernel kernel);
+
+}  // namespace fpga
+
+// Registers a software kernel from its own translation unit, e.g.,
+//
+//   void VecAdd(const fpga::SoftwareKernelArgs& args) { ... }
+//   FRT_REGISTER_SOFTWARE_KERNEL(VecAdd, &VecAdd);
+//
+// The software device runs it for manifests such as `vadd.json`:
+//
+//   {
+//     "software_kernel": "VecAdd",
+//     "args": [
+//       {"name": "a", "type": "const float*", "cat": "mmap"},
+//       {"name": "b", "type": "const float*", "cat": "mmap"},
+//       {"name": "c", "type": "float*", "cat": "mmap"},
+//       {"name": "n", "type": "uint64_t", "cat": "scalar"}
+//     ],
+//     "bandwidth_gbps": 10,
+//     "compute_latency_us": 100
+//   }
+//
+// `bandwidth_gbps` and `compute_latency_us` are optional and simulate the
+// transfer bandwidth and the minimum compute time, respectively.
+#define FRT_REGISTER_SOFTWARE_KERNEL(name, kernel)                       \
+  static const bool frt_software_kernel_##name [[maybe_unused]] =        \
+      ::fpga::RegisterSoftwareKernel(#name, (kernel))
+
+#endif  // FPGA_RUNTIME_SOFTWARE_KERNEL_H_
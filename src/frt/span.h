@@ -0,0 +1,31 @@
+#ifndef FPGA_RUNTIME_SPAN_H_
+#define FPGA_RUNTIME_SPAN_H_
+
+#include <cstddef>
+
+namespace fpga {
+
+// A view of `size()` contiguous elements of `T` owned elsewhere, like
+// `std::span` in C++20.
+template <typename T>
+class Span {
+ public:
+  Span() = default;
+  Span(T* data, size_t size) : data_(data), size_(size) {}
+
+  T* data() const { return data_; }
+  size_t size() const { return size_; }
+  size_t size_bytes() const { return size_ * sizeof(T); }
+  bool empty() const { return size_ == 0; }
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+  T& operator[](size_t i) const { return data_[i]; }
+
+ private:
+  T* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_SPAN_H_
@@ -0,0 +1,21 @@
+#include "frt/startup_phase.h"
+
+#include <ostream>
+#include <vector>
+
+namespace fpga {
+
+std::ostream& operator<<(std::ostream& os, const StartupPhase& phase) {
+  return os << phase.name << ": " << phase.nanoseconds * 1e-9 << " s";
+}
+
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<StartupPhase>& phases) {
+  os << "StartupPhases: {";
+  for (size_t i = 0; i < phases.size(); ++i) {
+    os << (i == 0 ? "" : ", ") << phases[i];
+  }
+  return os << "}";
+}
+
+}  // namespace fpga
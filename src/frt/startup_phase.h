@@ -0,0 +1,25 @@
+#ifndef FPGA_RUNTIME_STARTUP_PHASE_H_
+#define FPGA_RUNTIME_STARTUP_PHASE_H_
+
+#include <cstdint>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace fpga {
+
+// Wall time spent in one phase of loading a bitstream, e.g., "metadata" or
+// "program".
+struct StartupPhase {
+  std::string name;
+  int64_t nanoseconds = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const StartupPhase& phase);
+std::ostream& operator<<(std::ostream& os,
+                         const std::vector<StartupPhase>& phases);
+
+}  // namespace fpga
+
+#endif  // FPGA_RUNTIME_STARTUP_PHASE_H_
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <thread>
+#include <vector>
 
 #include "frt.h"
 
@@ -14,10 +15,8 @@ int main(int argc, char* argv[]) {
     return 1;
   }
   uint64_t n = (atoi(argv[2]) / 1024 + 1) * 1024;
-  auto a = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto b = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto c = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto c_base = new float[n];
+  std::vector<float, fpga::AlignedAllocator<float>> a(n), b(n), c(n);
+  std::vector<float> c_base(n);
   for (int i = 0; i < n; ++i) {
     a[i] = i * i % 10;
     b[i] = i * i % 9;
@@ -32,17 +31,20 @@ int main(int argc, char* argv[]) {
   const uint64_t kBatchSize = 1ULL << 29;
   auto t1 = std::thread([&]() {
     for (uint64_t i = 0; i < n; i += kBatchSize) {
-      a_stream.Write(a + i, std::min(kBatchSize, n - i), !(i + kBatchSize < n));
+      a_stream.Write(a.data() + i, std::min(kBatchSize, n - i),
+                     !(i + kBatchSize < n));
     }
   });
   auto t2 = std::thread([&]() {
     for (uint64_t i = 0; i < n; i += kBatchSize) {
-      b_stream.Write(b + i, std::min(kBatchSize, n - i), !(i + kBatchSize < n));
+      b_stream.Write(b.data() + i, std::min(kBatchSize, n - i),
+                     !(i + kBatchSize < n));
     }
   });
   auto t3 = std::thread([&]() {
     for (uint64_t i = 0; i < n; i += kBatchSize) {
-      c_stream.Read(c + i, std::min(kBatchSize, n - i), !(i + kBatchSize < n));
+      c_stream.Read(c.data() + i, std::min(kBatchSize, n - i),
+                    !(i + kBatchSize < n));
     }
   });
   t1.join();
@@ -58,9 +60,5 @@ int main(int argc, char* argv[]) {
     }
   }
   clog << "PASS!" << endl;
-  free(a);
-  free(b);
-  free(c);
-  delete[] c_base;
   return 0;
 }
@@ -1,6 +1,7 @@
 #include <cstdlib>
 
 #include <iostream>
+#include <vector>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -22,25 +23,25 @@ int main(int argc, char* argv[]) {
     return 1;
   }
   uint64_t n = (atoi(argv[2]) / 1024 + 1) * 1024;
-  auto a = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto b = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto c = reinterpret_cast<float*>(aligned_alloc(4096, sizeof(float) * n));
-  auto c_base = new float[n];
+  std::vector<float, fpga::AlignedAllocator<float>> a(n), b(n), c(n);
+  std::vector<float> c_base(n);
   for (int i = 0; i < n; ++i) {
     a[i] = i * i % 10;
     b[i] = i * i % 9;
     c[i] = -1;
     c_base[i] = 1;
   }
-  auto instance = fpga::Invoke(argv[1], fpga::WriteOnly(a, n),
-                               fpga::WriteOnly(b, n), fpga::ReadOnly(c, n), n);
+  auto instance = fpga::Invoke(argv[1], fpga::WriteOnly(a.data(), n),
+                               fpga::WriteOnly(b.data(), n),
+                               fpga::ReadOnly(c.data(), n), n);
   for (const auto& arg : instance.GetArgsInfo()) {
     clog << arg << "\n";
   }
+  clog << instance.GetBuffersInfo() << "\n";
   clog << "Load throughput: " << instance.LoadThroughputGbps() << " GB/s\n";
   clog << "Compute latency: " << instance.ComputeTimeSeconds() << " s" << endl;
   clog << "Store throughput: " << instance.StoreThroughputGbps() << " GB/s\n";
-  VecAdd(a, b, c_base, n);
+  VecAdd(a.data(), b.data(), c_base.data(), n);
   for (int i = 0; i < n; ++i) {
     if (c[i] != c_base[i]) {
       clog << "FAIL: " << c[i] << " != " << c_base[i] << endl;
@@ -48,9 +49,5 @@ int main(int argc, char* argv[]) {
     }
   }
   clog << "PASS!" << endl;
-  free(a);
-  free(b);
-  free(c);
-  delete[] c_base;
   return 0;
 }
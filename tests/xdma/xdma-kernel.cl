@@ -0,0 +1,8 @@
+// OpenCL C version of `VecAdd` in `xdma-kernel.cpp` for the generic OpenCL
+// device, e.g., PoCL on the CPU. It runs as a single work-item.
+__kernel void VecAdd(__global const float* a, __global const float* b,
+                     __global float* c, ulong n) {
+  for (ulong i = 0; i < n; ++i) {
+    c[i] = a[i] + b[i];
+  }
+}